@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
 
 #include <glow-extras/timing/PerformanceTimer.hh>
 #include <glow/common/log.hh>
@@ -12,6 +14,128 @@
 
 static glow::timing::SystemTimer sWallClock;
 
+void ai::BallPrediction::reset(std::vector<Paddle> const& allPaddles, size_t ballCount, Parameters const& params)
+{
+    auto center = params.fieldWidth / 2.0f;
+
+    // paddle faces and goal lines
+    lines.clear();
+    auto addLine = [&](float x) {
+        if (lineIndex(x) < 0)
+            lines.push_back(x);
+    };
+    for (auto const& p : allPaddles)
+        addLine(p.transform->position.x + p.shape->halfExtent.x * glm::sign(center - p.transform->position.x));
+    addLine(0.0f);
+    addLine(params.fieldWidth);
+
+    // intercepts are predicted on demand
+    this->ballCount = ballCount;
+    state.assign(lines.size() * ballCount, Unknown);
+    time.resize(lines.size() * ballCount);
+    y.resize(lines.size() * ballCount);
+}
+
+int ai::BallPrediction::lineIndex(float x) const
+{
+    for (auto i = 0u; i < lines.size(); ++i)
+        if (glm::abs(lines[i] - x) < 1e-3f)
+            return (int)i;
+    return -1;
+}
+
+bool ai::BallPrediction::intercept(
+    Ball const& ball, size_t ballIdx, float x, Parameters const& params, float elapsedSeconds, float* outY, float* outTime) const
+{
+    auto lineIdx = lineIndex(x);
+    if (lineIdx < 0 || ballIdx >= ballCount)
+        return predictBallIntercept(ball, x, params, elapsedSeconds, outY, outTime);
+
+    auto idx = lineIdx * ballCount + ballIdx;
+    if (state[idx] == Unknown)
+        state[idx] = predictBallIntercept(ball, x, params, elapsedSeconds, &y[idx], &time[idx]) ? Hit : Miss;
+
+    *outY = y[idx];
+    *outTime = time[idx];
+    return state[idx] == Hit;
+}
+
+bool ai::predictBallIntercept(Ball const& ball, float x, Parameters const& params, float elapsedSeconds, float* outY, float* outTime)
+{
+    auto radius = ball.shape->radius;
+    auto pos = ball.transform->position;
+    auto velocity = ball.transform->velocity;
+    auto center = params.fieldWidth / 2.0f;
+
+    auto noIntercept = [&] {
+        *outY = params.fieldHeight / 2.0f;
+        *outTime = std::numeric_limits<float>::infinity();
+        return false;
+    };
+
+    // without horizontal velocity, the ball never reaches the line
+    // (the time to the opposite line and the overshoot below would be inf)
+    if (glm::abs(velocity.x) < 1e-4f)
+        return noIntercept();
+
+    *outTime = 0.0f;
+
+    // ball moves away: reflect it at the opposite line first (linear)
+    if (glm::dot(velocity.x, pos.x - x) > 0)
+    {
+        auto dis = glm::abs(pos.x - (params.fieldWidth - x)) - radius;
+        auto t = dis / glm::abs(velocity.x);
+        pos += t * velocity;
+        *outTime += t;
+        velocity.x *= -1.0f;
+    }
+
+    // simulate ball (incl. acceleration and drag) until it reaches the line
+    // (bounded: with a tiny elapsedSeconds or a ball that is held back by drag, the line may never be reached)
+    *outY = pos.y;
+    auto vx = velocity.x;
+    auto vy = velocity.y;
+    auto px = pos.x;
+    auto target = x + radius * glm::sign(center - x);
+    auto steps = 0;
+    while (glm::dot(px - target, center - x) > 0)
+    {
+        if (++steps > MaxPredictionSteps)
+            return noIntercept();
+
+        auto ax = params.ballAcceleration * (vx > 0 ? 1.0f : -1.0f) - params.ballDrag * vx;
+        auto ay = -params.ballDrag * vy;
+        vx += ax * elapsedSeconds;
+        vy += ay * elapsedSeconds;
+        px += vx * elapsedSeconds;
+        *outTime += elapsedSeconds;
+        *outY += vy * elapsedSeconds;
+    }
+    if (glm::abs(vx) < 1e-4f)
+        return noIntercept();
+
+    // undo overshoot
+    auto overshoot = glm::abs(glm::abs(px - target) / vx);
+    *outTime -= overshoot;
+    *outY -= vy * overshoot;
+
+    // wall reflections (closed form: the reflected trajectory is periodic with 2 * (yMax - yMin))
+    auto yMin = radius;
+    auto yMax = params.fieldHeight - radius;
+    auto range = yMax - yMin;
+    if (range <= 0.0f)
+        *outY = params.fieldHeight / 2.0f;
+    else if (*outY < yMin || *outY > yMax)
+    {
+        auto t = std::fmod(*outY - yMin, 2.0f * range);
+        if (t < 0.0f)
+            t += 2.0f * range;
+        *outY = t <= range ? yMin + t : yMax - (t - range);
+    }
+
+    return std::isfinite(*outTime) && std::isfinite(*outY) ? true : noIntercept();
+}
+
 /// =========== OBFUSCATE START ============
 
 #define _53 auto
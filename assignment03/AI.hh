@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "Parameters.hh"
@@ -27,19 +28,76 @@ struct Paddle
     const BoxShapeComponent* const shape;
 };
 
+/**
+ * Per-tick cache of ball trajectory predictions (shared by all AIs)
+ *
+ * For every ball, the time and y-position at which it reaches a set of vertical lines
+ * (the faces of all paddles and both goal lines) is predicted at most once per tick.
+ * Intercepts are computed lazily on the first query, i.e. AIs that never query them pay nothing.
+ *
+ * Data is stored as SoA: time[lineIdx * ballCount + ballIdx]
+ */
+struct BallPrediction
+{
+    enum : uint8_t
+    {
+        Unknown, // not predicted yet
+        Hit,     // time and y are valid
+        Miss     // ball does not reach the line (see predictBallIntercept)
+    };
+
+    // x-coordinates of all predicted lines
+    std::vector<float> lines;
+    // number of balls per line
+    size_t ballCount = 0;
+
+    // state of each intercept (filled on demand)
+    mutable std::vector<uint8_t> state;
+    // time until the ball reaches the line (seconds)
+    mutable std::vector<float> time;
+    // y-position of the ball when reaching the line
+    mutable std::vector<float> y;
+
+    // Starts a new tick: sets up the lines (all paddle faces and goal lines) and forgets all intercepts
+    // O(lines * balls) without any simulation
+    void reset(std::vector<Paddle> const& allPaddles, size_t ballCount, Parameters const& params);
+
+    // Returns the index of the predicted line at x (or -1 if there is none)
+    int lineIndex(float x) const;
+
+    // Looks up (or predicts) the intercept of the ballIdx-th ball with the line at x
+    // Lines that are not cached are predicted on the fly
+    // Returns false if the ball does not reach the line (outTime is then +inf)
+    bool intercept(Ball const& ball, size_t ballIdx, float x, Parameters const& params, float elapsedSeconds, float* outY, float* outTime) const;
+};
+
+// upper bound of simulation steps per prediction
+static const int MaxPredictionSteps = 10000;
+
+// Predicts when and where a ball reaches the vertical line at x
+// (incl. ball acceleration, drag and wall reflections; if the ball moves away, it is reflected at the opposite line first)
+// The ball is simulated with a step size of elapsedSeconds for at most MaxPredictionSteps steps.
+// Returns false (outTime = +inf, outY = field center) if the ball has no horizontal velocity
+// or does not reach the line within these steps.
+bool predictBallIntercept(Ball const& ball, float x, Parameters const& params, float elapsedSeconds, float* outY, float* outTime);
+
 /**
  * @param paddleIdx   index of _7 on the current side (0, 1, 2, ...)
  * @param _7      the current _7
  * @param allPaddles  a list of all paddles (includes current and opponents)
  * @param balls       a list of all active balls (guaranteed to be non-empty)
  * @param params      a set of all transient and constant simulation parameters
+ * @param prediction  intercepts of all balls with all paddle faces (computed once per tick)
  * @return the new desired acceleration
+ *
+ * (normalAI and goodAI are the obfuscated reference AIs of AI.cc, they keep their own predictions)
  */
 float simpleAI(size_t paddleIdx,
                Paddle const& _7,
                std::vector<Paddle> const& allPaddles,
                std::vector<Ball> const& balls,
                Parameters const& params,
+               BallPrediction const& prediction,
                float elapsedSeconds,
                glm::vec3& debugColor);
 float normalAI(size_t paddleIdx,
@@ -62,6 +120,7 @@ float task2a(size_t paddleIdx,
              std::vector<Paddle> const& allPaddles,
              std::vector<Ball> const& balls,
              Parameters const& params,
+             BallPrediction const& prediction,
              float elapsedSeconds,
              glm::vec3& debugColor);
 float task2b(size_t paddleIdx,
@@ -69,6 +128,7 @@ float task2b(size_t paddleIdx,
              std::vector<Paddle> const& allPaddles,
              std::vector<Ball> const& balls,
              Parameters const& params,
+             BallPrediction const& prediction,
              float elapsedSeconds,
              glm::vec3& debugColor);
 float task2c(size_t paddleIdx,
@@ -76,6 +136,7 @@ float task2c(size_t paddleIdx,
              std::vector<Paddle> const& allPaddles,
              std::vector<Ball> const& balls,
              Parameters const& params,
+             BallPrediction const& prediction,
              float elapsedSeconds,
              glm::vec3& debugColor);
 float task3(size_t paddleIdx,
@@ -83,6 +144,7 @@ float task3(size_t paddleIdx,
             std::vector<Paddle> const& allPaddles,
             std::vector<Ball> const& balls,
             Parameters const& params,
+            BallPrediction const& prediction,
             float elapsedSeconds,
             glm::vec3& debugColor);
 }
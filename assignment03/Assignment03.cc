@@ -1,6 +1,8 @@
 #include "Assignment03.hh"
 
+#include <cstring>
 #include <ctime>
+#include <iostream>
 
 // OpenGL header
 #include <glow/gl.hh>
@@ -12,6 +14,7 @@
 // used OpenGL object wrappers
 #include <glow/objects/ArrayBuffer.hh>
 #include <glow/objects/Program.hh>
+#include <glow/objects/StreamBuffer.hh>
 #include <glow/objects/Texture2D.hh>
 #include <glow/objects/VertexArray.hh>
 
@@ -81,18 +84,8 @@ void Assignment03::setScenario(Scenario s)
         break;
     }
 
-    // clear all entities
-    mEntities.clear();
-
-    // clear all comps
-    mTransformComps.clear();
-    mShapeComps.clear();
-    mCollisionComps.clear();
-    mRegionDetectorComps.clear();
-    mRenderComps.clear();
-    mBallComps.clear();
-    mPaddleComps.clear();
-    mAIComps.clear();
+    // clear all entities and comps
+    destroyAllEntities();
 
     // init game again
     initGame();
@@ -117,34 +110,33 @@ void Assignment03::initGame()
         for (auto i = 0; i < pCnt; ++i)
         {
             const int paddleMargin = 30 + 25 * (pCnt - 1 - i);
-            auto paddle = std::make_shared<Entity>(player == Player::Left ? "Left Paddle" : "Right Paddle");
+            auto paddle = createEntity(player == Player::Left ? "Left Paddle" : "Right Paddle");
 
             auto tc = paddle->addComponent<TransformComponent>();
             tc->position = glm::vec2(player == Player::Left ? paddleMargin : mParams.fieldWidth - paddleMargin,
                                      mParams.fieldHeight * (i + 0.5f) / 4.0f);
-            mTransformComps.push_back(tc);
+            tc->previousPosition = tc->position;
+            mTransformComps.add(tc);
 
             auto rc = paddle->addComponent<RenderComponent>();
             rc->color = glm::vec3(1, 1, 1);
-            mRenderComps.push_back(rc);
+            mRenderComps.add(rc);
 
             auto sc = paddle->addComponent<BoxShapeComponent>();
             sc->halfExtent = {10, 60};
-            mShapeComps.push_back(sc);
+            mShapeComps.add(sc);
 
             auto cc = paddle->addComponent<CollisionComponent>();
             cc->dynamic = false;
-            mCollisionComps.push_back(cc);
+            mCollisionComps.add(cc);
 
             auto pc = paddle->addComponent<PaddleComponent>();
             pc->owner = player;
-            mPaddleComps.push_back(pc);
+            mPaddleComps.add(pc);
 
             // both player get AI
             auto ai = paddle->addComponent<AIComponent>();
-            mAIComps.push_back(ai);
-
-            mEntities.push_back(paddle);
+            mAIComps.add(ai);
         }
     }
 
@@ -154,21 +146,20 @@ void Assignment03::initGame()
     // - a static collision component
     for (auto isTop : {true, false})
     {
-        auto border = std::make_shared<Entity>(isTop ? "Top Border" : "Bottom Border");
+        auto border = createEntity(isTop ? "Top Border" : "Bottom Border");
 
         auto tc = border->addComponent<TransformComponent>();
         tc->position = glm::vec2(mParams.fieldWidth / 2, isTop ? 0 : mParams.fieldHeight);
-        mTransformComps.push_back(tc);
+        tc->previousPosition = tc->position;
+        mTransformComps.add(tc);
 
         auto cc = border->addComponent<CollisionComponent>();
         cc->dynamic = false;
-        mCollisionComps.push_back(cc);
+        mCollisionComps.add(cc);
 
         auto sc = border->addComponent<HalfPlaneShapeComponent>();
         sc->normal = glm::vec2(0, isTop ? 1 : -1);
-        mShapeComps.push_back(sc);
-
-        mEntities.push_back(border);
+        mShapeComps.add(sc);
     }
 
     // Region detector have
@@ -177,27 +168,26 @@ void Assignment03::initGame()
     // - a region detector component (owned by the respective player)
     for (auto player : {Player::Left, Player::Right})
     {
-        auto detector = std::make_shared<Entity>(player == Player::Left ? "Left Detector" : "Right Detector");
+        auto detector = createEntity(player == Player::Left ? "Left Detector" : "Right Detector");
 
         auto tc = detector->addComponent<TransformComponent>();
         tc->position = glm::vec2(player == Player::Left ? 0 : mParams.fieldWidth, mParams.fieldHeight / 2);
-        mTransformComps.push_back(tc);
+        tc->previousPosition = tc->position;
+        mTransformComps.add(tc);
 
         auto rdc = detector->addComponent<RegionDetectorComponent>();
         rdc->owner = player;
-        mRegionDetectorComps.push_back(rdc);
+        mRegionDetectorComps.add(rdc);
 
         auto sc = detector->addComponent<HalfPlaneShapeComponent>();
         sc->normal = glm::vec2(player == Player::Left ? 1 : -1, 0);
-        mShapeComps.push_back(sc);
-
-        mEntities.push_back(detector);
+        mShapeComps.add(sc);
     }
 }
 
 void Assignment03::spawnBall()
 {
-    auto ball = std::make_shared<Entity>("Ball");
+    auto ball = createEntity("Ball");
 
     // Balls have
     // - a transform component (starts in center with spawnVelocity)
@@ -240,26 +230,25 @@ void Assignment03::spawnBall()
 
     auto tc = ball->addComponent<TransformComponent>();
     tc->position = spawnPos;
+    tc->previousPosition = spawnPos;
     tc->velocity = spawnVelocity;
     tc->linearDrag = mParams.ballDrag;
-    mTransformComps.push_back(tc);
+    mTransformComps.add(tc);
 
     auto rc = ball->addComponent<RenderComponent>();
     rc->color = glm::vec3(.89f, .00f, .40f);
-    mRenderComps.push_back(rc);
+    mRenderComps.add(rc);
 
     auto sc = ball->addComponent<SphereShapeComponent>();
     sc->radius = 15;
-    mShapeComps.push_back(sc);
+    mShapeComps.add(sc);
 
     auto bc = ball->addComponent<BallComponent>();
-    mBallComps.push_back(bc);
+    mBallComps.add(bc);
 
     auto cc = ball->addComponent<CollisionComponent>();
     cc->dynamic = true;
-    mCollisionComps.push_back(cc);
-
-    mEntities.push_back(ball);
+    mCollisionComps.add(cc);
 
     // reset multi ball cooldown
     mParams.multiBallCooldown = mParams.multiBallTime;
@@ -270,32 +259,37 @@ void Assignment03::spawnBall()
 
 void Assignment03::updateMotionSystem(float elapsedSeconds)
 {
-    for (auto const& transformComp : mTransformComps)
-    {
-        /// Task 1.a
-        /// Until now, TransformComponents contained only position and velocity.
-        /// Now, paddles are moved by setting the acceleration
-        /// (and updating velocity and position accordingly).
-        /// Furthermore, linear drag is introduced to simulate air friction
-        /// that "dampens" the acceleration based on the current velocity.
-        ///
-        /// Your job is to:
-        ///     - apply linear drag to the acceleration
-        ///     - update the velocity
-        ///
-        /// Notes:
-        ///     - see Components.hh for the definition of a transform component
-        ///     - you should not change transformComp->acceleration (linear drag is only added temporarily!)
-        ///
-        /// ============= STUDENT CODE BEGIN =============
-
-        auto airResistance = transformComp->velocity * transformComp->linearDrag;
-        transformComp->velocity += (transformComp->acceleration - airResistance) * elapsedSeconds;
-
-        /// ============= STUDENT CODE END =============
-
-        transformComp->position += transformComp->velocity * elapsedSeconds;
-    }
+    // transforms are independent of each other, so chunks can be integrated in parallel
+    mScheduler.pool().parallelFor(mTransformComps.size(), 256, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; ++i)
+        {
+            auto const& transformComp = mTransformComps[i];
+
+            /// Task 1.a
+            /// Until now, TransformComponents contained only position and velocity.
+            /// Now, paddles are moved by setting the acceleration
+            /// (and updating velocity and position accordingly).
+            /// Furthermore, linear drag is introduced to simulate air friction
+            /// that "dampens" the acceleration based on the current velocity.
+            ///
+            /// Your job is to:
+            ///     - apply linear drag to the acceleration
+            ///     - update the velocity
+            ///
+            /// Notes:
+            ///     - see Components.hh for the definition of a transform component
+            ///     - you should not change transformComp->acceleration (linear drag is only added temporarily!)
+            ///
+            /// ============= STUDENT CODE BEGIN =============
+
+            auto airResistance = transformComp->velocity * transformComp->linearDrag;
+            transformComp->velocity += (transformComp->acceleration - airResistance) * elapsedSeconds;
+
+            /// ============= STUDENT CODE END =============
+
+            transformComp->position += transformComp->velocity * elapsedSeconds;
+        }
+    });
 }
 
 bool Assignment03::checkSphereSegmentCollision(glm::vec2 p0, glm::vec2 p1, glm::vec2 n, glm::vec2 c, float r, TransformComponent* tc) const
@@ -540,78 +534,95 @@ void Assignment03::updateAI(float elapsedSeconds)
 {
     using namespace ai;
 
-    std::vector<Ball> balls;
-    std::vector<Paddle> paddles;
-    for (auto const& b : mBallComps)
-        balls.push_back({b->entity->getComponent<TransformComponent>(), //
-                         b->entity->getComponent<SphereShapeComponent>()});
-    for (auto const& p : mPaddleComps)
-        paddles.push_back({p->owner,                                      //
-                           p->entity->getComponent<TransformComponent>(), //
-                           p->entity->getComponent<BoxShapeComponent>()});
-    auto getPaddle = [&](Entity* e) -> Paddle {
-        for (auto const& p : paddles)
-            if (p.transform->entity == e)
-                return p;
-        throw "Paddle Not Found";
-    };
+    // balls, paddles and AI assignments only change when entities are created or destroyed
+    if (mAIInputsDirty)
+    {
+        mAIBalls.clear();
+        mAIPaddles.clear();
+        mAIAssignments.clear();
+        for (auto const& b : mBallComps)
+            mAIBalls.push_back({b->entity->getComponent<TransformComponent>(), //
+                                b->entity->getComponent<SphereShapeComponent>()});
+        for (auto const& p : mPaddleComps)
+            mAIPaddles.push_back({p->owner,                                      //
+                                  p->entity->getComponent<TransformComponent>(), //
+                                  p->entity->getComponent<BoxShapeComponent>()});
+
+        for (auto const& aic : mAIComps)
+        {
+            auto entity = aic->entity;
+            if (!entity->hasComponent<PaddleComponent>())
+                continue;
+
+            // paddle and its idx among the paddles of the same owner
+            AIAssignment a;
+            a.paddle = 0;
+            a.paddleIdx = 0;
+            while (mAIPaddles[a.paddle].transform->entity != entity)
+                ++a.paddle;
+            for (auto i = 0u; i < a.paddle; ++i)
+                if (mAIPaddles[i].owner == mAIPaddles[a.paddle].owner)
+                    ++a.paddleIdx;
+            a.transform = entity->getComponent<TransformComponent>();
+            a.render = entity->getComponent<RenderComponent>();
+            mAIAssignments.push_back(a);
+        }
+
+        mAIInputsDirty = false;
+    }
+    auto const& balls = mAIBalls;
+    auto const& paddles = mAIPaddles;
 
-    for (auto const& aic : mAIComps)
+    // intercepts are predicted lazily and shared by all AIs of this tick
+    mBallPrediction.reset(paddles, balls.size(), mParams);
+    auto const& prediction = mBallPrediction;
+
+    for (auto const& a : mAIAssignments)
     {
-        auto entity = aic->entity;
-        if (entity->hasComponent<PaddleComponent>())
+        auto const& currPaddle = paddles[a.paddle];
+        auto pIdx = a.paddleIdx;
+
+        // execute AI
+        glm::vec3 debugColor = {1, 1, 1};
+        float accel = 0.0f;
+        auto owner = currPaddle.owner;
+        switch (mParams.scenario)
         {
-            // get current paddle and its idx
-            auto currPaddle = getPaddle(entity);
-            auto pIdx = 0u;
-            for (auto const& p : paddles)
-                if (p.transform->entity == entity)
+        case Scenario::Task2A:
+            accel = ai::task2a(pIdx, currPaddle, paddles, balls, mParams, prediction, elapsedSeconds, debugColor);
+            break;
+        case Scenario::Task2B:
+            accel = ai::task2b(pIdx, currPaddle, paddles, balls, mParams, prediction, elapsedSeconds, debugColor);
+            break;
+        case Scenario::Task2C:
+            accel = ai::task2c(pIdx, currPaddle, paddles, balls, mParams, prediction, elapsedSeconds, debugColor);
+            break;
+        case Scenario::Task3:
+            if (owner == Player::Left)
+                accel = ai::task3(pIdx, currPaddle, paddles, balls, mParams, prediction, elapsedSeconds, debugColor);
+            else
+                switch (mParams.enemy)
+                {
+                case EnemyAI::Simple:
+                    accel = ai::simpleAI(pIdx, currPaddle, paddles, balls, mParams, prediction, elapsedSeconds, debugColor);
                     break;
-                else if (p.owner == currPaddle.owner)
-                    ++pIdx;
-
-            // execute AI
-            glm::vec3 debugColor = {1, 1, 1};
-            float accel = 0.0f;
-            auto owner = entity->getComponent<PaddleComponent>()->owner;
-            switch (mParams.scenario)
-            {
-            case Scenario::Task2A:
-                accel = ai::task2a(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                break;
-            case Scenario::Task2B:
-                accel = ai::task2b(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                break;
-            case Scenario::Task2C:
-                accel = ai::task2c(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                break;
-            case Scenario::Task3:
-                if (owner == Player::Left)
-                    accel = ai::task3(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                else
-                    switch (mParams.enemy)
-                    {
-                    case EnemyAI::Simple:
-                        accel = ai::simpleAI(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                        break;
-                    case EnemyAI::Normal:
-                        accel = ai::normalAI(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                        break;
-                    case EnemyAI::Good:
-                        accel = ai::goodAI(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
-                        break;
-                    }
-                break;
-            }
-            assert(std::isfinite(accel));
+                case EnemyAI::Normal:
+                    accel = ai::normalAI(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
+                    break;
+                case EnemyAI::Good:
+                    accel = ai::goodAI(pIdx, currPaddle, paddles, balls, mParams, elapsedSeconds, debugColor);
+                    break;
+                }
+            break;
+        }
+        assert(std::isfinite(accel));
 
-            // set debug color
-            entity->getComponent<RenderComponent>()->color = debugColor;
+        // set debug color
+        a.render->color = debugColor;
 
-            // clamp and set acceleration
-            accel = glm::clamp(accel, -mParams.paddleMaxAcceleration, mParams.paddleMaxAcceleration);
-            entity->getComponent<TransformComponent>()->acceleration = {0, accel};
-        }
+        // clamp and set acceleration
+        accel = glm::clamp(accel, -mParams.paddleMaxAcceleration, mParams.paddleMaxAcceleration);
+        a.transform->acceleration = {0, accel};
     }
 }
 
@@ -651,12 +662,8 @@ void Assignment03::processMessages()
                     glow::info() << "Ball left the field at y = " << pos.y;
                 }
 
-                // destroy ball
-                destroyEntity(msg.subject->entity);
-
-                // spawn new ball if last ball was destroyed
-                if (mBallComps.empty())
-                    spawnBall();
+                // destroy ball (at the end of the tick)
+                destroyEntity(msg.subject->entity->getHandle());
 
                 // either way, reset multi ball cooldown
                 mParams.multiBallCooldown = mParams.multiBallTime;
@@ -671,16 +678,50 @@ void Assignment03::processMessages()
     mMessages.clear();
 }
 
+void Assignment03::setupSystems()
+{
+    using namespace Access;
+
+    // Systems are listed in their logical order
+    // Conflicting systems are executed in exactly this order, independent ones may run in parallel
+    // NOTE: if you change what a system touches, update its read/write set!
+    mScheduler.clear();
+
+    // (Ball and AI touch disjoint data and share the first level)
+    mScheduler.addSystem("Ball", Ball | BallState | Params, BallForce | Random, //
+                         [this](float dt) { updateBallSystem(dt); });
+    mScheduler.addSystem("AI", Ball | Paddle | AI | BallState | PaddleState | Shape | Params, PaddleForce | Render,
+                         [this](float dt) { updateAI(dt); });
+    mScheduler.addSystem("Motion", Transform, BallState | PaddleState | StaticTransform, //
+                         [this](float dt) { updateMotionSystem(dt); });
+    mScheduler.addSystem("RegionDetector", RegionDetector | Collision | Shape | BallState | StaticTransform, Messages, // before collision!
+                         [this](float dt) { updateRegionDetectorSystem(dt); });
+    mScheduler.addSystem("Collision", Collision | Shape | BallState | PaddleState | StaticTransform | Params, BallState | Messages,
+                         [this](float dt) { updateCollisionSystem(dt); });
+    mScheduler.addSystem("Paddle", Paddle | Shape | PaddleState | PaddleForce | Params, PaddleState | PaddleForce,
+                         [this](float dt) { updatePaddleSystem(dt); });
+
+    // structural changes and AntTweakBar access
+    mScheduler.addSystem("GameLogic", Params | Random | AllComponents, Params | Random | AllComponents, //
+                         [this](float dt) { updateGameLogic(dt); }, true);
+    mScheduler.addSystem("Messages", Everything, Everything, //
+                         [this](float) { processMessages(); }, true);
+}
+
 void Assignment03::update(float elapsedSeconds)
 {
-    updateBallSystem(elapsedSeconds);
-    updateAI(elapsedSeconds);
-    updateMotionSystem(elapsedSeconds);
-    updateRegionDetectorSystem(elapsedSeconds); // before collision!
-    updateCollisionSystem(elapsedSeconds);
-    updatePaddleSystem(elapsedSeconds);
-    updateGameLogic(elapsedSeconds);
-    processMessages();
+    // remember positions for interpolated rendering
+    for (auto const& tc : mTransformComps)
+        tc->previousPosition = tc->position;
+
+    mScheduler.run(elapsedSeconds);
+
+    // end of tick
+    destroyPendingEntities();
+
+    // spawn new ball if last ball was destroyed
+    if (mBallComps.empty())
+        spawnBall();
 }
 
 void Assignment03::render(float elapsedSeconds)
@@ -689,63 +730,76 @@ void Assignment03::render(float elapsedSeconds)
     glClearColor(0.00f, 0.00f, 0.00f, 1.00f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // draw all render components
+    // "Zoom" mode for aspect ratio
+    glm::vec2 fieldSize = {mParams.fieldWidth, mParams.fieldHeight};
+    glm::vec2 offset = {0, 0};
+    glm::vec2 scale = {0, 0};
+    if (getWindowWidth() > getWindowHeight())
     {
-        auto shader = mShaderObj->use();
-        auto quad = mQuad->bind();
+        offset.x = (1.0f - getWindowHeight() / (float)getWindowWidth()) / 2.0f;
+        scale = glm::vec2(getWindowHeight() / (float)getWindowWidth(), 1.0f) / fieldSize;
+    }
+    else
+    {
+        offset.y = (1.0f - getWindowWidth() / (float)getWindowHeight()) / 2.0f;
+        scale = glm::vec2(1.0f, getWindowWidth() / (float)getWindowHeight()) / fieldSize;
+    }
 
-        // "Zoom" mode for aspect ratio
-        glm::vec2 fieldSize = {mParams.fieldWidth, mParams.fieldHeight};
-        glm::vec2 offset = {0, 0};
-        glm::vec2 scale = {0, 0};
-        if (getWindowWidth() > getWindowHeight())
+    // collect instances
+    mSpriteData.clear();
+
+    // blue area
+    mSpriteData.push_back({offset, fieldSize * scale, glm::vec3(0.00f, 0.33f, 0.62f), 0.0f});
+
+    // entities
+    for (auto const& renderComp : mRenderComps)
+    {
+        auto handle = renderComp->entity->getHandle();
+        auto transformComp = mTransformComps.get(handle);
+        auto shapeComp = mShapeComps.get(handle);
+        auto boxShape = dynamic_cast<BoxShapeComponent*>(shapeComp);
+        auto sphereShape = dynamic_cast<SphereShapeComponent*>(shapeComp);
+
+        glm::vec2 halfSize;
+        float sphere = 0.0f;
+
+        if (boxShape)
+            halfSize = boxShape->halfExtent;
+        else if (sphereShape)
         {
-            offset.x = (1.0f - getWindowHeight() / (float)getWindowWidth()) / 2.0f;
-            scale = glm::vec2(getWindowHeight() / (float)getWindowWidth(), 1.0f) / fieldSize;
+            halfSize = glm::vec2(sphereShape->radius);
+            sphere = 1.0f;
         }
         else
         {
-            offset.y = (1.0f - getWindowWidth() / (float)getWindowHeight()) / 2.0f;
-            scale = glm::vec2(1.0f, getWindowWidth() / (float)getWindowHeight()) / fieldSize;
+            glow::error() << "Shape not supported";
+            continue;
         }
 
-        // blue area
-        shader.setUniform("uPosition", offset);
-        shader.setUniform("uSize", fieldSize * scale);
-        shader.setUniform("uSphere", false);
-        shader.setUniform("uColor", glm::vec3(0.00f, 0.33f, 0.62f));
-        quad.draw();
+        // simulation is ahead of rendering, interpolate between last two ticks
+        auto position = mix(transformComp->previousPosition, transformComp->position, getInterpolationAlpha());
 
-        // render entities
-        for (auto const& renderComp : mRenderComps)
-        {
-            auto transformComp = renderComp->entity->getComponent<TransformComponent>();
-            auto shapeComp = renderComp->entity->getComponent<ShapeComponent>();
-            auto boxShape = dynamic_cast<BoxShapeComponent*>(shapeComp);
-            auto sphereShape = dynamic_cast<SphereShapeComponent*>(shapeComp);
-
-            glm::vec2 halfSize;
-
-            if (boxShape)
-            {
-                halfSize = boxShape->halfExtent;
-                shader.setUniform("uSphere", false);
-            }
-            else if (sphereShape)
-            {
-                halfSize = glm::vec2(sphereShape->radius);
-                shader.setUniform("uSphere", true);
-            }
-            else
-                glow::error() << "Shape not supported";
+        mSpriteData.push_back({(position - halfSize) * scale + offset, 2 * halfSize * scale, renderComp->color, sphere});
+    }
 
-            shader.setUniform("uSize", 2 * halfSize * scale);
-            shader.setUniform("uPosition", (transformComp->position - halfSize) * scale + offset);
+    // draw all render components (instanced)
+    if (mSpriteStream)
+    {
+        auto sprites = mSpriteStream->upload(mSpriteData);
+        if (sprites.isValid())
+        {
+            auto shader = mShaderObj->use();
+            mSprites->bind().draw((GLsizei)mSpriteData.size(), GLuint(sprites.offset / sizeof(SpriteInstance)));
+        }
 
-            shader.setUniform("uColor", renderComp->color);
+        mSpriteStream->nextFrame();
+    }
+    else // (pre-4.4 context)
+    {
+        mSpriteBuffer->bind().setData(mSpriteData, GL_STREAM_DRAW);
 
-            quad.draw();
-        }
+        auto shader = mShaderObj->use();
+        mSprites->bind().draw((GLsizei)mSpriteData.size());
     }
 }
 
@@ -754,28 +808,97 @@ void Assignment03::sendMessage(const Message& msg)
     mMessages.push_back(msg);
 }
 
-void Assignment03::destroyEntity(Entity* entity)
+SharedEntity Assignment03::createEntity(std::string const& name)
 {
-    SharedEntity se;
-    for (auto const& e : mEntities)
-        if (e.get() == entity)
-        {
-            se = e;
-            break;
-        }
+    uint32_t idx;
+    if (!mFreeEntitySlots.empty())
+    {
+        idx = mFreeEntitySlots.back();
+        mFreeEntitySlots.pop_back();
+    }
+    else
+    {
+        idx = (uint32_t)mEntities.size();
+        assert(idx <= EntityHandle::IndexMask && "too many entities");
+        mEntities.push_back(nullptr);
+        mEntityGenerations.push_back(0);
+    }
+
+    auto entity = std::make_shared<Entity>(name, EntityHandle(idx, mEntityGenerations[idx]));
+    mEntities[idx] = entity;
+    mAIInputsDirty = true;
+    return entity;
+}
+
+Entity* Assignment03::getEntity(EntityHandle h) const
+{
+    return isAlive(h) ? mEntities[h.index()].get() : nullptr;
+}
+
+bool Assignment03::isAlive(EntityHandle h) const
+{
+    auto idx = h.index();
+    return h.isValid() && idx < mEntities.size() && mEntities[idx] != nullptr && mEntityGenerations[idx] == h.generation();
+}
+
+void Assignment03::destroyEntity(EntityHandle h)
+{
+    if (isAlive(h))
+        mPendingDestroy.push_back(h);
+}
+
+void Assignment03::destroyPendingEntities()
+{
+    // messages hold components, none may outlive its entity
+    assert(mMessages.empty() && "entities are destroyed after all messages are processed");
 
-    removeElement(mEntities, se); // se is pinned until function exits, thus safe to use
-    for (auto c : se->getComponents())
+    for (auto h : mPendingDestroy)
     {
-        removeElement(mTransformComps, c);
-        removeElement(mShapeComps, c);
-        removeElement(mCollisionComps, c);
-        removeElement(mRegionDetectorComps, c);
-        removeElement(mRenderComps, c);
-        removeElement(mBallComps, c);
-        removeElement(mPaddleComps, c);
-        removeElement(mAIComps, c);
+        if (!isAlive(h))
+            continue; // marked multiple times
+
+        mTransformComps.remove(h);
+        mShapeComps.remove(h);
+        mCollisionComps.remove(h);
+        mRegionDetectorComps.remove(h);
+        mRenderComps.remove(h);
+        mBallComps.remove(h);
+        mPaddleComps.remove(h);
+        mAIComps.remove(h);
+
+        releaseEntitySlot(h.index());
+        mAIInputsDirty = true;
     }
+    mPendingDestroy.clear();
+}
+
+void Assignment03::releaseEntitySlot(uint32_t idx)
+{
+    // invalidate all handles to this slot
+    mEntities[idx] = nullptr;
+    ++mEntityGenerations[idx];
+
+    // slots are retired instead of wrapping their generation (stale handles must never become valid again)
+    if (mEntityGenerations[idx] <= EntityHandle::MaxGeneration)
+        mFreeEntitySlots.push_back(idx);
+}
+
+void Assignment03::destroyAllEntities()
+{
+    mTransformComps.clear();
+    mShapeComps.clear();
+    mCollisionComps.clear();
+    mRegionDetectorComps.clear();
+    mRenderComps.clear();
+    mBallComps.clear();
+    mPaddleComps.clear();
+    mAIComps.clear();
+
+    for (auto idx = 0u; idx < mEntities.size(); ++idx)
+        if (mEntities[idx])
+            releaseEntitySlot(idx);
+    mPendingDestroy.clear();
+    mAIInputsDirty = true;
 }
 
 namespace
@@ -791,7 +914,7 @@ void TW_CALL TaskGetter(void* value, void* clientData)
 }
 void TW_CALL BallGetter(void* value, void* clientData)
 {
-    *(int*)value = ((std::vector<BallComponent>*)clientData)->size();
+    *(int*)value = ((ComponentPool<BallComponent>*)clientData)->size();
 }
 }
 
@@ -804,6 +927,21 @@ void Assignment03::init()
     mQuad = geometry::Quad<>().generate();
     mShaderObj = Program::createFromFile(util::pathOf(__FILE__) + "/shaderObj");
 
+    // per-instance sprite data (one instance per render component)
+    // streamed via a persistently mapped buffer if the context supports it (GL 4.4 / 4.2 for base instances)
+    if (StreamBuffer::isSupported() && VertexArray::isBaseInstanceSupported())
+    {
+        mSpriteStream = StreamBuffer::create(1 << 20); // ~29k sprites per frame
+        mSpriteBuffer = ArrayBuffer::createAliased(mSpriteStream);
+    }
+    else
+        mSpriteBuffer = ArrayBuffer::create();
+    mSpriteBuffer->defineAttribute(&SpriteInstance::position, "aInstPosition", AttributeMode::Float, 1);
+    mSpriteBuffer->defineAttribute(&SpriteInstance::size, "aInstSize", AttributeMode::Float, 1);
+    mSpriteBuffer->defineAttribute(&SpriteInstance::color, "aInstColor", AttributeMode::Float, 1);
+    mSpriteBuffer->defineAttribute(&SpriteInstance::sphere, "aInstSphere", AttributeMode::Float, 1);
+    mSprites = VertexArray::create({mQuad->getAttributeBuffer("aPosition"), mSpriteBuffer}, nullptr, GL_TRIANGLE_STRIP);
+
     // setup tweakbar (we just use it as a scoreboard here)
     TwAddVarRO(tweakbar(), "Score Left", TW_TYPE_INT32, &mParams.scoreLeft, "");
     TwAddVarRO(tweakbar(), "Score Right", TW_TYPE_INT32, &mParams.scoreRight, "");
@@ -828,10 +966,38 @@ void Assignment03::init()
 
     TwDefine("Tweakbar size='200 120' valueswidth=80");
 
+    // register systems
+    setupSystems();
+
     // create initial entities / setup game area
     setScenario(mParams.scenario);
 }
 
+void Assignment03::onRecordParameters(std::vector<char>& data)
+{
+    // everything that can be changed via the tweakbar
+    int32_t values[] = {(int32_t)mParams.scenario, (int32_t)mParams.enemy};
+    data.assign((char const*)values, (char const*)values + sizeof(values));
+}
+
+void Assignment03::onReplayParameters(std::vector<char> const& data)
+{
+    int32_t values[2];
+    if (data.size() != sizeof(values))
+        return;
+    memcpy(values, data.data(), sizeof(values));
+
+    if ((Scenario)values[0] != mParams.scenario)
+        setScenario((Scenario)values[0]);
+    mParams.enemy = (EnemyAI)values[1];
+}
+
+void Assignment03::onClose()
+{
+    if (getDumpTimingsOnShutdown())
+        mScheduler.dumpTimings(std::cout);
+}
+
 static float random(float min, float max)
 {
     return min + (max - min) * (rand() / (float)RAND_MAX);
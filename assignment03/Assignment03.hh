@@ -9,10 +9,13 @@
 
 #include <glow-extras/glfw/GlfwApp.hh>
 
+#include "AI.hh"
+#include "ComponentPool.hh"
 #include "Components.hh"
 #include "Entity.hh"
 #include "Messages.hh"
 #include "Parameters.hh"
+#include "SystemScheduler.hh"
 
 /**
  * Assignment03: A relatively simple Pong Game written in with the Entity-Component-Systems approach
@@ -42,25 +45,58 @@ private:
     // Does NOT delete the old ball
     void spawnBall();
 
-    // Destroys an entity and all attached components
-    // Removes the entity (and its components) from all lists in this class
-    void destroyEntity(Entity* entity);
+    // Creates a new (empty) entity in a free slot and returns it
+    SharedEntity createEntity(std::string const& name);
+
+    // Returns the entity for a handle or nullptr if the handle is stale
+    Entity* getEntity(EntityHandle h) const;
+
+    // Returns true iff the handle refers to a living entity
+    // (entities marked for destruction are still alive until the end of the tick)
+    bool isAlive(EntityHandle h) const;
+
+    // Marks an entity for destruction
+    // The entity and all attached components are removed at the end of the tick (see destroyPendingEntities)
+    // Marking an entity multiple times (or with a stale handle) is safe
+    void destroyEntity(EntityHandle h);
+
+    // Removes all entities marked via destroyEntity (and their components) from all lists in this class
+    // O(1) per entity
+    void destroyPendingEntities();
+
+    // Immediately destroys all entities and components
+    // Handles to destroyed entities stay detectably stale
+    void destroyAllEntities();
+
+    // Frees the slot of a destroyed entity and bumps its generation
+    // (retires the slot if its generation is exhausted)
+    void releaseEntitySlot(uint32_t idx);
 
 private: // ECS
-    // list of entities
+    // list of entities (indexed by EntityHandle::index(), nullptr for free slots)
     std::vector<SharedEntity> mEntities;
+    // current generation of each entity slot
+    std::vector<uint32_t> mEntityGenerations;
+    // unused entity slots
+    std::vector<uint32_t> mFreeEntitySlots;
+    // entities marked for destruction at the end of the tick
+    std::vector<EntityHandle> mPendingDestroy;
 
     // list of components
-    std::vector<SharedTransformComponent> mTransformComps;
-    std::vector<SharedShapeComponent> mShapeComps;
-    std::vector<SharedCollisionComponent> mCollisionComps;
-    std::vector<SharedRegionDetectorComponent> mRegionDetectorComps;
-    std::vector<SharedRenderComponent> mRenderComps;
-    std::vector<SharedBallComponent> mBallComps;
-    std::vector<SharedPaddleComponent> mPaddleComps;
-    std::vector<SharedAIComponent> mAIComps;
+    ComponentPool<TransformComponent> mTransformComps;
+    ComponentPool<ShapeComponent> mShapeComps;
+    ComponentPool<CollisionComponent> mCollisionComps;
+    ComponentPool<RegionDetectorComponent> mRegionDetectorComps;
+    ComponentPool<RenderComponent> mRenderComps;
+    ComponentPool<BallComponent> mBallComps;
+    ComponentPool<PaddleComponent> mPaddleComps;
+    ComponentPool<AIComponent> mAIComps;
 
     // systems
+    // (registered with their read/write sets in setupSystems())
+    SystemScheduler mScheduler;
+    void setupSystems();
+
     void updateMotionSystem(float elapsedSeconds);
     void updateCollisionSystem(float elapsedSeconds);
     void updateRegionDetectorSystem(float elapsedSeconds);
@@ -73,15 +109,50 @@ private: // ECS
     // message queue
     std::vector<Message> mMessages;
 
+    // AI inputs, rebuilt only when entities are created or destroyed (see updateAI)
+    struct AIAssignment
+    {
+        size_t paddle;    // index into mAIPaddles
+        size_t paddleIdx; // index among the paddles of the same owner
+        TransformComponent* transform;
+        RenderComponent* render;
+    };
+    std::vector<ai::Ball> mAIBalls;
+    std::vector<ai::Paddle> mAIPaddles;
+    std::vector<AIAssignment> mAIAssignments;
+    bool mAIInputsDirty = true;
+
+    // ball intercepts of the current tick (see updateAI)
+    ai::BallPrediction mBallPrediction;
+
     // helper
     bool checkSphereSegmentCollision(glm::vec2 v0, glm::vec2 v1, glm::vec2 n, glm::vec2 c, float r, TransformComponent* tc) const;
 
 private: // graphics
+    // per-instance data of one rendered quad (see shaderObj.vsh)
+    struct SpriteInstance
+    {
+        glm::vec2 position; // lower left corner (normalized screen coords)
+        glm::vec2 size;     // (normalized screen coords)
+        glm::vec3 color;
+        float sphere; // 1 = discard outside the inscribed circle, 0 = box
+    };
+
     glow::SharedVertexArray mQuad;
     glow::SharedProgram mShaderObj;
 
+    // all render components are drawn with a single instanced draw call
+    std::vector<SpriteInstance> mSpriteData;
+    glow::SharedStreamBuffer mSpriteStream; // streamed per frame, aliased by mSpriteBuffer (nullptr if unsupported)
+    glow::SharedArrayBuffer mSpriteBuffer;
+    glow::SharedVertexArray mSprites;
+
 public:
     void init() override;
     void update(float elapsedSeconds) override;
     void render(float elapsedSeconds) override;
+    void onClose() override;
+
+    void onRecordParameters(std::vector<char>& data) override;
+    void onReplayParameters(std::vector<char> const& data) override;
 };
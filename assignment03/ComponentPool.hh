@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Components.hh"
+#include "Entity.hh"
+
+/**
+ * A densely packed list of components of one type
+ *
+ * Components are stored contiguously ("dense") and can be iterated like a std::vector.
+ * A "sparse" array maps entity slot indices to positions in the dense array,
+ * so adding, querying and removing the component of an entity are all O(1).
+ * Removal swaps the last component into the freed position (swap-and-pop),
+ * i.e. the order of components is NOT stable across removals.
+ *
+ * Each entity can have at most one component per pool.
+ *
+ * Usage:
+ *   ComponentPool<TransformComponent> transforms;
+ *   transforms.add(tc);
+ *   for (auto const& tc : transforms) ...
+ *   transforms.remove(entity->getHandle());
+ */
+template <typename CompT>
+class ComponentPool
+{
+public:
+    using SharedCompT = std::shared_ptr<CompT>;
+
+private:
+    static const uint32_t InvalidIndex = ~0u;
+
+    // dense list of components
+    std::vector<SharedCompT> mComponents;
+    // dense list of owning entity slot indices (parallel to mComponents)
+    std::vector<uint32_t> mOwners;
+    // entity slot index -> index in mComponents (or InvalidIndex)
+    std::vector<uint32_t> mSparse;
+
+public: // vector-like interface
+    typename std::vector<SharedCompT>::const_iterator begin() const { return mComponents.begin(); }
+    typename std::vector<SharedCompT>::const_iterator end() const { return mComponents.end(); }
+    size_t size() const { return mComponents.size(); }
+    bool empty() const { return mComponents.empty(); }
+    SharedCompT const& operator[](size_t i) const { return mComponents[i]; }
+
+public:
+    // Adds a component for its entity
+    // The entity must not already have a component in this pool
+    template <typename U>
+    void add(std::shared_ptr<U> const& comp)
+    {
+        auto idx = comp->entity->getHandle().index();
+        if (idx >= mSparse.size())
+            mSparse.resize(idx + 1, uint32_t(InvalidIndex));
+        assert(mSparse[idx] == InvalidIndex && "entity already has a component in this pool");
+
+        mSparse[idx] = (uint32_t)mComponents.size();
+        mComponents.push_back(comp);
+        mOwners.push_back(idx);
+    }
+
+    // Returns the component of the given entity (or nullptr if it has none)
+    // Does NOT check the generation of the handle
+    CompT* get(EntityHandle h) const
+    {
+        auto idx = h.index();
+        if (idx >= mSparse.size() || mSparse[idx] == InvalidIndex)
+            return nullptr;
+        return mComponents[mSparse[idx]].get();
+    }
+
+    // Removes the component of the given entity (if any) via swap-and-pop
+    void remove(EntityHandle h)
+    {
+        auto idx = h.index();
+        if (idx >= mSparse.size() || mSparse[idx] == InvalidIndex)
+            return;
+
+        auto pos = mSparse[idx];
+        auto last = (uint32_t)mComponents.size() - 1;
+        if (pos != last)
+        {
+            mComponents[pos] = std::move(mComponents[last]);
+            mOwners[pos] = mOwners[last];
+            mSparse[mOwners[pos]] = pos;
+        }
+
+        mComponents.pop_back();
+        mOwners.pop_back();
+        mSparse[idx] = InvalidIndex;
+    }
+
+    // Removes all components
+    void clear()
+    {
+        mComponents.clear();
+        mOwners.clear();
+        mSparse.clear();
+    }
+};
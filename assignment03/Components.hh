@@ -31,6 +31,11 @@ struct Component
 {
     // Backreference from Component to Entity
     // The pointer is const (not the Entity) so that it cannot be changed by accident
+    //
+    // It cannot dangle: a component is owned by its entity (and referenced by the component pools).
+    // Assignment03::destroyPendingEntities runs at the end of the tick, after all messages were processed,
+    // removes the components from all pools and only then releases the entity together with its components.
+    // Anything that has to refer to an entity across ticks stores its EntityHandle instead.
     Entity* const entity;
 
     // A component can only be created for a given entity
@@ -51,6 +56,8 @@ struct TransformComponent : Component
 
     // current position
     glm::vec2 position;
+    // position at the beginning of the current tick (for interpolated rendering)
+    glm::vec2 previousPosition;
     // current velocity
     glm::vec2 velocity;
     // current acceleration
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <typeinfo>
 #include <vector>
 
@@ -11,6 +12,42 @@
 GLOW_SHARED(class, Entity);
 GLOW_SHARED(struct, Component);
 
+/**
+ * A generational 32 bit handle to an entity
+ *
+ * The lower 20 bits are the slot index of the entity, the upper 12 bits its generation.
+ * Whenever an entity is destroyed, the generation of its slot is increased.
+ * Thus, handles to destroyed entities can be detected (see Assignment03::isAlive)
+ * even if the slot was re-used by a new entity.
+ *
+ * Generations never wrap: a slot whose generation reaches MaxGeneration is retired
+ * and never re-used (costs one slot per 4095 re-uses, keeps stale handles stale forever).
+ */
+struct EntityHandle
+{
+    static const uint32_t IndexBits = 20;
+    static const uint32_t IndexMask = (1u << IndexBits) - 1;
+    static const uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+    // (the last generation is never used so that no live handle equals InvalidValue)
+    static const uint32_t MaxGeneration = GenerationMask - 1;
+    static const uint32_t InvalidValue = ~0u;
+
+    uint32_t value = InvalidValue;
+
+    EntityHandle() = default;
+    EntityHandle(uint32_t index, uint32_t generation)
+      : value((index & IndexMask) | ((generation & GenerationMask) << IndexBits))
+    {
+    }
+
+    uint32_t index() const { return value & IndexMask; }
+    uint32_t generation() const { return value >> IndexBits; }
+    bool isValid() const { return value != InvalidValue; }
+
+    bool operator==(EntityHandle const& rhs) const { return value == rhs.value; }
+    bool operator!=(EntityHandle const& rhs) const { return value != rhs.value; }
+};
+
 /**
  * An Entity is a named object with a list of attached components
  */
@@ -24,12 +61,17 @@ private:
     // (it's const and cannot be changed later on)
     std::string const mName;
 
+    // The handle of this entity (index + generation)
+    EntityHandle const mHandle;
+
 public:
-    // An entity is constructed with a fixed name
-    Entity(std::string const& name) : mName(name) {}
+    // An entity is constructed with a fixed name and handle
+    // (entities should be created via Assignment03::createEntity)
+    Entity(std::string const& name, EntityHandle handle) : mName(name), mHandle(handle) {}
 
 public: // getter
     std::string const& getName() const { return mName; }
+    EntityHandle getHandle() const { return mHandle; }
     std::vector<SharedComponent> const& getComponents() const { return mComponents; }
 
 public:
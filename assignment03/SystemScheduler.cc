@@ -0,0 +1,116 @@
+#include "SystemScheduler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+void SystemScheduler::addSystem(std::string const& name, uint32_t reads, uint32_t writes, SystemFunc const& func, bool mainThread)
+{
+    System s;
+    s.name = name;
+    s.reads = reads;
+    s.writes = writes;
+    s.mainThread = mainThread;
+    s.func = func;
+    mSystems.push_back(s);
+
+    mLevelsDirty = true;
+}
+
+void SystemScheduler::clear()
+{
+    mSystems.clear();
+    mLevels.clear();
+    mLevelsDirty = true;
+}
+
+void SystemScheduler::buildLevels()
+{
+    mLevels.clear();
+
+    for (auto i = 0u; i < mSystems.size(); ++i)
+    {
+        auto& s = mSystems[i];
+        s.level = 0;
+
+        // depend on all earlier conflicting systems
+        for (auto j = 0u; j < i; ++j)
+        {
+            auto const& p = mSystems[j];
+            auto conflict = (p.writes & (s.reads | s.writes)) || (p.reads & s.writes);
+            if (conflict)
+                s.level = std::max(s.level, p.level + 1);
+        }
+
+        if (s.level >= (int)mLevels.size())
+            mLevels.resize(s.level + 1);
+        mLevels[s.level].push_back(i);
+    }
+
+    mLevelsDirty = false;
+}
+
+void SystemScheduler::runSystem(System& s, float elapsedSeconds)
+{
+    auto start = std::chrono::steady_clock::now();
+    s.func(elapsedSeconds);
+    auto end = std::chrono::steady_clock::now();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    s.totalNs += ns;
+    s.maxNs = std::max(s.maxNs, (int64_t)ns);
+    ++s.runs;
+}
+
+void SystemScheduler::run(float elapsedSeconds)
+{
+    if (mLevelsDirty)
+        buildLevels();
+
+    std::vector<std::function<void()>> tasks;
+    for (auto const& level : mLevels)
+    {
+        // main thread systems first
+        for (auto idx : level)
+            if (mSystems[idx].mainThread)
+                runSystem(mSystems[idx], elapsedSeconds);
+
+        // all others (in parallel)
+        tasks.clear();
+        for (auto idx : level)
+            if (!mSystems[idx].mainThread)
+            {
+                auto s = &mSystems[idx];
+                tasks.push_back([this, s, elapsedSeconds] { runSystem(*s, elapsedSeconds); });
+            }
+        mPool.run(tasks);
+    }
+}
+
+void SystemScheduler::resetTimings()
+{
+    for (auto& s : mSystems)
+    {
+        s.totalNs = 0;
+        s.maxNs = 0;
+        s.runs = 0;
+    }
+}
+
+void SystemScheduler::dumpTimings(std::ostream& oss) const
+{
+    oss << "System timings (" << mPool.getWorkerCount() << " worker threads):\n";
+    for (auto const& s : mSystems)
+    {
+        auto avgUs = s.runs > 0 ? s.totalNs / 1000.0 / s.runs : 0.0;
+        oss << "  [L" << s.level << "] " << std::left << std::setw(24) << s.name << std::right;
+        oss << std::fixed << std::setprecision(2);
+        oss << " avg " << std::setw(8) << avgUs << " us";
+        oss << ", max " << std::setw(8) << s.maxNs / 1000.0 << " us";
+        oss << ", total " << std::setw(8) << s.totalNs / 1000000.0 << " ms";
+        oss << " (" << s.runs << " runs)";
+        if (s.mainThread)
+            oss << " [main thread]";
+        oss << "\n";
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.hh"
+
+// Data that systems read or write
+// Used as bitmask, e.g. Access::BallState | Access::Shape
+//
+// Transforms are split by entity kind and by field, so that e.g. the ball system (writes ball acceleration)
+// and the AI (reads ball position and velocity, writes paddle acceleration) can run in parallel
+namespace Access
+{
+enum : uint32_t
+{
+    // position and velocity of balls
+    BallState = 1 << 0,
+    // acceleration of balls
+    BallForce = 1 << 1,
+    // position and velocity of paddles
+    PaddleState = 1 << 2,
+    // acceleration of paddles
+    PaddleForce = 1 << 3,
+    // transforms of all other entities (borders, region detectors)
+    StaticTransform = 1 << 4,
+
+    Shape = 1 << 5,
+    Collision = 1 << 6,
+    RegionDetector = 1 << 7,
+    Render = 1 << 8,
+    Ball = 1 << 9,
+    Paddle = 1 << 10,
+    AI = 1 << 11,
+
+    // the global message queue
+    Messages = 1 << 12,
+    // the global parameters (incl. score)
+    Params = 1 << 13,
+    // global random number generator (rand())
+    Random = 1 << 14,
+
+    // all transform components
+    Transform = BallState | BallForce | PaddleState | PaddleForce | StaticTransform,
+    // all component lists (e.g. for spawning or destroying entities)
+    AllComponents = Transform | Shape | Collision | RegionDetector | Render | Ball | Paddle | AI,
+    Everything = ~0u
+};
+}
+
+/**
+ * Runs the systems of an ECS with declared read/write sets
+ *
+ * Systems are executed in the order they were added, unless they are independent:
+ * A system depends on every earlier system it conflicts with (write/write or read/write on the same data).
+ * Independent systems of the same dependency level are run in parallel on the thread pool.
+ *
+ * Because conflicting systems always run in declaration order, the result of a tick is
+ * identical to running all systems sequentially (provided the declared sets are correct).
+ *
+ * Systems marked as mainThread are always executed on the thread calling run()
+ * (e.g. if they talk to AntTweakBar or OpenGL).
+ *
+ * The scheduler records wall time per system (see dumpTimings).
+ */
+class SystemScheduler
+{
+public:
+    using SystemFunc = std::function<void(float)>;
+
+private:
+    struct System
+    {
+        std::string name;
+        uint32_t reads;
+        uint32_t writes;
+        bool mainThread;
+        SystemFunc func;
+
+        // dependency level (0 = no dependencies)
+        int level = 0;
+
+        // timing
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+        int64_t runs = 0;
+    };
+
+    std::vector<System> mSystems;
+
+    // system indices per dependency level
+    std::vector<std::vector<size_t>> mLevels;
+    bool mLevelsDirty = true;
+
+    ThreadPool mPool;
+
+public:
+    // workerCount = -1 means hardware_concurrency - 1
+    explicit SystemScheduler(int workerCount = -1) : mPool(workerCount) {}
+
+    ThreadPool& pool() { return mPool; }
+
+    // Adds a system with its read and write sets (Access:: bitmasks)
+    void addSystem(std::string const& name, uint32_t reads, uint32_t writes, SystemFunc const& func, bool mainThread = false);
+
+    // Removes all systems (and their timings)
+    void clear();
+
+    // Executes all systems once
+    void run(float elapsedSeconds);
+
+    // Resets the recorded timings
+    void resetTimings();
+
+    // Writes the per-system timings and dependency levels into the given stream
+    void dumpTimings(std::ostream& oss) const;
+
+private:
+    void buildLevels();
+    void runSystem(System& s, float elapsedSeconds);
+};
@@ -20,6 +20,7 @@ float ai::simpleAI(size_t paddleIdx,
                    const std::vector<Paddle>& allPaddles,
                    const std::vector<Ball>& balls,
                    const Parameters& params,
+                   const BallPrediction& prediction,
                    float elapsedSeconds,
                    glm::vec3& debugColor)
 {
@@ -65,6 +66,7 @@ float ai::task2a(size_t paddleIdx,
                  std::vector<Paddle> const& allPaddles,
                  std::vector<Ball> const& balls,
                  Parameters const& params,
+                 BallPrediction const& prediction,
                  float elapsedSeconds,
                  glm::vec3& debugColor)
 {
@@ -119,6 +121,7 @@ float ai::task2b(size_t paddleIdx,
                  std::vector<Paddle> const& allPaddles,
                  std::vector<Ball> const& balls,
                  Parameters const& params,
+                 BallPrediction const& prediction,
                  float elapsedSeconds,
                  glm::vec3& debugColor)
 {
@@ -187,6 +190,7 @@ float ai::task2c(size_t paddleIdx,
                  std::vector<Paddle> const& allPaddles,
                  std::vector<Ball> const& balls,
                  Parameters const& params,
+                 BallPrediction const& prediction,
                  float elapsedSeconds,
                  glm::vec3& debugColor)
 {
@@ -282,6 +286,7 @@ float ai::task3(size_t paddleIdx,
                 std::vector<Paddle> const& allPaddles,
                 std::vector<Ball> const& balls,
                 Parameters const& params,
+                BallPrediction const& prediction,
                 float elapsedSeconds,
                 glm::vec3& debugColor)
 {
@@ -297,6 +302,8 @@ float ai::task3(size_t paddleIdx,
     ///     - your AI must be fair, i.e. the return value of this method is
     ///       the only way to change the global state (no memhacks, no calling our AI, etc.)
     ///     - you may take a look at simpleAI(). It should be easy to beat if you've done 2a-2c.
+    ///     - `prediction` contains the intercepts of all balls with all paddle faces (see AI.hh),
+    ///       it is computed once per tick and shared by all AIs
     ///
     /// ============= STUDENT CODE BEGIN =============
 
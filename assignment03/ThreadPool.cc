@@ -0,0 +1,125 @@
+#include "ThreadPool.hh"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int workerCount)
+{
+    if (workerCount < 0)
+        workerCount = std::max(1, (int)std::thread::hardware_concurrency()) - 1;
+
+    for (auto i = 0; i < workerCount; ++i)
+        mWorkers.emplace_back([this] { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShutdown = true;
+    }
+    mTaskAvailable.notify_all();
+
+    for (auto& t : mWorkers)
+        t.join();
+}
+
+void ThreadPool::run(std::vector<std::function<void()>> const& tasks)
+{
+    if (tasks.empty())
+        return;
+
+    // no workers or single task: execute directly
+    if (mWorkers.empty() || tasks.size() == 1)
+    {
+        for (auto const& t : tasks)
+            t();
+        return;
+    }
+
+    // tasks and counter live on this stack frame until all tasks are done
+    size_t pending = tasks.size();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto const& t : tasks)
+            mTasks.push({&t, &pending});
+    }
+    mTaskAvailable.notify_all();
+
+    // help out (might execute tasks of other batches as well)
+    while (tryRunTask())
+    {
+    }
+
+    // wait for the rest
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTaskDone.wait(lock, [&pending] { return pending == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, size_t chunkSize, std::function<void(size_t, size_t)> const& f)
+{
+    if (count == 0)
+        return;
+    chunkSize = std::max(chunkSize, size_t(1));
+
+    // single chunk: no need for the pool
+    if (count <= chunkSize)
+    {
+        f(0, count);
+        return;
+    }
+
+    std::vector<std::function<void()>> tasks;
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        auto end = std::min(begin + chunkSize, count);
+        tasks.push_back([&f, begin, end] { f(begin, end); });
+    }
+
+    run(tasks);
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskAvailable.wait(lock, [this] { return mShutdown || !mTasks.empty(); });
+            if (mShutdown && mTasks.empty())
+                return;
+
+            task = mTasks.front();
+            mTasks.pop();
+        }
+
+        execute(task);
+    }
+}
+
+bool ThreadPool::tryRunTask()
+{
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mTasks.empty())
+            return false;
+
+        task = mTasks.front();
+        mTasks.pop();
+    }
+
+    execute(task);
+    return true;
+}
+
+void ThreadPool::execute(Task const& t)
+{
+    (*t.func)();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        --*t.batchPending;
+    }
+    mTaskDone.notify_all();
+}
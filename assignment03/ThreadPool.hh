@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * A simple pool of worker threads
+ *
+ * Tasks are submitted as a batch and the caller blocks (and helps) until all tasks of the batch are done.
+ * The pool is used by the SystemScheduler for running independent systems
+ * and for data-parallel loops within a system (see parallelFor).
+ *
+ * With 0 worker threads, everything is executed on the calling thread.
+ *
+ * Usage:
+ *   ThreadPool pool;
+ *   pool.parallelFor(count, 256, [&](size_t begin, size_t end) { ... });
+ */
+class ThreadPool
+{
+private:
+    std::vector<std::thread> mWorkers;
+
+    struct Task
+    {
+        std::function<void()> const* func;
+        // number of unfinished tasks of the batch this task belongs to
+        size_t* batchPending;
+    };
+
+    std::queue<Task> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    std::condition_variable mTaskDone;
+
+    bool mShutdown = false;
+
+public:
+    // workerCount = -1 means hardware_concurrency - 1
+    explicit ThreadPool(int workerCount = -1);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    size_t getWorkerCount() const { return mWorkers.size(); }
+
+    // Runs all tasks (possibly in parallel) and returns once all are finished
+    // The calling thread executes tasks as well
+    // May be called from within a task (e.g. parallelFor inside a system)
+    void run(std::vector<std::function<void()>> const& tasks);
+
+    // Calls f(begin, end) for disjoint chunks of [0, count) with at most chunkSize elements each
+    // Chunk boundaries only depend on count and chunkSize (not on the number of threads)
+    void parallelFor(size_t count, size_t chunkSize, std::function<void(size_t, size_t)> const& f);
+
+private:
+    void workerLoop();
+
+    // executes one queued task if available, returns false otherwise
+    bool tryRunTask();
+    void execute(Task const& t);
+};
@@ -342,6 +342,9 @@ void Assignment07::init()
     // disable built-in camera handling with left mouse button
     setUseDefaultCameraHandlingLeft(false);
 
+    // chunk meshing logs a lot, write logs on a background thread
+    glow::setLogAsync(true);
+
     GlfwApp::init(); // Call to base GlfwApp
 
     auto texPath = util::pathOf(__FILE__) + "/textures/";
@@ -277,11 +277,14 @@ SharedVertexArray Chunk::buildMeshFor(int mat) const
                     }
             }
 
+    GLOW_COUNTER("vertices built", vertices.size());
+
     if (vertices.empty())
         return nullptr; // no visible faces
 
     auto ab = ArrayBuffer::create(TerrainVertex::attributes());
     ab->bind().setData(vertices);
+    GLOW_COUNTER("bytes uploaded", vertices.size() * sizeof(TerrainVertex));
 
     glow::info() << "Created " << vertices.size() << " verts for mat " << mat << " in chunk " << chunkPos;
     return VertexArray::create(ab);
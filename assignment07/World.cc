@@ -73,6 +73,7 @@ void World::ensureChunkAt(glm::ivec3 p)
 
     // register chunk
     chunks[cp] = c;
+    GLOW_GAUGE("chunks loaded", chunks.size());
 
     // generate/fill chunk
     generate(*c);
@@ -194,6 +195,9 @@ void World::generate(Chunk& c)
                 // assign material
                 c.block(rp).mat = mat ? mat->index : 0;
             }
+
+    GLOW_COUNTER("chunks generated", 1);
+    GLOW_COUNTER("blocks generated", chunkSize * chunkSize * chunkSize);
 }
 
 Chunk* World::queryChunk(glm::ivec3 p) const
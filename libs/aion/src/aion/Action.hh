@@ -23,7 +23,15 @@
     * Supports recursion
     * Supports run-time evaluation (of the current thread)
     * Requires 24 bytes per executed ACTION
-    * No run-time clearing yet
+    * Bounded per-thread ring buffers (see ActionRingBuffer)
+      (overflow policy and capacity via ActionLabel::setOverflowPolicy/setBufferCapacity)
+    * Entries can be drained concurrently via ActionLabel::drainEntries
+    * Optional TSC timestamps (see ActionClock, overhead via aion::dumpActionOverhead)
+    * Timeline export for chrome://tracing / Perfetto via ActionTraceWriter::exportAll
+    * Counter and gauge tracks (AION_COUNTER, AION_GAUGE) on the same per-thread path
+      (stored separately, see ActionLabel::copyAllCounterEntries, ActionTree::addCounters)
+    * Optional sampling profiler (Linux, see ActionSampler), samples are attributed
+      to the innermost open ACTION and the raw call stack (flame graphs)
 
   Usage:
     void foo() {
@@ -38,21 +46,37 @@
         }
 
         // do more stuff
+
+        AION_COUNTER("vertices built", vertices.size()); // adds to a counter
+        AION_GAUGE("chunks loaded", chunks.size());      // sets a gauge
     }
 
   Implementation notes:
     * Per Action storage requirements
-        * starttime: uint64_t
+        * starttime: uint64_t (raw ActionClock ticks)
         * label idx: uint32_t
-        * endtime: uint64_t
+        * endtime: uint64_t (raw ActionClock ticks)
         * end label: uint32_t
         * => 8 + 4 + 8 + 4 = 24 bytes
+    * Per counter value: ticks (8) + label idx (4) + value (8) => 20 bytes
  */
 
 #define ACTION(...)                                                                                                         \
     (void) __VA_ARGS__ " has to be a string literal";                                                                       \
     static aion::ActionLabel AION_MACRO_JOIN(__action_label_, __LINE__){__FILE__, __LINE__, AION_PRETTY_FUNC, "" __VA_ARGS__}; \
     aion::ActionScopeGuard AION_MACRO_JOIN(__action_, __LINE__) { &AION_MACRO_JOIN(__action_label_, __LINE__) }
+
+#define AION_COUNTER(name, value) AION_IMPL_RECORD_VALUE(name, value, aion::LabelKind::Counter)
+#define AION_GAUGE(name, value) AION_IMPL_RECORD_VALUE(name, value, aion::LabelKind::Gauge)
+
+#define AION_IMPL_RECORD_VALUE(name, value, kind)                                                      \
+    do                                                                                                 \
+    {                                                                                                  \
+        (void)name " has to be a string literal";                                                      \
+        static aion::ActionLabel __aion_value_label{__FILE__, __LINE__, AION_PRETTY_FUNC, name, kind}; \
+        __aion_value_label.recordValue((int64_t)(value));                                              \
+    } while (0)
+
 namespace aion
 {
 class ActionScopeGuard
@@ -2,18 +2,21 @@
 
 #include <cassert>
 #include <algorithm>
+#include <iomanip>
 
 #include "ActionTree.hh"
 #include "ActionLabel.hh"
 #include "ActionClass.hh"
+#include "ActionLabelStatistics.hh"
+#include "ActionPathView.hh"
+#include "ActionSampler.hh"
 
 #include "common/auto.hh"
-#include "common/format.hh"
 #include "common/systime.hh"
 
 using namespace aion;
 
-int64_t ActionAnalyzer::percentileNS(int p)
+int64_t ActionAnalyzer::exactPercentileNS(int p)
 {
     assert(0 <= p && p <= 100);
     sortIfRequired();
@@ -22,26 +25,15 @@ int64_t ActionAnalyzer::percentileNS(int p)
 
     assert(idx < mActions.size());
 
-    return mActions[idx]->duration;
+    return mActions[idx].duration();
 }
 
-ActionAnalyzer::ActionAnalyzer(const SharedActionTree &tree, const std::vector<Action *> &actions)
+ActionAnalyzer::ActionAnalyzer(const SharedActionTree &tree, const std::vector<Action> &actions)
   : ActionAnalyzer(tree)
 {
     setActions(actions);
 }
 
-
-ActionAnalyzer::ActionAnalyzer(const SharedActionTree &tree, const std::vector<Action> &actions) : ActionAnalyzer(tree)
-{
-    _ cnt = actions.size();
-    std::vector<Action *> as;
-    as.resize(cnt);
-    for (_ i = 0u; i < cnt; ++i)
-        as[i] = const_cast<Action *>(actions.data() + i); // we're really not changing it, promise!
-    setActions(as);
-}
-
 std::map<ActionLabel *, SharedActionAnalyzer> ActionAnalyzer::byLabel() const
 {
     std::map<ActionLabel *, SharedActionAnalyzer> result;
@@ -49,11 +41,12 @@ std::map<ActionLabel *, SharedActionAnalyzer> ActionAnalyzer::byLabel() const
     for (_ a : mActions)
     {
         // create on demand
-        if (!result.count(a->label))
-            result[a->label] = SharedActionAnalyzer(new ActionAnalyzer(mTree));
+        _ label = a.label();
+        if (!result.count(label))
+            result[label] = SharedActionAnalyzer(new ActionAnalyzer(mTree));
 
         // add action
-        result[a->label]->addAction(a);
+        result[label]->addAction(a);
     }
 
     // init actions
@@ -67,45 +60,22 @@ ActionAnalyzer::ActionAnalyzer(const SharedActionTree &tree) : mTree(tree)
 {
 }
 
-void ActionAnalyzer::setActions(const std::vector<Action *> &actions)
+void ActionAnalyzer::setActions(const std::vector<Action> &actions)
 {
     mActions.assign(actions.begin(), actions.end());
     initActions();
 }
 
-void ActionAnalyzer::addAction(Action *a)
+void ActionAnalyzer::addAction(Action a)
 {
     mActions.push_back(a);
 }
 
 void ActionAnalyzer::initActions()
 {
-    mCount = mActions.size();
-    mSumNs = 0uLL;
-    mVariance = 0.;
-    mMin = std::numeric_limits<decltype(mMin)>::max();
-    mMax = std::numeric_limits<decltype(mMax)>::min();
-
-    if (mCount == 0)
-        return;
-
-    // avg, min, max
+    mStats.clear();
     for (_ a : mActions)
-    {
-        mSumNs += a->duration;
-        if (a->duration > mMax)
-            mMax = a->duration;
-        if (a->duration < mMin)
-            mMin = a->duration;
-    }
-    _ avg = mSumNs / double(mCount);
-
-    // variance
-    for (_ a : mActions)
-    {
-        _ diff = a->duration - avg;
-        mVariance += diff * diff;
-    }
+        mStats.add(a.duration());
 }
 
 void ActionAnalyzer::sortIfRequired()
@@ -113,9 +83,9 @@ void ActionAnalyzer::sortIfRequired()
     if (mSorted)
         return;
 
-    std::sort(begin(mActions), end(mActions), [](Action *l, Action *r)
+    std::sort(begin(mActions), end(mActions), [](Action l, Action r)
               {
-                  return l->duration < r->duration;
+                  return l.duration() < r.duration();
               });
 
     mSorted = true;
@@ -125,20 +95,27 @@ void ActionAnalyzer::dumpSummary(std::ostream &oss, bool verbose)
 {
     const _ verboseMax = 10u;
 
+    // streaming statistics, no tree required
+    // (thread buffers are processed chunk-wise, the recording is never copied as a whole)
     // important: entries first, labels 2nd
-    _ allEntries = ActionLabel::copyAllEntries();
+    ActionLabelStatistics stats;
+    stats.update();
     _ allLabels = ActionLabel::getAllLabels();
-    _ allTree = ActionTree::construct(allEntries, allLabels);
-    ActionAnalyzer allAnalyzer(allTree, allTree->getActions());
+
+    _ dropped = ActionLabel::getDroppedEntryCount();
+    if (dropped > 0)
+        oss << "WARNING: " << dropped << " entries were dropped due to full buffers\n";
 
     { // per label
-        _ labelMap = allAnalyzer.byLabel();
-        std::vector<std::pair<ActionLabel *, SharedActionAnalyzer>> labels(begin(labelMap), end(labelMap));
+        std::vector<std::pair<ActionLabel *, ActionStatistics const *>> labels;
+        for (_ i = 0u; i < stats.getLabels().size(); ++i)
+            if (stats.getLabels()[i].count() > 0)
+                labels.push_back({allLabels[i], &stats.getLabels()[i]});
         _ cnt = verbose || labels.size() < verboseMax ? labels.size() : verboseMax;
 
         oss << "Labels (by total time):\n";
-        std::sort(begin(labels), end(labels), [](std::pair<ActionLabel *, SharedActionAnalyzer> const &l,
-                                                 std::pair<ActionLabel *, SharedActionAnalyzer> const &r)
+        std::sort(begin(labels), end(labels), [](std::pair<ActionLabel *, ActionStatistics const *> const &l,
+                                                 std::pair<ActionLabel *, ActionStatistics const *> const &r)
                   {
                       return l.second->totalTimeNS() > r.second->totalTimeNS();
                   });
@@ -147,9 +124,8 @@ void ActionAnalyzer::dumpSummary(std::ostream &oss, bool verbose)
         for (_ i = 0u; i < cnt; ++i)
         {
             nameLength = std::max(nameLength, (int)labels[i].first->shortDesc().size());
-            cntLength = std::max(cntLength, (int)aion_fmt::format("{}", labels[i].second->count()).size());
+            cntLength = std::max(cntLength, (int)std::to_string(labels[i].second->count()).size());
         }
-        _ cntFmt = "{:" + aion_fmt::format("{}", cntLength) + "}";
 
         for (_ i = 0u; i < cnt; ++i)
         {
@@ -157,8 +133,8 @@ void ActionAnalyzer::dumpSummary(std::ostream &oss, bool verbose)
             _ const &a = labels[i].second;
             _ desc = l->shortDesc();
             oss << "  " << desc << std::string(nameLength - desc.size(), ' ') << "   ";
-            oss << aion_fmt::format(cntFmt, a->count()) << "x ";
-            aion_systime::formatHuman(a->averageNS(), oss);
+            oss << std::setw(cntLength) << a->count() << "x ";
+            aion_systime::formatHuman((int64_t)a->averageNS(), oss);
             oss << " = ";
             aion_systime::formatHuman(a->totalTimeNS(), oss);
             oss << " (";
@@ -166,8 +142,91 @@ void ActionAnalyzer::dumpSummary(std::ostream &oss, bool verbose)
             oss << " ~ ";
             aion_systime::formatHuman(a->maxNS(), oss);
             oss << ", ±";
-            aion_systime::formatHuman(a->standardDeviationNS(), oss);
+            aion_systime::formatHuman((int64_t)a->standardDeviationNS(), oss);
+            oss << ", p50 ";
+            aion_systime::formatHuman(a->quantileNS(0.5), oss);
+            oss << ", p99 ";
+            aion_systime::formatHuman(a->quantileNS(0.99), oss);
             oss << ")\n";
         }
     }
+
+    { // counters and gauges
+        _ counters = ActionLabel::copyAllCounterEntries();
+        _ summaries = std::vector<ActionTree::CounterSummary>{};
+        _ lastTimes = std::vector<int64_t>{};
+        for (_ const &c : counters)
+        {
+            if (c.labelIdx >= (int)allLabels.size())
+                continue;
+            _ l = allLabels[c.labelIdx];
+            _ s = std::find_if(begin(summaries), end(summaries), [l](ActionTree::CounterSummary const &s)
+                               {
+                                   return s.label == l;
+                               });
+            if (s == end(summaries))
+            {
+                summaries.push_back({l, 0, 0, 0});
+                lastTimes.push_back(INT64_MIN);
+                s = end(summaries) - 1;
+            }
+            ++s->count;
+            s->sum += c.value;
+
+            // entries are only ordered per thread
+            _ &lastTime = lastTimes[s - begin(summaries)];
+            if (c.timestamp() >= lastTime)
+            {
+                lastTime = c.timestamp();
+                s->last = c.value;
+            }
+        }
+
+        if (!summaries.empty())
+        {
+            oss << "Counters:\n";
+            for (_ const &s : summaries)
+            {
+                oss << "  " << s.label->shortDesc() << "   " << s.count << " values, ";
+                if (s.label->getKind() == LabelKind::Gauge)
+                    oss << "last " << s.last << "\n";
+                else
+                    oss << "total " << s.sum << "\n";
+            }
+        }
+    }
+
+    { // sampling profiler
+        _ samples = ActionLabel::copyAllSamples();
+        if (!samples.empty())
+        {
+            // samples might reference labels created after the first query
+            ActionSampler::dumpSummary(oss, samples, ActionLabel::getAllLabels(), verbose ? 50 : verboseMax);
+        }
+    }
+
+    { // per thread
+        _ names = ActionLabel::getThreadNames();
+
+        oss << "Threads:\n";
+        for (_ i = 0u; i < names.size(); ++i)
+        {
+            _ cnt = i < stats.threadCount() ? stats.threadActionCount(i) : 0;
+            _ time = i < stats.threadCount() ? stats.threadTopLevelNS(i) : 0;
+            oss << "  " << names[i] << ": " << cnt << " actions, ";
+            aion_systime::formatHuman(time, oss);
+            oss << " in top-level actions\n";
+        }
+    }
+
+    if (verbose) // merged over all threads
+    {
+        // (the path view needs a tree, i.e. only the verbose summary copies all entries)
+        _ allEntries = ActionLabel::copyAllEntries();
+        _ allTree = ActionTree::construct(allEntries, ActionLabel::getAllLabels());
+        ActionPathView view;
+        view.add(*allTree);
+        oss << "Call paths:\n";
+        view.dump(oss);
+    }
 }
@@ -9,16 +9,20 @@
 #include "common/property.hh"
 #include "common/shared.hh"
 
+#include "ActionClass.hh"
+#include "ActionStatistics.hh"
+
 namespace aion
 {
-class Action;
 class ActionLabel;
 AION_SHARED(class, ActionTree);
 AION_SHARED(class, ActionAnalyzer);
 
 /// Light class for analyzing a number of actions
 /// Does pin the tree so should be relatively resistant
-/// Moment-based statistics are calculated immidiately, percentile-based ones are deferred (except min/max)
+/// Moments and a quantile sketch are calculated immidiately (percentiles have a relative error of ~1%)
+/// Exact percentiles are deferred (sorting)
+/// For per-label statistics without tree, see ActionLabelStatistics
 /// Should not be used/trusted with zero entries
 /// Times are either in NS or Secs
 class ActionAnalyzer
@@ -28,43 +32,46 @@ private:
     SharedActionTree mTree;
 
     /// analyzed actions
-    std::vector<Action*> mActions;
+    std::vector<Action> mActions;
 
     /// true iff actions already sorted
     bool mSorted = false;
 
-    /// statistical moments
-    int64_t mCount;
-    int64_t mSumNs;
-    double mVariance;
-    int64_t mMin;
-    int64_t mMax;
+    /// statistical moments and quantile sketch
+    ActionStatistics mStats;
 
 public: // properties
     AION_GETTER(Tree);
     AION_GETTER(Actions);
 
-    int64_t count() const { return mCount; }
-    int64_t totalTimeNS() const { return mSumNs; }
-    double totalTime() const { return mSumNs * 1.e-9; }
-    double averageNS() const { return mCount == 0 ? 0LL : mSumNs / mCount; }
+    ActionStatistics const& statistics() const { return mStats; }
+
+    int64_t count() const { return mStats.count(); }
+    int64_t totalTimeNS() const { return mStats.totalTimeNS(); }
+    double totalTime() const { return totalTimeNS() * 1.e-9; }
+    double averageNS() const { return mStats.averageNS(); }
     double average() const { return averageNS() * 1.e-9; }
-    double varianceNS() const { return mVariance; }
-    double variance() const { return mVariance * 1.e-18; }
-    double standardDeviationNS() const { return std::sqrt(mVariance); }
-    double standardDeviation() const { return std::sqrt(mVariance) * 1.e-9; }
-    int64_t minNS() const { return mMin; }
-    double min() const { return mMin * 1.e-9; }
-    int64_t maxNS() const { return mMax; }
-    double max() const { return mMax * 1.e-9; }
+    double varianceNS() const { return mStats.varianceNS(); }
+    double variance() const { return varianceNS() * 1.e-18; }
+    double standardDeviationNS() const { return mStats.standardDeviationNS(); }
+    double standardDeviation() const { return standardDeviationNS() * 1.e-9; }
+    int64_t minNS() const { return mStats.minNS(); }
+    double min() const { return minNS() * 1.e-9; }
+    int64_t maxNS() const { return mStats.maxNS(); }
+    double max() const { return maxNS() * 1.e-9; }
     /// returns the p-th percentile (p in [0, 100])
-    int64_t percentileNS(int p);
-    double percentile(int p) { return percentileNS(p) * 1.e-9; }
-    int64_t medianNS() { return percentileNS(50); }
-    double median() { return medianNS() * 1.e-9; }    
+    /// APPROXIMATE: read from the DDSketch of ActionStatistics (relative error ~1%, see QuantileSketch)
+    /// use exactPercentileNS for the exact value
+    int64_t percentileNS(double p) const { return mStats.quantileNS(p / 100.0); }
+    double percentile(double p) const { return percentileNS(p) * 1.e-9; }
+    int64_t medianNS() const { return percentileNS(50); }
+    double median() const { return medianNS() * 1.e-9; }
+    /// returns the exact p-th percentile (p in [0, 100]), sorts all actions on first call
+    int64_t exactPercentileNS(int p);
+
 public:
     /// generic constructor for a given set of actions
-    ActionAnalyzer(SharedActionTree const& tree, std::vector<Action*> const& actions);
+    /// e.g. ActionAnalyzer(tree, tree->getActions())
     ActionAnalyzer(SharedActionTree const& tree, std::vector<Action> const& actions);
 
     ActionAnalyzer(ActionAnalyzer&&) = default;     // move yes
@@ -78,8 +85,8 @@ private:
     ActionAnalyzer(SharedActionTree const& tree);
 
     /// sets actions and does basic math
-    void setActions(std::vector<Action*> const& actions);
-    void addAction(Action* a);
+    void setActions(std::vector<Action> const& actions);
+    void addAction(Action a);
     void initActions();
 
     /// sorts the actions by duration if not already done
@@ -87,6 +94,7 @@ private:
 
 public:
     /// dumps a summary of all actions into the given stream
+    /// (streams the recorded entries, p50/p99 are DDSketch approximations)
     static void dumpSummary(std::ostream& oss, bool verbose);
 };
 }
@@ -0,0 +1,259 @@
+#include "ActionBenchmark.hh"
+
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "common/auto.hh"
+#include "common/checked_format.hh"
+#include "common/MessageQueue.hh"
+#include "common/format.hh"
+
+#include "ActionRingBuffer.hh"
+
+using namespace aion;
+
+double aion::measureActionOverhead(TimestampSource source, size_t scopes)
+{
+    if (source == TimestampSource::TSC && !ActionClock::isTSCAvailable())
+        return -1.0;
+
+    // DropOldest with a small buffer: overflow handling is part of the measured cost
+    ActionRingBuffer buffer(1 << 16, OverflowPolicy::DropOldest);
+
+    // warm up (page faults)
+    for (_ i = 0u; i < buffer.capacity(); ++i)
+        buffer.pushEnd(ActionClock::now(source));
+
+    _ start = std::chrono::steady_clock::now();
+    for (_ i = size_t{0}; i < scopes; ++i)
+    {
+        buffer.pushStart(ActionClock::now(source), 0);
+        buffer.pushEnd(ActionClock::now(source));
+    }
+    _ end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / double(scopes);
+}
+
+void aion::dumpActionOverhead(std::ostream &oss, size_t scopes)
+{
+    oss << "ACTION overhead (" << scopes << " scopes):\n";
+
+    oss << "  Monotonic: " << measureActionOverhead(TimestampSource::Monotonic, scopes) << " ns/scope\n";
+
+    _ tsc = measureActionOverhead(TimestampSource::TSC, scopes);
+    if (tsc < 0)
+        oss << "  TSC: not available (no invariant TSC)\n";
+    else
+        oss << "  TSC: " << tsc << " ns/scope\n";
+
+    oss << "  active source: " << (ActionClock::getSource() == TimestampSource::TSC ? "TSC" : "Monotonic") << "\n";
+}
+
+namespace
+{
+/// ns per call of f(i)
+template <class F>
+double measureNs(size_t lines, F &&f)
+{
+    _ start = std::chrono::steady_clock::now();
+    for (_ i = size_t{0}; i < lines; ++i)
+        f(i);
+    _ end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / double(lines);
+}
+}
+
+void aion::dumpFormatOverhead(std::ostream &oss, size_t lines)
+{
+    oss << "Formatting overhead (" << lines << " lines):\n";
+
+    // consumes the output (and prevents it from being optimized away)
+    _ checksum = size_t{0};
+
+    { // summary dump: formatHuman into a stream
+        std::ostringstream out;
+        _ reset = [&]
+        {
+            checksum += (size_t)out.tellp();
+            out.seekp(0);
+        };
+
+        _ fmt = measureNs(lines, [&](size_t i)
+                          {
+                              out << aion_fmt::format("{:6.2f}ms", (double)i / 1000.);
+                              reset();
+                          });
+        _ sstream = measureNs(lines, [&](size_t i)
+                              {
+                                  out << std::fixed << std::setprecision(2) << std::setw(6) << (double)i / 1000. << "ms";
+                                  reset();
+                              });
+        _ formatTo = measureNs(lines, [&](size_t i)
+                               {
+                                   aion::formatTo(out, AION_FMT("{:6.2f}ms"), (double)i / 1000.);
+                                   reset();
+                               });
+
+        oss << "  summary time (stream): aion_fmt::format " << fmt << " ns, std::ostream " << sstream << " ns, formatTo " << formatTo
+            << " ns\n";
+    }
+
+    { // log line: formatted into a buffer
+        std::string name = "chunk";
+        std::string reused;
+        StackFormatBuffer<256> buffer;
+
+        _ fmt = measureNs(lines, [&](size_t i)
+                          {
+                              checksum += aion_fmt::format("Created {} verts for mat {} in {} {}", i, i % 7, name, (int)i).size();
+                          });
+        _ sstream = measureNs(lines, [&](size_t i)
+                              {
+                                  std::ostringstream line;
+                                  line << "Created " << i << " verts for mat " << i % 7 << " in " << name << " " << (int)i;
+                                  checksum += line.str().size();
+                              });
+        _ stack = measureNs(lines, [&](size_t i)
+                            {
+                                buffer.clear();
+                                formatTo(buffer, AION_FMT("Created {} verts for mat {} in {} {}"), i, i % 7, name, (int)i);
+                                checksum += buffer.size();
+                            });
+        _ string = measureNs(lines, [&](size_t i)
+                             {
+                                 reused.clear();
+                                 formatTo(reused, AION_FMT("Created {} verts for mat {} in {} {}"), i, i % 7, name, (int)i);
+                                 checksum += reused.size();
+                             });
+
+        oss << "  log line: aion_fmt::format " << fmt << " ns, std::ostringstream " << sstream << " ns, formatTo (stack buffer) " << stack
+            << " ns, formatTo (reused string) " << string << " ns\n";
+    }
+
+    oss << "  (checksum " << checksum << ")\n";
+}
+
+namespace
+{
+/// message of the queue benchmarks (sender and per-sender sequence number)
+struct QueueMessage
+{
+    int producer;
+    size_t seq;
+};
+}
+
+bool aion::checkMessageQueue(std::ostream &oss, int producers, size_t messages)
+{
+    MessageQueue<QueueMessage> queue;
+    _ total = producers * messages;
+
+    std::vector<std::thread> threads;
+    for (_ p = 0; p < producers; ++p)
+        threads.emplace_back([&queue, p, messages]
+                             {
+                                 for (_ i = size_t{0}; i < messages; ++i)
+                                     queue.send({p, i});
+                             });
+
+    _ ok = true;
+    _ next = std::vector<size_t>(producers, 0);
+    _ received = size_t{0};
+    std::vector<QueueMessage> msgs;
+    while (received < total && ok)
+    {
+        // single waits and bulk drains
+        if (received % 3 == 0)
+        {
+            QueueMessage m;
+            if (!queue.receiveWait(m, 1000))
+            {
+                oss << "  MessageQueue: no message after 1s (" << received << " of " << total << " received)\n";
+                ok = false;
+                break;
+            }
+            msgs.push_back(m);
+        }
+        else
+            queue.drain(msgs);
+
+        // can only exceed the number of unreceived messages by senders between counting and linking
+        _ size = queue.size();
+        if (size > total - received)
+        {
+            oss << "  MessageQueue: size() is " << size << " with " << total - received << " messages left\n";
+            ok = false;
+        }
+
+        for (_ const &m : msgs)
+        {
+            if (m.producer < 0 || m.producer >= producers || m.seq != next[m.producer])
+            {
+                oss << "  MessageQueue: message " << m.seq << " of producer " << m.producer << " out of order\n";
+                ok = false;
+                break;
+            }
+            ++next[m.producer];
+            ++received;
+        }
+        msgs.clear();
+    }
+
+    for (_ &t : threads)
+        t.join();
+
+    if (ok && (queue.size() != 0 || queue.hasMessage()))
+    {
+        oss << "  MessageQueue: " << queue.size() << " messages left after receiving all\n";
+        ok = false;
+    }
+
+    oss << "MessageQueue stress test (" << producers << " producers, " << messages << " messages each): " << (ok ? "ok" : "FAILED") << "\n";
+    return ok;
+}
+
+void aion::dumpMessageQueueScaling(std::ostream &oss, size_t messages)
+{
+    oss << "MessageQueue throughput (" << messages << " messages per producer, " << std::thread::hardware_concurrency()
+        << " hardware threads):\n";
+
+    for (_ producers : {1, 2, 4, 8})
+    {
+        MessageQueue<QueueMessage> queue;
+        _ total = producers * messages;
+
+        _ start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (_ p = 0; p < producers; ++p)
+            threads.emplace_back([&queue, p, messages]
+                                 {
+                                     for (_ i = size_t{0}; i < messages; ++i)
+                                         queue.send({p, i});
+                                 });
+
+        _ received = size_t{0};
+        std::vector<QueueMessage> msgs;
+        while (received < total)
+        {
+            QueueMessage m;
+            if (!queue.receiveWait(m))
+                continue;
+            msgs.clear();
+            queue.drain(msgs);
+            received += 1 + msgs.size();
+        }
+        _ end = std::chrono::steady_clock::now();
+
+        for (_ &t : threads)
+            t.join();
+
+        _ secs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+        oss << "  " << producers << " producers: " << total / secs / 1e6 << " M messages/s\n";
+    }
+}
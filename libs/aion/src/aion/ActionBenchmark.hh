@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+#include "ActionClock.hh"
+
+namespace aion
+{
+/**
+ * Overhead measurement of the action recording path
+ *
+ * A scope is emulated as start timestamp + push + end timestamp + push into a private ring buffer
+ * (i.e. everything ACTION() does except the thread-local buffer lookup)
+ * Does not record any actions and does not lock the timestamp source.
+ *
+ * Usage:
+ *   aion::dumpActionOverhead(std::cout);
+ */
+
+/// average ns per ACTION scope with the given source, negative if the source is not available
+double measureActionOverhead(TimestampSource source, size_t scopes = 1 << 22);
+
+/// measures and prints the overhead of all timestamp sources
+void dumpActionOverhead(std::ostream& oss, size_t scopes = 1 << 22);
+
+/// compares aion_fmt::format, std::ostringstream and formatTo (common/checked_format.hh)
+/// for a summary dump time ("{:6.2f}ms") and a log line (ns per formatted line)
+void dumpFormatOverhead(std::ostream& oss, size_t lines = 1 << 18);
+
+/// stress test of MessageQueue: 'producers' threads send 'messages' each while one reader mixes receiveWait and drain
+/// checks per-producer order, counts and size(), prints failures and returns false on any
+/// (build with -fsanitize=thread to check for data races)
+bool checkMessageQueue(std::ostream& oss, int producers = 4, size_t messages = 1 << 16);
+
+/// prints MessageQueue throughput (messages/s) for 1, 2, 4 and 8 producers sending 'messages' each
+void dumpMessageQueueScaling(std::ostream& oss, size_t messages = 1 << 20);
+}
@@ -1,10 +1,27 @@
 #include "ActionClass.hh"
 
+#include <algorithm>
+
 #include "ActionLabel.hh"
 
 using namespace aion;
 
+int32_t ActionNodes::threadOf(int32_t idx) const
+{
+    return int32_t(std::upper_bound(begin(threadBegin), end(threadBegin), idx) - begin(threadBegin)) - 1;
+}
+
+int32_t ActionNodes::subtreeEnd(int32_t idx) const
+{
+    // next sibling of the action or its closest ancestor
+    auto a = idx;
+    while (a >= 0 && nextSibling[a] < 0)
+        a = parent[a];
+
+    return a >= 0 ? nextSibling[a] : threadBegin[threadOf(idx) + 1];
+}
+
 const std::string &Action::name() const
 {
-    return label->getName();
+    return label()->getName();
 }
@@ -2,28 +2,77 @@
 
 #include <cstdint>
 #include <string>
-
-#include "common/shared.hh"
+#include <vector>
 
 namespace aion
 {
 class ActionLabel;
 
-AION_SHARED(class, ActionTree);
+/**
+ * @brief Node storage of an ActionTree (structure of arrays)
+ *
+ * 32 bytes per action, no per-node allocations or shared ownership.
+ * Actions of one thread are consecutive and in pre-order,
+ * i.e. every subtree is the contiguous index range [idx, subtreeEnd(idx)).
+ * Indices are 32 bit, -1 means none.
+ */
+struct ActionNodes
+{
+    std::vector<int64_t> start;
+    std::vector<int64_t> duration;
+    /// index into 'labels'
+    std::vector<int32_t> label;
+    std::vector<int32_t> parent;
+    std::vector<int32_t> firstChild;
+    std::vector<int32_t> nextSibling;
+
+    /// actions of thread t are [threadBegin[t], threadBegin[t + 1])
+    std::vector<int32_t> threadBegin;
+
+    std::vector<ActionLabel*> labels;
+
+    size_t size() const { return start.size(); }
+    int32_t threadCount() const { return threadBegin.empty() ? 0 : (int32_t)threadBegin.size() - 1; }
+
+    /// recording thread of an action (binary search)
+    int32_t threadOf(int32_t idx) const;
+    /// end (exclusive) of the subtree of an action
+    int32_t subtreeEnd(int32_t idx) const;
+};
 
-/// Only valid for within parent tree
+/// Handle to an action of an ActionTree (cheap to copy)
+/// Only valid while its tree (or a scoped view of it) lives
 class Action
 {
+private:
+    ActionNodes const* mNodes = nullptr;
+    int32_t mIdx = -1;
+
 public:
-    int64_t starttime = -1;
-    int64_t endtime = -1;
-    int64_t duration = -1;
-    ActionLabel* label;
-    Action* parent = nullptr;
-    Action* firstChild = nullptr;
-    Action* nextSibling = nullptr;
-    WeakActionTree tree;
+    Action() = default;
+    Action(ActionNodes const* nodes, int32_t idx) : mNodes(nodes), mIdx(idx) {}
+
+    bool isValid() const { return mIdx >= 0; }
+    explicit operator bool() const { return isValid(); }
+
+    ActionNodes const* nodes() const { return mNodes; }
+    int32_t index() const { return mIdx; }
+
+    int64_t starttime() const { return mNodes->start[mIdx]; }
+    int64_t duration() const { return mNodes->duration[mIdx]; }
+    int64_t endtime() const { return starttime() + duration(); }
+    ActionLabel* label() const { return mNodes->labels[mNodes->label[mIdx]]; }
+    /// index of the recording thread
+    int32_t thread() const { return mNodes->threadOf(mIdx); }
+
+    /// invalid if none
+    Action parent() const { return {mNodes, mNodes->parent[mIdx]}; }
+    Action firstChild() const { return {mNodes, mNodes->firstChild[mIdx]}; }
+    Action nextSibling() const { return {mNodes, mNodes->nextSibling[mIdx]}; }
 
     std::string const& name() const;
+
+    bool operator==(Action const& rhs) const { return mNodes == rhs.mNodes && mIdx == rhs.mIdx; }
+    bool operator!=(Action const& rhs) const { return !operator==(rhs); }
 };
 }
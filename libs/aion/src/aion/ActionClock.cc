@@ -0,0 +1,138 @@
+#include "ActionClock.hh"
+
+#include <mutex>
+
+#ifdef _MSC_VER
+#include <Windows.h>
+#else
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#endif
+
+#include "common/auto.hh"
+
+using namespace aion;
+
+std::atomic<bool> ActionClock::sUseTSC{false};
+
+namespace
+{
+std::mutex sClockLock;
+std::atomic<bool> sSourceLocked{false};
+
+#ifdef _MSC_VER
+LARGE_INTEGER sFrequency; // null init
+#endif
+
+// TSC calibration: ns = sMonoBase + (tsc - sTSCBase) * sNsPerTick
+uint64_t sTSCBase = 0;
+int64_t sMonoBase = 0;
+double sNsPerTick = 0.0;
+}
+
+#ifdef _MSC_VER
+uint64_t ActionClock::readMonotonic()
+{
+    LARGE_INTEGER time;
+    QueryPerformanceCounter(&time);
+    return time.QuadPart;
+}
+#endif
+
+int64_t ActionClock::monotonicToNanoseconds(uint64_t ticks)
+{
+#ifdef _MSC_VER
+    if (sFrequency.QuadPart == 0)
+        QueryPerformanceFrequency(&sFrequency);
+    return int64_t(ticks / sFrequency.QuadPart) * 1000000000LL + int64_t(ticks % sFrequency.QuadPart) * 1000000000LL / sFrequency.QuadPart;
+#else
+    return int64_t(ticks);
+#endif
+}
+
+int64_t ActionClock::toNanoseconds(uint64_t ticks)
+{
+    // (acquire: pairs with the release in setSource, i.e. the calibration below is visible)
+    if (!sUseTSC.load(std::memory_order_acquire))
+        return monotonicToNanoseconds(ticks);
+
+    // signed delta: entries might have been recorded before calibration finished
+    return sMonoBase + int64_t(double(int64_t(ticks - sTSCBase)) * sNsPerTick);
+}
+
+bool ActionClock::setSource(TimestampSource source)
+{
+    std::lock_guard<std::mutex> lock(sClockLock);
+
+    if (sSourceLocked)
+        return getSource() == source;
+
+    if (source == TimestampSource::TSC)
+    {
+        if (!isTSCAvailable())
+            return false;
+        if (sNsPerTick == 0.0)
+            calibrateTSC();
+    }
+
+    sUseTSC.store(source == TimestampSource::TSC, std::memory_order_release);
+    return true;
+}
+
+bool ActionClock::isTSCAvailable()
+{
+#ifdef AION_HAS_TSC
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if ((unsigned)regs[0] < 0x80000007u)
+        return false;
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0; // EDX bit 8: invariant TSC
+#else
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007u)
+        return false;
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return (edx & (1 << 8)) != 0; // EDX bit 8: invariant TSC
+#endif
+#else
+    return false;
+#endif
+}
+
+void ActionClock::calibrateTSC()
+{
+    // TSC read is bracketed by two monotonic reads, the midpoint is used as reference
+    _ sample = [](uint64_t &tsc, int64_t &mono)
+    {
+        _ m0 = monotonicToNanoseconds(readMonotonic());
+        tsc = readTSC();
+        _ m1 = monotonicToNanoseconds(readMonotonic());
+        mono = m0 + (m1 - m0) / 2;
+    };
+
+    uint64_t tsc0, tsc1;
+    int64_t mono0, mono1;
+    sample(tsc0, mono0);
+    do
+    {
+        sample(tsc1, mono1);
+    } while (mono1 - mono0 < 10000000LL); // 10ms
+
+    sTSCBase = tsc0;
+    sMonoBase = mono0;
+    sNsPerTick = double(mono1 - mono0) / double(tsc1 - tsc0);
+}
+
+double ActionClock::getTSCTicksPerNanosecond()
+{
+    return sNsPerTick > 0.0 ? 1.0 / sNsPerTick : 0.0;
+}
+
+void ActionClock::lockSource()
+{
+    std::lock_guard<std::mutex> lock(sClockLock);
+    sSourceLocked = true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// (no <Windows.h> here, QueryPerformanceCounter is called in ActionClock.cc)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <ctime>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AION_HAS_TSC 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define AION_HAS_TSC 1
+#endif
+
+namespace aion
+{
+enum class TimestampSource
+{
+    /// CLOCK_MONOTONIC (QueryPerformanceCounter on Windows)
+    Monotonic,
+    /// invariant time stamp counter (rdtsc), calibrated against Monotonic
+    TSC
+};
+
+/**
+ * @brief Timestamp source for action recording
+ *
+ * Entries store raw 64-bit ticks of the active source.
+ * Ticks are only converted to nanoseconds when entries are copied or drained for analysis.
+ *
+ * The source can only be changed before the first action is recorded:
+ *   aion::ActionClock::setSource(aion::TimestampSource::TSC); // early in main()
+ */
+class ActionClock
+{
+private:
+    /// only written in setSource (before the first entry is recorded), read by all recording threads
+    static std::atomic<bool> sUseTSC;
+
+public:
+    /// raw ticks of the active source
+    static uint64_t now() { return sUseTSC.load(std::memory_order_relaxed) ? readTSC() : readMonotonic(); }
+    /// raw ticks of the given source (TSC must be available)
+    static uint64_t now(TimestampSource source) { return source == TimestampSource::TSC ? readTSC() : readMonotonic(); }
+
+    /// converts raw ticks of the active source to nanoseconds (on the CLOCK_MONOTONIC time line)
+    static int64_t toNanoseconds(uint64_t ticks);
+
+    static TimestampSource getSource() { return sUseTSC.load() ? TimestampSource::TSC : TimestampSource::Monotonic; }
+    /// returns false if the source is not available or recording has already started
+    /// (calibrates the TSC on first use, takes ~10ms)
+    static bool setSource(TimestampSource source);
+
+    /// true iff the CPU reports an invariant TSC
+    static bool isTSCAvailable();
+    /// (re-)calibrates the TSC against CLOCK_MONOTONIC
+    static void calibrateTSC();
+    /// 0 if not calibrated
+    static double getTSCTicksPerNanosecond();
+
+    /// called when the first entry is recorded, afterwards the source is fixed
+    static void lockSource();
+
+private:
+#ifdef _MSC_VER
+    static uint64_t readMonotonic();
+#else
+    static uint64_t readMonotonic()
+    {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        return t.tv_sec * 1000000000ULL + t.tv_nsec;
+    }
+#endif
+
+    static uint64_t readTSC()
+    {
+#ifdef AION_HAS_TSC
+        return __rdtsc();
+#else
+        return readMonotonic();
+#endif
+    }
+
+    static int64_t monotonicToNanoseconds(uint64_t ticks);
+};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 namespace aion
 {
@@ -13,6 +14,45 @@ struct ActionEntry
     /// Careful, this index is only valid in current program run
     int32_t labelIdx;
 
+    /// index of the recording thread (see ActionLabel::getThreadNames)
+    int32_t threadIdx;
+
+    int64_t timestamp() const { return secs * 1000000000LL + nsecs; }
+};
+
+/// recorded value of a counter or gauge (see AION_COUNTER, AION_GAUGE)
+struct CounterEntry
+{
+    int32_t secs;
+    int32_t nsecs;
+
+    /// label of the counter (ActionLabel::getKind() is Counter or Gauge)
+    int32_t labelIdx;
+
+    /// index of the recording thread
+    int32_t threadIdx;
+
+    /// increment (Counter) or current value (Gauge)
+    int64_t value;
+
+    int64_t timestamp() const { return secs * 1000000000LL + nsecs; }
+};
+
+/// sampled call stack (see ActionSampler)
+struct SampleEntry
+{
+    int32_t secs;
+    int32_t nsecs;
+
+    /// innermost ACTION running while sampled, -1 if none
+    int32_t labelIdx;
+
+    /// index of the recording thread
+    int32_t threadIdx;
+
+    /// return addresses, innermost first (frames[0] is the interrupted instruction)
+    std::vector<uint64_t> frames;
+
     int64_t timestamp() const { return secs * 1000000000LL + nsecs; }
 };
 }
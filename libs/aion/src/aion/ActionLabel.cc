@@ -1,18 +1,20 @@
 #include "ActionLabel.hh"
 
-#include "common/format.hh"
+#include "common/checked_format.hh"
 
 #include <string>
 #include <algorithm>
 #include <vector>
 #include <mutex>
 
+#include "ActionClock.hh"
 #include "ActionEntry.hh"
+#include "ActionRingBuffer.hh"
+#include "ActionSampler.hh"
 
 using namespace aion;
 
 #ifdef _MSC_VER
-#include <Windows.h>
 #define AION_THREADLOCAL __declspec(thread)
 #else
 #define AION_THREADLOCAL __thread // GCC 4.7 has no thread_local yet
@@ -20,28 +22,34 @@ using namespace aion;
 
 namespace
 {
-AION_THREADLOCAL std::vector<ActionEntry> *sEntries = nullptr;
+AION_THREADLOCAL ActionRingBuffer *sEntries = nullptr;
 std::mutex sLabelLock;
 std::vector<ActionLabel *> sLabels;
-std::vector<std::vector<ActionEntry> *> sEntriesPerThread;
+std::vector<ActionRingBuffer *> sEntriesPerThread;
+std::vector<std::string> sThreadNames;
 
-#if _MSC_VER
-LARGE_INTEGER sFrequency; // null init
-#endif
+// settings for new buffers
+size_t sBufferCapacity = 1 << 20;
+OverflowPolicy sOverflowPolicy = OverflowPolicy::DropOldest;
 
-void writeTime(ActionEntry &e)
+/// CAUTION: sLabelLock must be held
+void createThreadBuffer()
 {
-#if _MSC_VER
-    LARGE_INTEGER time;
-    QueryPerformanceCounter(&time);
-    e.secs = int32_t(time.QuadPart / sFrequency.QuadPart);
-    e.nsecs = int32_t((time.QuadPart % sFrequency.QuadPart) * 1000000000LL / sFrequency.QuadPart);
-#else
-    struct timespec t;
-    clock_gettime(CLOCK_MONOTONIC, &t);
-    e.secs = t.tv_sec;
-    e.nsecs = t.tv_nsec;
-#endif
+    sEntries = new ActionRingBuffer(sBufferCapacity, sOverflowPolicy, (int32_t)sEntriesPerThread.size());
+    sEntriesPerThread.push_back(sEntries);
+    sThreadNames.push_back(formatString(AION_FMT("Thread {}"), sThreadNames.size()));
+
+    // sampling timers are per thread
+    ActionSampler::registerThread(sEntries);
+}
+
+/// copy of the buffer list, the buffers itself are never deleted
+std::vector<ActionRingBuffer *> allBuffers()
+{
+    sLabelLock.lock();
+    auto buffers = sEntriesPerThread;
+    sLabelLock.unlock();
+    return buffers;
 }
 }
 
@@ -59,7 +67,7 @@ std::string ActionLabel::shortDesc() const
     else
         name = "\"" + name + "\"";
 
-    return aion_fmt::format("{}, {}:{}", name, filename, mLine);
+    return formatString(AION_FMT("{}, {}:{}"), name, filename, mLine);
 }
 
 std::string ActionLabel::nameOrFunc() const
@@ -77,50 +85,50 @@ std::string ActionLabel::nameOrFunc() const
     return name;
 }
 
-ActionLabel::ActionLabel(const char *file, int line, const char *function, const char *name)
-  : mName(name), mFile(file), mLine(line), mFunction(function)
+ActionLabel::ActionLabel(const char *file, int line, const char *function, const char *name, LabelKind kind)
+  : mName(name), mFile(file), mLine(line), mFunction(function), mKind(kind)
 {
-    sLabelLock.lock();
+    // labels are created right before their first entry
+    ActionClock::lockSource();
 
-#if _MSC_VER
-    if (sFrequency.QuadPart == 0)
-        QueryPerformanceFrequency(&sFrequency);
-#endif
+    sLabelLock.lock();
 
     mIndex = sLabels.size();
     sLabels.push_back(this);
     if (!sEntries)
-    {
-        sEntries = new std::vector<ActionEntry>();
-        sEntriesPerThread.push_back(sEntries);
-    }
+        createThreadBuffer();
     sLabelLock.unlock();
 }
 
 void ActionLabel::startEntry()
 {
-    ActionEntry e;
-    e.labelIdx = mIndex;
-    writeTime(e);
+    auto ticks = ActionClock::now();
     if (!sEntries)
     {
         sLabelLock.lock();
         if (!sEntries)
-        {
-            sEntries = new std::vector<ActionEntry>();
-            sEntriesPerThread.push_back(sEntries);
-        }
+            createThreadBuffer();
         sLabelLock.unlock();
     }
-    sEntries->push_back(e);
+    sEntries->pushStart(ticks, mIndex);
 }
 
 void ActionLabel::endEntry()
 {
-    ActionEntry e;
-    e.labelIdx = -1; // end
-    writeTime(e);
-    sEntries->push_back(e);
+    sEntries->pushEnd(ActionClock::now());
+}
+
+void ActionLabel::recordValue(int64_t value)
+{
+    auto ticks = ActionClock::now();
+    if (!sEntries)
+    {
+        sLabelLock.lock();
+        if (!sEntries)
+            createThreadBuffer();
+        sLabelLock.unlock();
+    }
+    sEntries->pushValue(ticks, mIndex, value);
 }
 
 std::vector<ActionLabel *> ActionLabel::getAllLabels()
@@ -133,7 +141,7 @@ std::vector<ActionLabel *> ActionLabel::getAllLabels()
 
 int64_t ActionLabel::getLastEntryIdx()
 {
-    return sEntries ? (int64_t)sEntries->size() - 1 : -1;
+    return sEntries ? (int64_t)sEntries->head() - 1 : -1;
 }
 
 std::vector<ActionEntry> ActionLabel::copyEntries(int64_t startIdx, int64_t endIdx)
@@ -143,20 +151,135 @@ std::vector<ActionEntry> ActionLabel::copyEntries(int64_t startIdx, int64_t endI
     if (!sEntries)
         return {};
 
-    return std::vector<ActionEntry>(sEntries->begin() + startIdx, sEntries->begin() + endIdx + 1);
+    std::vector<ActionEntry> entries;
+    sEntries->copy(startIdx, endIdx, entries);
+    return entries;
 }
 
 std::vector<ActionEntry> ActionLabel::copyAllEntries()
 {
     std::vector<ActionEntry> entries;
+    for (auto const &b : allBuffers())
+        b->copy(0, UINT64_MAX, entries);
+    return entries;
+}
+
+size_t ActionLabel::drainEntries(std::vector<ActionEntry> &entries)
+{
+    auto cnt = size_t{0};
+    for (auto const &b : allBuffers())
+        cnt += b->drain(entries);
+    return cnt;
+}
+
+std::vector<CounterEntry> ActionLabel::copyAllCounterEntries()
+{
+    std::vector<CounterEntry> entries;
+    for (auto const &b : allBuffers())
+        b->copyCounters(0, UINT64_MAX, entries);
+    return entries;
+}
+
+size_t ActionLabel::drainCounterEntries(std::vector<CounterEntry> &entries)
+{
+    auto cnt = size_t{0};
+    for (auto const &b : allBuffers())
+        cnt += b->drainCounters(entries);
+    return cnt;
+}
+
+std::vector<SampleEntry> ActionLabel::copyAllSamples()
+{
+    std::vector<SampleEntry> samples;
+    for (auto const &b : allBuffers())
+        b->copySamples(0, UINT64_MAX, samples);
+    return samples;
+}
+
+size_t ActionLabel::drainSamples(std::vector<SampleEntry> &samples)
+{
+    auto cnt = size_t{0};
+    for (auto const &b : allBuffers())
+        cnt += b->drainSamples(samples);
+    return cnt;
+}
+
+std::vector<ActionRingBuffer *> ActionLabel::getThreadBuffers()
+{
+    return allBuffers();
+}
+
+ActionRingBuffer *ActionLabel::getCurrentThreadBuffer()
+{
+    if (!sEntries)
+    {
+        sLabelLock.lock();
+        if (!sEntries)
+            createThreadBuffer();
+        sLabelLock.unlock();
+    }
+    return sEntries;
+}
+
+std::vector<std::string> ActionLabel::getThreadNames()
+{
     sLabelLock.lock();
-    for (auto const &pes : sEntriesPerThread)
-        entries.insert(end(entries), begin(*pes), end(*pes));
+    auto names = sThreadNames;
     sLabelLock.unlock();
-    return entries;
+    return names;
+}
+
+void ActionLabel::setThreadName(const std::string &name)
+{
+    sLabelLock.lock();
+    if (!sEntries)
+        createThreadBuffer();
+    sThreadNames[sEntries->threadIdx()] = name;
+    sLabelLock.unlock();
+}
+
+uint64_t ActionLabel::getDroppedEntryCount()
+{
+    auto cnt = uint64_t{0};
+    for (auto const &b : allBuffers())
+        cnt += b->droppedCount();
+    return cnt;
+}
+
+void ActionLabel::setOverflowPolicy(OverflowPolicy policy)
+{
+    sLabelLock.lock();
+    sOverflowPolicy = policy;
+    for (auto const &b : sEntriesPerThread)
+        b->setPolicy(policy);
+    sLabelLock.unlock();
+}
+
+OverflowPolicy ActionLabel::getOverflowPolicy()
+{
+    sLabelLock.lock();
+    auto policy = sOverflowPolicy;
+    sLabelLock.unlock();
+    return policy;
+}
+
+void ActionLabel::setBufferCapacity(size_t entries)
+{
+    sLabelLock.lock();
+    sBufferCapacity = entries;
+    sLabelLock.unlock();
+}
+
+size_t ActionLabel::getBufferCapacity()
+{
+    sLabelLock.lock();
+    auto cap = sBufferCapacity;
+    sLabelLock.unlock();
+    return cap;
 }
 
-ActionLabel::ActionLabel(const std::string &name, const std::string &function, const std::string &file, int line, int idx)
-  : mName(name), mFile(file), mLine(line), mFunction(function), mIndex(idx)
+ActionLabel::ActionLabel(
+    const std::string &name, const std::string &function, const std::string &file, int line, int idx, LabelKind kind)
+  : mName(name), mFile(file), mLine(line), mFunction(function), mIndex(idx), mKind(kind)
 {
 }
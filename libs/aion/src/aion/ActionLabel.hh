@@ -7,9 +7,21 @@
 #include "common/property.hh"
 
 #include "ActionEntry.hh"
+#include "ActionRingBuffer.hh"
 
 namespace aion
 {
+/// what entries of a label mean
+enum class LabelKind
+{
+    /// start/end of a timed scope (ACTION)
+    Action,
+    /// values are increments (AION_COUNTER)
+    Counter,
+    /// values are absolute (AION_GAUGE)
+    Gauge
+};
+
 class ActionLabel
 {
 private:
@@ -19,9 +31,11 @@ private:
     std::string mFunction;
 
     int32_t mIndex;
+    LabelKind mKind = LabelKind::Action;
 
 public:
     AION_GETTER(Index);
+    AION_GETTER(Kind);
 
     AION_GETTER(Name);
     AION_GETTER(File);
@@ -33,22 +47,63 @@ public:
     std::string nameOrFunc() const;
 
 public:
-    ActionLabel(const char* file, int line, const char* function, const char* name);
+    ActionLabel(const char* file, int line, const char* function, const char* name, LabelKind kind = LabelKind::Action);
 
     void startEntry();
     void endEntry();
+    /// records a value of a Counter or Gauge label
+    void recordValue(int64_t value);
 
     /// gets a COPY! of the vector of all labels (labels itself are not copied)
     static std::vector<ActionLabel*> getAllLabels();
 
+    /// entry indices are monotonic per thread (and stay valid after draining)
     static int64_t getLastEntryIdx();
-    /// inclusive
+    /// inclusive, current thread
+    /// (entries that were already drained or dropped are missing)
     static std::vector<ActionEntry> copyEntries(int64_t startIdx, int64_t endIdx);
-    /// all threads
+    /// all threads (one block per thread, see ActionEntry::threadIdx)
     static std::vector<ActionEntry> copyAllEntries();
+    /// removes all currently recorded entries of all threads and appends them to 'entries'
+    /// safe to call from any thread while recording, returns the number of drained entries
+    static size_t drainEntries(std::vector<ActionEntry>& entries);
+
+    /// all recorded counter values of all threads (one block per thread)
+    static std::vector<CounterEntry> copyAllCounterEntries();
+    /// same as drainEntries for counter values
+    static size_t drainCounterEntries(std::vector<CounterEntry>& entries);
+
+    /// all call stack samples of all threads (see ActionSampler)
+    static std::vector<SampleEntry> copyAllSamples();
+    /// same as drainEntries for samples
+    static size_t drainSamples(std::vector<SampleEntry>& samples);
+
+    /// per-thread recording buffers (index = thread index, buffers are never deleted)
+    static std::vector<ActionRingBuffer*> getThreadBuffers();
+    /// buffer of the current thread (created if needed)
+    static ActionRingBuffer* getCurrentThreadBuffer();
+    /// names of all recording threads (same indices as getThreadBuffers)
+    static std::vector<std::string> getThreadNames();
+    /// sets the name of the current thread (e.g. "Main", "Mesh Worker 2")
+    static void setThreadName(std::string const& name);
+
+    /// number of entries lost due to full buffers (all threads)
+    static uint64_t getDroppedEntryCount();
+
+    /// affects all threads
+    static void setOverflowPolicy(OverflowPolicy policy);
+    static OverflowPolicy getOverflowPolicy();
+    /// number of entries per thread, only affects threads that record their first entry afterwards
+    static void setBufferCapacity(size_t entries);
+    static size_t getBufferCapacity();
 
 private:
-    ActionLabel(std::string const& name, std::string const& function, std::string const& file, int line, int idx);
+    ActionLabel(std::string const& name,
+                std::string const& function,
+                std::string const& file,
+                int line,
+                int idx,
+                LabelKind kind = LabelKind::Action);
     friend class ActionPackage;   
 };
 }
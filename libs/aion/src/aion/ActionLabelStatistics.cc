@@ -0,0 +1,121 @@
+#include "ActionLabelStatistics.hh"
+
+#include <algorithm>
+
+#include "common/auto.hh"
+
+#include "ActionLabel.hh"
+#include "ActionRingBuffer.hh"
+
+using namespace aion;
+
+ActionStatistics const &ActionLabelStatistics::of(const ActionLabel *label) const
+{
+    static const ActionStatistics empty;
+    _ idx = label->getIndex();
+    return idx < (int)mLabels.size() ? mLabels[idx] : empty;
+}
+
+void ActionLabelStatistics::update()
+{
+    _ buffers = ActionLabel::getThreadBuffers();
+    for (_ tid = 0u; tid < buffers.size(); ++tid)
+    {
+        _ b = buffers[tid];
+        _ &t = thread(tid);
+
+        _ end = b->head();
+        while (t.nextIdx < end)
+        {
+            _ next = std::min<uint64_t>(t.nextIdx + ActionRingBuffer::ChunkSize, end);
+
+            mChunk.clear();
+            b->copy(t.nextIdx, next - 1, mChunk);
+
+            // some entries were drained or dropped in the meantime: open actions cannot be matched anymore
+            _ missed = (next - t.nextIdx) - mChunk.size();
+            if (missed > 0)
+            {
+                mMissedEntries += missed;
+                t.stack.clear();
+            }
+
+            addEntries(mChunk.data(), mChunk.size());
+            t.nextIdx = next;
+        }
+    }
+}
+
+void ActionLabelStatistics::seekToEnd()
+{
+    _ buffers = ActionLabel::getThreadBuffers();
+    for (_ tid = 0u; tid < buffers.size(); ++tid)
+    {
+        _ &t = thread(tid);
+        t.nextIdx = buffers[tid]->head();
+        t.stack.clear();
+    }
+}
+
+void ActionLabelStatistics::addEntries(const ActionEntry *entries, size_t count)
+{
+    // (entries of one thread usually come in runs)
+    ThreadState *pt = nullptr;
+    int32_t ptIdx = -1;
+    for (_ i = size_t{0}; i < count; ++i)
+    {
+        _ const &e = entries[i];
+        if (e.threadIdx != ptIdx)
+        {
+            pt = &thread(e.threadIdx);
+            ptIdx = e.threadIdx;
+        }
+        _ &t = *pt;
+
+        if (e.labelIdx >= 0) // start
+            t.stack.push_back({e.labelIdx, e.timestamp()});
+        else // end
+        {
+            // start was dropped
+            if (t.stack.empty())
+                continue;
+
+            _ s = t.stack.back();
+            t.stack.pop_back();
+
+            _ duration = e.timestamp() - s.second;
+            if (mCollectStatistics)
+            {
+                if (s.first >= (int)mLabels.size())
+                    mLabels.resize(s.first + 1);
+                mLabels[s.first].add(duration);
+            }
+
+            ++t.actionCount;
+            if (t.stack.empty())
+                t.topLevelNs += duration;
+
+            if (mCallback)
+                mCallback(s.first, e.threadIdx, duration);
+        }
+    }
+}
+
+void ActionLabelStatistics::clear()
+{
+    // keep read positions and open actions
+    for (_ &t : mThreads)
+    {
+        t.actionCount = 0;
+        t.topLevelNs = 0;
+    }
+    mLabels.clear();
+    mMissedEntries = 0;
+}
+
+ActionLabelStatistics::ThreadState &ActionLabelStatistics::thread(int32_t idx)
+{
+    if (idx >= (int)mThreads.size())
+        mThreads.resize(idx + 1);
+    return mThreads[idx];
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ActionEntry.hh"
+#include "ActionStatistics.hh"
+
+namespace aion
+{
+class ActionLabel;
+
+/**
+ * @brief Per-label duration statistics computed directly from entries
+ *
+ * No ActionTree is constructed, memory is constant per label and thread.
+ * Actions are only counted once they ended.
+ *
+ * Usage (live, e.g. once per frame):
+ *   stats.update(); // processes all entries recorded since the last update (non-destructive)
+ *   auto p99 = stats.of(label).quantileNS(0.99);
+ *
+ * Usage (offline):
+ *   stats.addEntries(entries.data(), entries.size());
+ */
+class ActionLabelStatistics
+{
+public:
+    /// called for every completed action (label index, thread index, duration)
+    using ActionCallback = std::function<void(int32_t, int32_t, int64_t)>;
+
+private:
+    struct ThreadState
+    {
+        /// next sequence index of the thread buffer (for update())
+        uint64_t nextIdx = 0;
+        /// open actions: label index and start time
+        std::vector<std::pair<int32_t, int64_t>> stack;
+
+        int64_t actionCount = 0;
+        int64_t topLevelNs = 0;
+    };
+
+    std::vector<ThreadState> mThreads;
+    /// indexed by label index
+    std::vector<ActionStatistics> mLabels;
+
+    /// entries that could not be processed (dropped before update())
+    uint64_t mMissedEntries = 0;
+
+    std::vector<ActionEntry> mChunk;
+
+    ActionCallback mCallback;
+
+    /// false: only the thread counters and the callback are updated
+    bool mCollectStatistics = true;
+
+public:
+    /// indexed by label index (labels without actions have count() == 0)
+    std::vector<ActionStatistics> const& getLabels() const { return mLabels; }
+    ActionStatistics const& of(ActionLabel const* label) const;
+
+    size_t threadCount() const { return mThreads.size(); }
+    int64_t threadActionCount(int thread) const { return mThreads[thread].actionCount; }
+    /// total time of actions without parent
+    int64_t threadTopLevelNS(int thread) const { return mThreads[thread].topLevelNs; }
+
+    uint64_t missedEntries() const { return mMissedEntries; }
+
+    /// e.g. for rolling windows
+    void setActionCallback(ActionCallback const& callback) { mCallback = callback; }
+    /// if false, no per-label statistics (moments, quantile sketch) are collected, getLabels() stays empty
+    /// (saves the sketch cost if only the callback is of interest)
+    void setCollectStatistics(bool collect) { mCollectStatistics = collect; }
+
+    /// processes all entries recorded since the last update (all threads)
+    void update();
+
+    /// skips all entries recorded so far (e.g. when live statistics are re-enabled)
+    void seekToEnd();
+
+    /// processes the given entries (entries of different threads may be interleaved)
+    void addEntries(ActionEntry const* entries, size_t count);
+
+    void clear();
+
+private:
+    ThreadState& thread(int32_t idx);
+};
+}
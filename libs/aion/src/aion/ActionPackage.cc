@@ -1,14 +1,32 @@
 #include "ActionPackage.hh"
 #include "ActionLabel.hh"
+#include "ActionPackageFile.hh"
 
 #include "common/auto.hh"
 
 #include "common/NetMessage.hh"
 
+#include <algorithm>
+#include <iostream>
+
 using namespace aion;
 
-ActionPackage::ActionPackage(std::vector<ActionEntry> const& entries, std::vector<ActionLabel*> const& labels)
-  : mEntries(entries), mLabels(labels)
+namespace
+{
+/// ActionEntry as stored in files of the original NetMessage-based format (no threadIdx)
+struct LegacyActionEntry
+{
+    int32_t secs;
+    int32_t nsecs;
+    int32_t labelIdx;
+};
+}
+
+ActionPackage::ActionPackage(std::vector<ActionEntry> const& entries,
+                             std::vector<ActionLabel*> const& labels,
+                             std::vector<std::string> const& threadNames,
+                             std::vector<CounterEntry> const& counters)
+  : mEntries(entries), mLabels(labels), mThreadNames(threadNames), mCounters(counters)
 {
 }
 
@@ -19,34 +37,79 @@ ActionPackage::~ActionPackage()
             delete l;
 }
 
-void ActionPackage::saveToFile(const std::string& filename) const
+std::vector<ActionEntry> const& ActionPackage::getEntries() const
 {
-    // QFileInfo(QString::fromStdString(filename)).dir().mkpath(".");
+    if (mFile)
+    {
+        mEntries = mFile->decodeAll();
+        mFile = nullptr;
+    }
+    return mEntries;
+}
 
-    NetMessage m;
+size_t ActionPackage::entryCount() const
+{
+    return mFile ? mFile->getEntryCount() : mEntries.size();
+}
 
-    m.writeUInt64(mEntries.size(), "#entries");
-    m.writeUInt64(mLabels.size(), "#labels");
+std::vector<ActionEntry> ActionPackage::getThreadEntries(int32_t threadIdx) const
+{
+    _ entries = std::vector<ActionEntry>{};
 
-    for (_ const& e : mEntries)
-        m.writeStruct(e, "e");
+    if (!mFile)
+    {
+        for (_ const& e : mEntries)
+            if (e.threadIdx == threadIdx)
+                entries.push_back(e);
+        return entries;
+    }
 
-    for (_ const& l : mLabels)
+    _ const& blocks = mFile->getBlocks();
+    for (_ i = 0u; i < blocks.size(); ++i)
     {
-        m.writeString(l->getName(), "name");
-        m.writeString(l->getFile(), "file");
-        m.writeString(l->getFunction(), "function");
-        m.writeInt32(l->getLine(), "line");
+        if (blocks[i].threadIdx != threadIdx)
+            continue;
+
+        _ start = entries.size();
+        entries.resize(start + blocks[i].entryCount);
+        if (!mFile->decodeBlock(i, entries.data() + start))
+        {
+            std::cerr << "Corrupt block in action package file " << mFile->getFilename() << std::endl;
+            entries.resize(start);
+        }
     }
+    return entries;
+}
 
-    m.writeToFile(filename);
+void ActionPackage::saveToFile(const std::string& filename, bool compress) const
+{
+    ActionPackageFile::write(filename, getEntries(), mLabels, mThreadNames, mCounters, compress);
 }
 
 SharedActionPackage ActionPackage::loadFromFile(const std::string& filename)
 {
     _ entries = std::vector<ActionEntry>{};
     _ labels = std::vector<ActionLabel*>{};
+    _ threadNames = std::vector<std::string>{};
+
+    // columnar format (entries are decoded lazily)
+    if (ActionPackageFile::isPackageFile(filename))
+    {
+        _ file = ActionPackageFile::open(filename);
+        if (!file)
+            return nullptr;
+
+        _ lIdx = 0;
+        for (_ const& l : file->getLabels())
+            labels.push_back(new ActionLabel(l.name, l.function, l.file, l.line, lIdx++, l.kind));
+
+        _ sap = std::make_shared<ActionPackage>(entries, labels, file->getThreadNames(), file->decodeAllCounters());
+        sap->mDeleteLabels = true;
+        sap->mFile = file;
+        return sap;
+    }
 
+    // original NetMessage-based format (no threads, everything was recorded on thread 0)
     _ m = NetMessage::readFromFile(filename);
     if (!m)
         return nullptr;
@@ -54,13 +117,18 @@ SharedActionPackage ActionPackage::loadFromFile(const std::string& filename)
     _ eCnt = m->readUInt64("#entries");
     _ lCnt = m->readUInt64("#labels");
 
-    while (eCnt > 0)
+    // (count is bounded by the message size)
+    entries.reserve(std::min<uint64_t>(eCnt, m->getSizeOfNonReadData() / sizeof(LegacyActionEntry)));
+    const std::string entryField = "e";
+    while (eCnt > 0 && m->good())
     {
-        entries.push_back(m->readStruct<ActionEntry>("e"));
+        // entries were written as ActionEntry (same type tag) before threadIdx was added
+        _ le = m->readStruct<LegacyActionEntry, ActionEntry>(entryField);
+        entries.push_back({le.secs, le.nsecs, le.labelIdx, 0});
         --eCnt;
     }
 
-    for (_ lIdx = 0u; lIdx < lCnt; ++lIdx)
+    for (_ lIdx = 0u; lIdx < lCnt && m->good(); ++lIdx)
     {
         _ name = m->readString("name");
         _ file = m->readString("file");
@@ -70,7 +138,17 @@ SharedActionPackage ActionPackage::loadFromFile(const std::string& filename)
         labels.push_back(new ActionLabel(name, function, file, line, lIdx));
     }
 
-    _ sap = std::make_shared<ActionPackage>(entries, labels);
+    threadNames.push_back("Thread 0"); // (default name, see ActionLabel)
+
+    if (!m->good())
+    {
+        std::cerr << "Corrupt action package file " << filename << std::endl;
+        for (_ l : labels)
+            delete l;
+        return nullptr;
+    }
+
+    _ sap = std::make_shared<ActionPackage>(entries, labels, threadNames);
     sap->mDeleteLabels = true;
     return sap;
 }
@@ -78,6 +156,8 @@ SharedActionPackage ActionPackage::loadFromFile(const std::string& filename)
 SharedActionPackage ActionPackage::complete()
 {
     _ entries = ActionLabel::copyAllEntries();
+    _ counters = ActionLabel::copyAllCounterEntries();
     _ labels = ActionLabel::getAllLabels();
-    return std::make_shared<ActionPackage>(entries, labels);
+    _ threadNames = ActionLabel::getThreadNames();
+    return std::make_shared<ActionPackage>(entries, labels, threadNames, counters);
 }
@@ -13,24 +13,49 @@ namespace aion
 class ActionLabel;
 
 AION_SHARED(class, ActionPackage);
-/// Collection of labels + entries
+AION_SHARED(class, ActionPackageFile);
+/**
+ * @brief Collection of labels + entries
+ *
+ * Files are written in the columnar ActionPackageFile format.
+ * Loaded packages keep the file mapped and decode their entries on first access.
+ * (files of the older NetMessage-based format are still readable)
+ */
 class ActionPackage
 {
 private:
     bool mDeleteLabels = false;
 
-    std::vector<ActionEntry> mEntries;
+    /// lazily decoded from mFile (if set)
+    mutable std::vector<ActionEntry> mEntries;
+    mutable SharedActionPackageFile mFile;
     std::vector<ActionLabel*> mLabels;
+    /// indexed by ActionEntry::threadIdx
+    std::vector<std::string> mThreadNames;
+    /// counter and gauge values (always decoded on load)
+    std::vector<CounterEntry> mCounters;
 
 public:
-    AION_GETTER(Entries);
+    /// CAUTION: decodes all entries on first call (not thread-safe)
+    std::vector<ActionEntry> const& getEntries() const;
     AION_GETTER(Labels);
+    AION_GETTER(ThreadNames);
+    AION_GETTER(Counters);
+
+    /// number of entries (does not decode)
+    size_t entryCount() const;
+    /// entries of a single thread (only decodes the blocks of this thread if not decoded yet)
+    std::vector<ActionEntry> getThreadEntries(int32_t threadIdx) const;
 
 public:
-    ActionPackage(std::vector<ActionEntry> const& entries, std::vector<ActionLabel*> const& labels);
+    ActionPackage(std::vector<ActionEntry> const& entries,
+                  std::vector<ActionLabel*> const& labels,
+                  std::vector<std::string> const& threadNames = {},
+                  std::vector<CounterEntry> const& counters = {});
     ~ActionPackage();
 
-    void saveToFile(std::string const& filename) const;
+    /// compress: snappy per block (if it helps)
+    void saveToFile(std::string const& filename, bool compress = true) const;
     static SharedActionPackage loadFromFile(std::string const& filename);
 
     /// gets a package of all entries
@@ -0,0 +1,635 @@
+#include "ActionPackageFile.hh"
+
+#include "ActionLabel.hh"
+
+#include "common/auto.hh"
+
+#include "common/snappy/snappy.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace aion;
+
+constexpr uint32_t ActionPackageFile::BlockEntries;
+constexpr uint32_t ActionPackageFile::BlockSnappy;
+
+namespace
+{
+const char sMagic[8] = {'A', 'I', 'O', 'N', 'P', 'A', 'C', 'K'};
+/// 3: first columnar version (older files are NetMessage-based and unversioned)
+/// 4: label kinds and counter blocks
+const uint32_t sFileVersion = 4;
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t entryCount;
+    uint64_t metaOffset;
+    uint64_t metaSize;
+};
+static_assert(sizeof(FileHeader) == 40, "unexpected padding");
+static_assert(sizeof(ActionPackageFile::Block) == 40, "unexpected padding");
+
+/// max encoded size of an entry (10 byte timestamp delta + 5 byte label)
+const size_t sMaxEntryBytes = 15;
+/// max encoded size of a counter value (+ 10 byte value)
+const size_t sMaxCounterBytes = 25;
+
+uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+char* writeVarint(char* p, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        *p++ = (char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (char)v;
+    return p;
+}
+
+void writeVarint(std::vector<char>& data, uint64_t v)
+{
+    char buf[10];
+    _ end = writeVarint(buf, v);
+    data.insert(data.end(), buf, end);
+}
+
+/// returns false if out of bounds or overlong
+bool readVarint(char const*& p, char const* end, uint64_t& v)
+{
+    v = 0;
+    for (_ shift = 0; shift < 64; shift += 7)
+    {
+        if (p == end)
+            return false;
+        _ b = (uint8_t)*p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (b < 0x80)
+            return true;
+    }
+    return false;
+}
+
+/// column 1: zigzag timestamp deltas (first relative to the block)
+template <class EntryT>
+char* writeTimestamps(char* p, EntryT const* begin, EntryT const* end)
+{
+    _ prev = begin->timestamp();
+    for (_ e = begin; e != end; ++e)
+    {
+        _ t = e->timestamp();
+        p = writeVarint(p, zigzag(t - prev));
+        prev = t;
+    }
+    return p;
+}
+
+template <class EntryT>
+bool readTimestamps(char const*& p, char const* end, ActionPackageFile::Block const& b, EntryT* entries)
+{
+    _ t = b.firstTimestamp;
+    for (_ i = 0u; i < b.entryCount; ++i)
+    {
+        uint64_t v;
+        if (!readVarint(p, end, v))
+            return false;
+        t += unzigzag(v);
+
+        _& e = entries[i];
+        e.secs = (int32_t)(t / 1000000000);
+        e.nsecs = (int32_t)(t % 1000000000);
+        e.threadIdx = b.threadIdx;
+    }
+    return true;
+}
+
+/// splits the entries into blocks (consecutive entries of the same thread)
+/// encodeColumns writes all columns after the timestamps
+template <class EntryT, class EncodeF>
+std::vector<ActionPackageFile::Block> writeBlocks(std::ofstream& file,
+                                                  uint64_t& offset,
+                                                  std::vector<EntryT> const& entries,
+                                                  size_t maxEntryBytes,
+                                                  bool compress,
+                                                  EncodeF&& encodeColumns)
+{
+    _ blocks = std::vector<ActionPackageFile::Block>{};
+    _ raw = std::vector<char>(ActionPackageFile::BlockEntries * maxEntryBytes);
+    _ compressed = std::vector<char>(compress ? snappy::MaxCompressedLength(raw.size()) : 0);
+
+    _ start = 0u;
+    while (start < entries.size())
+    {
+        _ thread = entries[start].threadIdx;
+        _ end = start + 1;
+        while (end < entries.size() && end - start < ActionPackageFile::BlockEntries && entries[end].threadIdx == thread)
+            ++end;
+
+        ActionPackageFile::Block b;
+        b.threadIdx = thread;
+        b.flags = 0;
+        b.offset = offset;
+        b.entryCount = end - start;
+        b.reserved = 0;
+        b.firstTimestamp = entries[start].timestamp();
+
+        _ p = writeTimestamps(raw.data(), entries.data() + start, entries.data() + end);
+        p = encodeColumns(p, entries.data() + start, entries.data() + end);
+
+        b.rawSize = p - raw.data();
+        b.storedSize = b.rawSize;
+        _ data = raw.data();
+
+        if (compress)
+        {
+            size_t size = 0;
+            snappy::RawCompress(raw.data(), b.rawSize, compressed.data(), &size);
+            if (size < b.rawSize)
+            {
+                b.flags |= ActionPackageFile::BlockSnappy;
+                b.storedSize = size;
+                data = compressed.data();
+            }
+        }
+
+        file.write(data, b.storedSize);
+        offset += b.storedSize;
+        blocks.push_back(b);
+
+        start = end;
+    }
+
+    return blocks;
+}
+
+void writeBlockTable(std::vector<char>& meta, std::vector<ActionPackageFile::Block> const& blocks)
+{
+    writeVarint(meta, blocks.size());
+    _ tableOffset = meta.size();
+    meta.resize(meta.size() + blocks.size() * sizeof(ActionPackageFile::Block));
+    if (!blocks.empty())
+        memcpy(meta.data() + tableOffset, blocks.data(), blocks.size() * sizeof(ActionPackageFile::Block));
+}
+
+/// bounds-checked reader for the meta section
+struct MetaReader
+{
+    char const* p;
+    char const* end;
+    bool good = true;
+
+    MetaReader(char const* begin, char const* end) : p(begin), end(end) {}
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        if (good && !readVarint(p, end, v))
+            good = false;
+        return good ? v : 0;
+    }
+
+    std::string string()
+    {
+        _ size = varint();
+        if (!good || size > uint64_t(end - p))
+        {
+            good = false;
+            return "";
+        }
+        std::string s(p, size);
+        p += size;
+        return s;
+    }
+
+    void raw(void* data, size_t size)
+    {
+        if (!good || size > size_t(end - p))
+        {
+            good = false;
+            return;
+        }
+        memcpy(data, p, size);
+        p += size;
+    }
+};
+}
+
+ActionPackageFile::~ActionPackageFile()
+{
+#ifndef _MSC_VER
+    if (mData)
+        munmap((void*)mData, mSize);
+#endif
+}
+
+bool ActionPackageFile::isPackageFile(const std::string& filename)
+{
+    char magic[sizeof(sMagic)];
+    std::ifstream file(filename, std::ios::binary);
+    return file.read(magic, sizeof(magic)) && memcmp(magic, sMagic, sizeof(sMagic)) == 0;
+}
+
+SharedActionPackageFile ActionPackageFile::open(const std::string& filename)
+{
+    _ f = SharedActionPackageFile(new ActionPackageFile);
+    f->mFilename = filename;
+
+#ifdef _MSC_VER
+    {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.good())
+        {
+            std::cerr << "Unable to open " << filename << " for reading" << std::endl;
+            return nullptr;
+        }
+        f->mBuffer.resize(file.tellg());
+        file.seekg(0, std::ios::beg);
+        file.read(f->mBuffer.data(), f->mBuffer.size());
+        f->mData = f->mBuffer.data();
+        f->mSize = f->mBuffer.size();
+    }
+#else
+    {
+        _ fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::cerr << "Unable to open " << filename << " for reading" << std::endl;
+            return nullptr;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            _ data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                f->mData = (char const*)data;
+                f->mSize = st.st_size;
+            }
+        }
+        ::close(fd); // mapping stays valid
+
+        if (!f->mData)
+        {
+            std::cerr << "Unable to map " << filename << std::endl;
+            return nullptr;
+        }
+    }
+#endif
+
+    if (!f->parseMeta())
+    {
+        std::cerr << "Invalid action package file " << filename << std::endl;
+        return nullptr;
+    }
+
+    return f;
+}
+
+bool ActionPackageFile::parseMeta()
+{
+    FileHeader h;
+    if (mSize < sizeof(h))
+        return false;
+    memcpy(&h, mData, sizeof(h));
+
+    if (memcmp(h.magic, sMagic, sizeof(sMagic)) != 0 || h.version < 3 || h.version > sFileVersion)
+        return false;
+    if (h.metaOffset > mSize || h.metaSize > mSize - h.metaOffset)
+        return false;
+
+    mEntryCount = h.entryCount;
+
+    MetaReader r(mData + h.metaOffset, mData + h.metaOffset + h.metaSize);
+
+    // string table
+    _ strings = std::vector<std::string>(std::min(r.varint(), (uint64_t)h.metaSize));
+    for (_& s : strings)
+        s = r.string();
+
+    _ string = [&](uint64_t idx) -> std::string
+    {
+        if (idx >= strings.size())
+        {
+            r.good = false;
+            return "";
+        }
+        return strings[idx];
+    };
+
+    // labels
+    mLabels.resize(std::min(r.varint(), (uint64_t)h.metaSize));
+    for (_& l : mLabels)
+    {
+        l.name = string(r.varint());
+        l.file = string(r.varint());
+        l.function = string(r.varint());
+        l.line = (int)unzigzag(r.varint());
+        l.kind = h.version >= 4 ? (LabelKind)r.varint() : LabelKind::Action;
+        if (l.kind > LabelKind::Gauge)
+            r.good = false;
+    }
+
+    // threads
+    mThreadNames.resize(std::min(r.varint(), (uint64_t)h.metaSize));
+    for (_& n : mThreadNames)
+        n = string(r.varint());
+
+    // blocks
+    mBlocks.resize(std::min(r.varint(), (uint64_t)h.metaSize / sizeof(Block)));
+    r.raw(mBlocks.data(), mBlocks.size() * sizeof(Block));
+    if (h.version >= 4)
+    {
+        mCounterBlocks.resize(std::min(r.varint(), (uint64_t)h.metaSize / sizeof(Block)));
+        r.raw(mCounterBlocks.data(), mCounterBlocks.size() * sizeof(Block));
+    }
+
+    if (!r.good)
+        return false;
+
+    _ valid = [this](Block const& b, size_t maxEntryBytes)
+    {
+        return b.offset <= mSize && b.storedSize <= mSize - b.offset && b.entryCount <= BlockEntries
+               && b.rawSize <= b.entryCount * maxEntryBytes && b.threadIdx >= 0;
+    };
+
+    uint64_t entryCount = 0;
+    for (_ const& b : mBlocks)
+    {
+        if (!valid(b, sMaxEntryBytes))
+            return false;
+        entryCount += b.entryCount;
+    }
+    for (_ const& b : mCounterBlocks)
+        if (!valid(b, sMaxCounterBytes))
+            return false;
+
+    return entryCount == mEntryCount;
+}
+
+bool ActionPackageFile::write(const std::string& filename,
+                              const std::vector<ActionEntry>& entries,
+                              const std::vector<ActionLabel*>& labels,
+                              const std::vector<std::string>& threadNames,
+                              const std::vector<CounterEntry>& counters,
+                              bool compress)
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.good())
+    {
+        std::cerr << "Unable to open " << filename << " for writing" << std::endl;
+        return false;
+    }
+
+    FileHeader h;
+    memcpy(h.magic, sMagic, sizeof(sMagic));
+    h.version = sFileVersion;
+    h.flags = 0;
+    h.entryCount = entries.size();
+    h.metaOffset = 0;
+    h.metaSize = 0;
+    file.write((char const*)&h, sizeof(h)); // patched at the end
+
+    // blocks
+    uint64_t offset = sizeof(h);
+    _ blocks = writeBlocks(file, offset, entries, sMaxEntryBytes, compress,
+                           [](char* p, ActionEntry const* begin, ActionEntry const* end)
+                           {
+                               // column 2: labels
+                               for (_ e = begin; e != end; ++e)
+                                   p = writeVarint(p, (uint32_t)(e->labelIdx + 1));
+                               return p;
+                           });
+    _ counterBlocks = writeBlocks(file, offset, counters, sMaxCounterBytes, compress,
+                                  [](char* p, CounterEntry const* begin, CounterEntry const* end)
+                                  {
+                                      // column 2: labels
+                                      for (_ e = begin; e != end; ++e)
+                                          p = writeVarint(p, (uint32_t)e->labelIdx);
+                                      // column 3: values
+                                      for (_ e = begin; e != end; ++e)
+                                          p = writeVarint(p, zigzag(e->value));
+                                      return p;
+                                  });
+
+    // meta
+    _ meta = std::vector<char>{};
+    {
+        _ strings = std::vector<std::string const*>{};
+        _ stringIdx = std::unordered_map<std::string, uint64_t>{};
+        _ idxOf = [&](std::string const& s)
+        {
+            _ it = stringIdx.find(s);
+            if (it != stringIdx.end())
+                return it->second;
+            stringIdx[s] = strings.size();
+            strings.push_back(&s);
+            return (uint64_t)strings.size() - 1;
+        };
+
+        _ labelRefs = std::vector<uint64_t>{};
+        for (_ l : labels)
+        {
+            labelRefs.push_back(idxOf(l->getName()));
+            labelRefs.push_back(idxOf(l->getFile()));
+            labelRefs.push_back(idxOf(l->getFunction()));
+        }
+        _ threadRefs = std::vector<uint64_t>{};
+        for (_ const& n : threadNames)
+            threadRefs.push_back(idxOf(n));
+
+        writeVarint(meta, strings.size());
+        for (_ s : strings)
+        {
+            writeVarint(meta, s->size());
+            meta.insert(meta.end(), s->begin(), s->end());
+        }
+
+        writeVarint(meta, labels.size());
+        for (_ i = 0u; i < labels.size(); ++i)
+        {
+            writeVarint(meta, labelRefs[3 * i + 0]);
+            writeVarint(meta, labelRefs[3 * i + 1]);
+            writeVarint(meta, labelRefs[3 * i + 2]);
+            writeVarint(meta, zigzag(labels[i]->getLine()));
+            writeVarint(meta, (uint64_t)labels[i]->getKind());
+        }
+
+        writeVarint(meta, threadRefs.size());
+        for (_ r : threadRefs)
+            writeVarint(meta, r);
+
+        writeBlockTable(meta, blocks);
+        writeBlockTable(meta, counterBlocks);
+    }
+    file.write(meta.data(), meta.size());
+
+    h.metaOffset = offset;
+    h.metaSize = meta.size();
+    file.seekp(0);
+    file.write((char const*)&h, sizeof(h));
+
+    if (!file.good())
+    {
+        std::cerr << "Unable to write " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+char const* ActionPackageFile::blockData(const Block& b, std::vector<char>& scratch) const
+{
+    _ data = mData + b.offset;
+    if (b.flags & BlockSnappy)
+    {
+        size_t size = 0;
+        if (!snappy::GetUncompressedLength(data, b.storedSize, &size) || size != b.rawSize)
+            return nullptr;
+        scratch.resize(size);
+        if (!snappy::RawUncompress(data, b.storedSize, scratch.data()))
+            return nullptr;
+        return scratch.data();
+    }
+
+    return b.storedSize == b.rawSize ? data : nullptr;
+}
+
+bool ActionPackageFile::decodeBlock(size_t idx, ActionEntry* entries) const
+{
+    _ const& b = mBlocks[idx];
+
+    _ raw = std::vector<char>{};
+    _ p = blockData(b, raw);
+    if (!p)
+        return false;
+    _ end = p + b.rawSize;
+
+    if (!readTimestamps(p, end, b, entries))
+        return false;
+
+    // column 2: labels
+    for (_ i = 0u; i < b.entryCount; ++i)
+    {
+        uint64_t v;
+        if (!readVarint(p, end, v) || v > mLabels.size()) // (0 is an end, i.e. -1)
+            return false;
+        entries[i].labelIdx = (int32_t)v - 1;
+    }
+
+    return p == end;
+}
+
+bool ActionPackageFile::decodeCounterBlock(size_t idx, CounterEntry* entries) const
+{
+    _ const& b = mCounterBlocks[idx];
+
+    _ raw = std::vector<char>{};
+    _ p = blockData(b, raw);
+    if (!p)
+        return false;
+    _ end = p + b.rawSize;
+
+    if (!readTimestamps(p, end, b, entries))
+        return false;
+
+    // column 2: labels
+    for (_ i = 0u; i < b.entryCount; ++i)
+    {
+        uint64_t v;
+        if (!readVarint(p, end, v) || v >= mLabels.size())
+            return false;
+        entries[i].labelIdx = (int32_t)v;
+    }
+
+    // column 3: values
+    for (_ i = 0u; i < b.entryCount; ++i)
+    {
+        uint64_t v;
+        if (!readVarint(p, end, v))
+            return false;
+        entries[i].value = unzigzag(v);
+    }
+
+    return p == end;
+}
+
+std::vector<ActionEntry> ActionPackageFile::decodeAll() const
+{
+    _ entries = std::vector<ActionEntry>(mEntryCount);
+
+    _ starts = std::vector<uint64_t>(mBlocks.size());
+    uint64_t start = 0;
+    for (_ i = 0u; i < mBlocks.size(); ++i)
+    {
+        starts[i] = start;
+        start += mBlocks[i].entryCount;
+    }
+
+    // contiguous ranges of blocks per worker
+    _ workers = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), mBlocks.size()));
+    _ futures = std::vector<std::future<bool>>{};
+    for (_ w = 0u; w < workers; ++w)
+    {
+        _ begin = mBlocks.size() * w / workers;
+        _ end = mBlocks.size() * (w + 1) / workers;
+        futures.push_back(std::async(w + 1 == workers ? std::launch::deferred : std::launch::async, [&, begin, end]
+                                     {
+                                         for (_ i = begin; i < end; ++i)
+                                             if (!decodeBlock(i, entries.data() + starts[i]))
+                                                 return false;
+                                         return true;
+                                     }));
+    }
+
+    _ ok = true;
+    for (_& f : futures)
+        ok &= f.get();
+
+    if (!ok)
+    {
+        std::cerr << "Corrupt block in action package file " << mFilename << std::endl;
+        return {};
+    }
+
+    return entries;
+}
+
+std::vector<CounterEntry> ActionPackageFile::decodeAllCounters() const
+{
+    _ counters = std::vector<CounterEntry>{};
+    for (_ i = 0u; i < mCounterBlocks.size(); ++i)
+    {
+        _ start = counters.size();
+        counters.resize(start + mCounterBlocks[i].entryCount);
+        if (!decodeCounterBlock(i, counters.data() + start))
+        {
+            std::cerr << "Corrupt counter block in action package file " << mFilename << std::endl;
+            return {};
+        }
+    }
+    return counters;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/property.hh"
+#include "common/shared.hh"
+
+#include "ActionEntry.hh"
+#include "ActionLabel.hh"
+
+namespace aion
+{
+AION_SHARED(class, ActionPackageFile);
+
+/**
+ * @brief Compact binary columnar file format for action packages
+ *
+ * Layout:
+ *   header (magic, version, entry count, offset of the meta section)
+ *   blocks (contiguous entries of one thread, at most BlockEntries each)
+ *     - column 1: timestamp deltas (zigzag varints, first relative to Block::firstTimestamp)
+ *     - column 2: label indices (varints, +1 so that ends are 0)
+ *     - optionally snappy-compressed (if smaller)
+ *   counter blocks (same, with label indices and a 3rd column of zigzag varint values)
+ *   meta (string table, labels, thread names, block tables)
+ *
+ * The file is memory-mapped on open, only the meta section is parsed.
+ * Blocks are decoded on demand (thread-safe, independent of each other).
+ *
+ * Usage:
+ *   ActionPackageFile::write("rec.aion", entries, labels, threadNames);
+ *
+ *   auto f = ActionPackageFile::open("rec.aion");
+ *   std::vector<ActionEntry> entries(f->getBlocks()[0].entryCount);
+ *   f->decodeBlock(0, entries.data());
+ */
+class ActionPackageFile
+{
+public:
+    /// max number of entries per block
+    static constexpr uint32_t BlockEntries = 1 << 16;
+
+    /// block flags
+    static constexpr uint32_t BlockSnappy = 1 << 0;
+
+    /// block table entry (stored as is)
+    struct Block
+    {
+        int32_t threadIdx;
+        uint32_t flags;
+        uint64_t offset; ///< in file
+        uint32_t storedSize;
+        uint32_t rawSize;
+        uint32_t entryCount;
+        uint32_t reserved;
+        int64_t firstTimestamp;
+    };
+
+    struct LabelInfo
+    {
+        std::string name;
+        std::string file;
+        std::string function;
+        int line;
+        LabelKind kind;
+    };
+
+private:
+    std::string mFilename;
+
+    char const* mData = nullptr;
+    size_t mSize = 0;
+#ifdef _MSC_VER
+    /// no mmap, file is read
+    std::vector<char> mBuffer;
+#endif
+
+    uint64_t mEntryCount = 0;
+    std::vector<Block> mBlocks;
+    std::vector<Block> mCounterBlocks;
+    std::vector<LabelInfo> mLabels;
+    std::vector<std::string> mThreadNames;
+
+public:
+    AION_GETTER(Filename);
+    AION_GETTER(EntryCount);
+    AION_GETTER(Blocks);
+    AION_GETTER(CounterBlocks);
+    AION_GETTER(Labels);
+    AION_GETTER(ThreadNames);
+
+    /// size of the mapped file in bytes
+    size_t fileSize() const { return mSize; }
+
+public:
+    ~ActionPackageFile();
+
+    ActionPackageFile(ActionPackageFile const&) = delete;
+    ActionPackageFile& operator=(ActionPackageFile const&) = delete;
+
+    /// returns true iff the file starts with the magic of this format
+    static bool isPackageFile(std::string const& filename);
+
+    /// maps the file and parses the meta section, nullptr on error
+    static SharedActionPackageFile open(std::string const& filename);
+
+    /// writes the given entries (order is kept, consecutive entries of the same thread share blocks)
+    /// returns false on error
+    static bool write(std::string const& filename,
+                      std::vector<ActionEntry> const& entries,
+                      std::vector<ActionLabel*> const& labels,
+                      std::vector<std::string> const& threadNames,
+                      std::vector<CounterEntry> const& counters = {},
+                      bool compress = true);
+
+    /// decodes block 'idx' into 'entries' (must hold Block::entryCount entries)
+    /// thread-safe, returns false if the block is corrupt
+    bool decodeBlock(size_t idx, ActionEntry* entries) const;
+
+    /// decodes all blocks (in parallel) in file order
+    std::vector<ActionEntry> decodeAll() const;
+
+    /// same for counter blocks
+    bool decodeCounterBlock(size_t idx, CounterEntry* entries) const;
+    std::vector<CounterEntry> decodeAllCounters() const;
+
+private:
+    ActionPackageFile() = default;
+
+    bool parseMeta();
+    /// uncompressed content of a block (in scratch if compressed), nullptr if corrupt
+    char const* blockData(Block const& b, std::vector<char>& scratch) const;
+};
+}
@@ -0,0 +1,110 @@
+#include "ActionPathView.hh"
+
+#include <algorithm>
+
+#include "common/auto.hh"
+
+#include "common/systime.hh"
+
+#include "ActionClass.hh"
+#include "ActionLabel.hh"
+#include "ActionTree.hh"
+
+using namespace aion;
+
+ActionPathView::ActionPathView()
+{
+    mNodes.resize(1);
+}
+
+void ActionPathView::add(const ActionTree &tree)
+{
+    for (_ r : tree.getRoots())
+        addAction(r, 0);
+}
+
+SharedActionPathView ActionPathView::merge(const std::vector<SharedActionTree> &trees)
+{
+    _ view = std::make_shared<ActionPathView>();
+    for (_ const &t : trees)
+        if (t)
+            view->add(*t);
+    return view;
+}
+
+void ActionPathView::addAction(Action a, int parentNode)
+{
+    _ n = childNode(parentNode, a.label());
+
+    {
+        // careful: reference is invalidated by childNode
+        _ &node = mNodes[n];
+        _ duration = a.duration();
+        _ thread = a.thread();
+        ++node.count;
+        node.totalNs += duration;
+        node.minNs = std::min(node.minNs, duration);
+        node.maxNs = std::max(node.maxNs, duration);
+
+        _ it = std::lower_bound(begin(node.threads), end(node.threads), thread);
+        if (it == end(node.threads) || *it != thread)
+            node.threads.insert(it, thread);
+    }
+
+    _ c = a.firstChild();
+    while (c)
+    {
+        addAction(c, n);
+        c = c.nextSibling();
+    }
+}
+
+int ActionPathView::childNode(int parentNode, ActionLabel *label)
+{
+    for (_ c : mNodes[parentNode].children)
+        if (mNodes[c].label == label)
+            return c;
+
+    _ idx = (int)mNodes.size();
+    mNodes.emplace_back();
+    mNodes.back().label = label;
+    mNodes.back().parent = parentNode;
+    mNodes[parentNode].children.push_back(idx);
+    return idx;
+}
+
+void ActionPathView::dump(std::ostream &oss, int maxDepth) const
+{
+    _ totalTime = 0 * aion_systime::ns;
+    for (_ c : root().children)
+        totalTime += mNodes[c].totalNs;
+
+    oss << "Total Time: " << aion_systime::formatHuman(totalTime) << " (merged over all threads)\n";
+    dumpNode(oss, 0, "", 0, maxDepth);
+}
+
+void ActionPathView::dumpNode(std::ostream &oss, int node, const std::string &prefix, int depth, int maxDepth) const
+{
+    _ const &n = mNodes[node];
+    if (n.label)
+    {
+        oss << prefix << " - " << aion_systime::formatHuman(n.totalNs) << " = " << n.count << "x ";
+        oss << aion_systime::formatHuman((int64_t)n.averageNS()) << " (" << n.label->nameOrFunc() << ")";
+        if (n.threads.size() > 1)
+            oss << " [" << n.threads.size() << " threads]";
+        oss << "\n";
+    }
+
+    if (maxDepth >= 0 && depth >= maxDepth)
+        return;
+
+    _ children = n.children;
+    std::sort(begin(children), end(children), [this](int l, int r)
+              {
+                  return mNodes[l].totalNs > mNodes[r].totalNs;
+              });
+
+    _ cp = n.label ? prefix + "   " : prefix;
+    for (_ c : children)
+        dumpNode(oss, c, cp, depth + 1, maxDepth);
+}
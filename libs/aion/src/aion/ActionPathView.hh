@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common/property.hh"
+#include "common/shared.hh"
+
+#include "ActionClass.hh"
+
+namespace aion
+{
+class ActionLabel;
+AION_SHARED(class, ActionTree);
+AION_SHARED(class, ActionPathView);
+
+/**
+ * @brief Merged view of one or more action trees
+ *
+ * Actions with the same label path (root label -> ... -> label) are aggregated into one node,
+ * independent of the recording thread.
+ *
+ * Usage:
+ *   auto trees = ActionTree::constructPerThread(entries, labels);
+ *   auto view = ActionPathView::merge(trees);
+ *   view->dump(std::cout);
+ */
+class ActionPathView
+{
+public:
+    struct Node
+    {
+        /// nullptr for the (virtual) root node
+        ActionLabel* label = nullptr;
+        int parent = -1;
+        std::vector<int> children;
+
+        int64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t minNs = INT64_MAX;
+        int64_t maxNs = 0;
+
+        /// sorted indices of all threads that recorded this path
+        std::vector<int32_t> threads;
+
+        double averageNS() const { return count == 0 ? 0.0 : totalNs / double(count); }
+    };
+
+private:
+    /// node 0 is the root
+    std::vector<Node> mNodes;
+
+public:
+    AION_GETTER(Nodes);
+
+    Node const& root() const { return mNodes[0]; }
+
+    ActionPathView();
+
+    /// adds all actions of the tree
+    void add(ActionTree const& tree);
+
+    /// merges all given trees (nullptrs are ignored)
+    static SharedActionPathView merge(std::vector<SharedActionTree> const& trees);
+
+    /// dumps the merged tree (children sorted by total time)
+    void dump(std::ostream& oss, int maxDepth = -1) const;
+
+private:
+    void addAction(Action a, int parentNode);
+    int childNode(int parentNode, ActionLabel* label);
+    void dumpNode(std::ostream& oss, int node, std::string const& prefix, int depth, int maxDepth) const;
+};
+}
@@ -0,0 +1,279 @@
+#include "ActionRingBuffer.hh"
+
+#include <algorithm>
+#include <thread>
+
+#include "common/auto.hh"
+
+#include "ActionClock.hh"
+
+using namespace aion;
+
+namespace
+{
+ActionEntry convert(RawActionEntry const &r, int32_t threadIdx)
+{
+    _ ns = ActionClock::toNanoseconds(r.ticks);
+    return {int32_t(ns / 1000000000LL), int32_t(ns % 1000000000LL), r.labelIdx, threadIdx};
+}
+CounterEntry convert(RawCounterEntry const &r, int32_t threadIdx)
+{
+    _ ns = ActionClock::toNanoseconds(r.ticks);
+    return {int32_t(ns / 1000000000LL), int32_t(ns % 1000000000LL), r.labelIdx, threadIdx, r.value};
+}
+SampleEntry convert(RawSampleEntry const &r, int32_t threadIdx)
+{
+    _ ns = ActionClock::toNanoseconds(r.ticks);
+    _ depth = std::min<uint32_t>(r.depth, RawSampleEntry::MaxFrames);
+    return {int32_t(ns / 1000000000LL), int32_t(ns % 1000000000LL), r.labelIdx, threadIdx, {r.frames, r.frames + depth}};
+}
+
+template <class RawT>
+void init(detail::SequenceRing<RawT> &r, size_t capacity)
+{
+    r.capacity = ActionRingBuffer::ChunkSize;
+    while (r.capacity < capacity)
+        r.capacity *= 2;
+    r.mask = r.capacity - 1;
+
+    // default-init: pages are only touched once written
+    r.entries.reset(new RawT[r.capacity]);
+}
+
+/// makes room for 'count' entries according to the policy, returns false if they should be dropped
+template <class RawT>
+bool reserve(detail::SequenceRing<RawT> &r, uint64_t count, OverflowPolicy policy, std::atomic<uint64_t> &dropped)
+{
+    _ h = r.head.load(std::memory_order_relaxed);
+    _ t = r.tail.load(std::memory_order_acquire);
+    if (h - t + count <= r.capacity)
+        return true;
+
+    switch (policy)
+    {
+    case OverflowPolicy::DropNewest:
+        return false;
+
+    case OverflowPolicy::DropOldest:
+        while (h - t + count > r.capacity)
+        {
+            // release the oldest chunk (races with draining consumers)
+            _ cnt = std::min<uint64_t>(ActionRingBuffer::ChunkSize, h - t);
+            if (r.tail.compare_exchange_weak(t, t + cnt, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                dropped.fetch_add(cnt, std::memory_order_relaxed);
+                t += cnt;
+            }
+        }
+        return true;
+
+    case OverflowPolicy::Block:
+        while (h - t + count > r.capacity)
+        {
+            std::this_thread::yield();
+            t = r.tail.load(std::memory_order_acquire);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+template <class RawT>
+RawT &nextSlot(detail::SequenceRing<RawT> &r)
+{
+    return r.entries[r.head.load(std::memory_order_relaxed) & r.mask];
+}
+
+template <class RawT>
+void publish(detail::SequenceRing<RawT> &r)
+{
+    r.head.store(r.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <class RawT, class EntryT>
+size_t drain(detail::SequenceRing<RawT> &r, std::vector<EntryT> &out, uint64_t endIdx, int32_t threadIdx)
+{
+    _ drained = size_t{0};
+    _ t = r.tail.load(std::memory_order_acquire);
+    while (true)
+    {
+        _ h = std::min(r.head.load(std::memory_order_acquire), endIdx);
+        if (t >= h)
+            return drained;
+
+        // copy one chunk, then try to claim it
+        _ cnt = std::min<uint64_t>(ActionRingBuffer::ChunkSize, h - t);
+        _ oldSize = out.size();
+        for (_ i = t; i < t + cnt; ++i)
+            out.push_back(convert(r.entries[i & r.mask], threadIdx));
+
+        if (r.tail.compare_exchange_strong(t, t + cnt, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            drained += cnt;
+            t += cnt;
+        }
+        else // dropped or drained by someone else in the meantime (t was updated)
+            out.resize(oldSize);
+    }
+}
+
+template <class RawT, class EntryT>
+void copy(detail::SequenceRing<RawT> const &r, uint64_t startIdx, uint64_t endIdx, std::vector<EntryT> &out, int32_t threadIdx)
+{
+    _ h = r.head.load(std::memory_order_acquire);
+    _ t = r.tail.load(std::memory_order_acquire);
+
+    startIdx = std::max(startIdx, t);
+    if (h == 0 || endIdx > h - 1)
+        endIdx = h - 1;
+    if (h == 0 || startIdx > endIdx)
+        return;
+
+    _ oldSize = out.size();
+    for (_ i = startIdx; i <= endIdx; ++i)
+        out.push_back(convert(r.entries[i & r.mask], threadIdx));
+
+    // everything below the new tail might have been overwritten while copying
+    _ newTail = r.tail.load(std::memory_order_acquire);
+    if (newTail > startIdx)
+    {
+        _ invalid = std::min<uint64_t>(newTail - startIdx, endIdx - startIdx + 1);
+        out.erase(out.begin() + oldSize, out.begin() + oldSize + invalid);
+    }
+}
+}
+
+constexpr size_t ActionRingBuffer::ChunkSize;
+constexpr int ActionRingBuffer::MaxLabelDepth;
+constexpr int RawSampleEntry::MaxFrames;
+
+ActionRingBuffer::ActionRingBuffer(size_t capacity, OverflowPolicy policy, int32_t threadIdx)
+  : mThreadIdx(threadIdx), mPolicy((int)policy)
+{
+    init(mActions, capacity);
+    init(mCounters, capacity / 4);
+    init(mSamples, capacity / 64);
+}
+
+void ActionRingBuffer::pushStart(uint64_t ticks, int32_t labelIdx)
+{
+    // inside a dropped action: drop the whole subtree
+    if (mSkipDepth > 0)
+    {
+        ++mSkipDepth;
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // DropNewest: keep room for the end of this action and the ends of all open ones
+    _ needed = policy() == OverflowPolicy::DropNewest ? uint64_t(mOpenDepth + 2) : uint64_t(1);
+    if (!reserve(mActions, needed, policy(), mDropped))
+    {
+        mSkipDepth = 1;
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _ &e = nextSlot(mActions);
+    e.ticks = ticks;
+    e.labelIdx = labelIdx;
+    publish(mActions);
+
+    if (mOpenDepth < MaxLabelDepth)
+        mLabelStack[mOpenDepth] = labelIdx;
+    std::atomic_signal_fence(std::memory_order_release);
+    ++mOpenDepth;
+}
+
+void ActionRingBuffer::pushEnd(uint64_t ticks)
+{
+    if (mSkipDepth > 0)
+    {
+        --mSkipDepth;
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (mOpenDepth > 0)
+        --mOpenDepth;
+
+    // only fails if the policy was changed to DropNewest while full
+    if (!reserve(mActions, 1, policy(), mDropped))
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _ &e = nextSlot(mActions);
+    e.ticks = ticks;
+    e.labelIdx = -1;
+    publish(mActions);
+}
+
+void ActionRingBuffer::pushValue(uint64_t ticks, int32_t labelIdx, int64_t value)
+{
+    if (!reserve(mCounters, 1, policy(), mDropped))
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    _ &e = nextSlot(mCounters);
+    e.ticks = ticks;
+    e.labelIdx = labelIdx;
+    e.value = value;
+    publish(mCounters);
+}
+
+void ActionRingBuffer::pushSample(uint64_t ticks, const uint64_t *frames, int depth)
+{
+    _ p = policy() == OverflowPolicy::DropOldest ? OverflowPolicy::DropOldest : OverflowPolicy::DropNewest;
+    if (!reserve(mSamples, 1, p, mDropped))
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // innermost action (deeper ones than MaxLabelDepth are attributed to their ancestor)
+    std::atomic_signal_fence(std::memory_order_acquire);
+    _ openDepth = std::min(mOpenDepth, MaxLabelDepth);
+
+    _ &e = nextSlot(mSamples);
+    e.ticks = ticks;
+    e.labelIdx = openDepth > 0 ? mLabelStack[openDepth - 1] : -1;
+    e.depth = std::min(depth, RawSampleEntry::MaxFrames);
+    for (_ i = 0u; i < e.depth; ++i)
+        e.frames[i] = frames[i];
+    publish(mSamples);
+}
+
+size_t ActionRingBuffer::drain(std::vector<ActionEntry> &out, uint64_t endIdx)
+{
+    return ::drain(mActions, out, endIdx, mThreadIdx);
+}
+
+void ActionRingBuffer::copy(uint64_t startIdx, uint64_t endIdx, std::vector<ActionEntry> &out) const
+{
+    ::copy(mActions, startIdx, endIdx, out, mThreadIdx);
+}
+
+size_t ActionRingBuffer::drainCounters(std::vector<CounterEntry> &out, uint64_t endIdx)
+{
+    return ::drain(mCounters, out, endIdx, mThreadIdx);
+}
+
+void ActionRingBuffer::copyCounters(uint64_t startIdx, uint64_t endIdx, std::vector<CounterEntry> &out) const
+{
+    ::copy(mCounters, startIdx, endIdx, out, mThreadIdx);
+}
+
+size_t ActionRingBuffer::drainSamples(std::vector<SampleEntry> &out, uint64_t endIdx)
+{
+    return ::drain(mSamples, out, endIdx, mThreadIdx);
+}
+
+void ActionRingBuffer::copySamples(uint64_t startIdx, uint64_t endIdx, std::vector<SampleEntry> &out) const
+{
+    ::copy(mSamples, startIdx, endIdx, out, mThreadIdx);
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "ActionEntry.hh"
+
+namespace aion
+{
+#pragma pack(push, 4)
+/// Recorded entry before conversion: raw ticks of the ActionClock (12 bytes)
+struct RawActionEntry
+{
+    uint64_t ticks;
+    /// -1 if end of action
+    int32_t labelIdx;
+};
+
+/// Recorded counter/gauge value before conversion (20 bytes)
+struct RawCounterEntry
+{
+    uint64_t ticks;
+    int32_t labelIdx;
+    int64_t value;
+};
+#pragma pack(pop)
+
+/// Recorded call stack sample before conversion
+struct RawSampleEntry
+{
+    static constexpr int MaxFrames = 32;
+
+    uint64_t ticks;
+    int32_t labelIdx;
+    uint32_t depth;
+    uint64_t frames[MaxFrames];
+};
+
+/// What happens if a thread records entries faster than they are drained
+enum class OverflowPolicy
+{
+    /// discards the oldest entries (one chunk at a time)
+    DropOldest,
+    /// discards new actions (including their whole subtree)
+    /// the ends of already recorded actions are always kept
+    DropNewest,
+    /// waits until a consumer drained enough entries
+    /// CAUTION: requires another thread calling ActionLabel::drainEntries
+    Block
+};
+
+namespace detail
+{
+/// storage of an ActionRingBuffer, addressed by monotonic sequence indices
+template <class RawT>
+struct SequenceRing
+{
+    std::unique_ptr<RawT[]> entries;
+    uint64_t capacity = 0;
+    uint64_t mask = 0;
+
+    /// next sequence index to write (only written by producer)
+    std::atomic<uint64_t> head{0};
+    /// oldest valid sequence index
+    std::atomic<uint64_t> tail{0};
+};
+}
+
+/**
+ * @brief Bounded single-producer ring buffer of ActionEntries (and CounterEntries)
+ *
+ * Each recording thread owns exactly one buffer (the producer).
+ * Consumers may copy or drain concurrently without locks:
+ *   * entries are addressed by a monotonic sequence index (never reused)
+ *   * [tail, head) is the range of currently stored entries
+ *   * draining copies up to ChunkSize entries and then releases them via CAS on tail
+ *   * DropOldest releases whole chunks from the producer side via the same CAS
+ *
+ * Entries are stored with raw ActionClock ticks and converted to nanoseconds when copied or drained.
+ * Memory is reserved but only touched when entries are written.
+ *
+ * Counter values are stored the same way in a second ring (a quarter of the capacity),
+ * they are independent of the actions (separate sequence indices).
+ * Call stack samples (see ActionSampler) use a third ring (1/64 of the capacity),
+ * written from a signal handler of the owning thread.
+ */
+class ActionRingBuffer
+{
+public:
+    static constexpr size_t ChunkSize = 1024;
+    /// innermost actions are tracked up to this depth (for samples)
+    static constexpr int MaxLabelDepth = 64;
+
+private:
+    detail::SequenceRing<RawActionEntry> mActions;
+    detail::SequenceRing<RawCounterEntry> mCounters;
+    detail::SequenceRing<RawSampleEntry> mSamples;
+    /// stored in every converted entry
+    int32_t mThreadIdx;
+
+    std::atomic<int> mPolicy;
+
+    /// number of entries (incl. counter values) that were not recorded or discarded before being consumed
+    std::atomic<uint64_t> mDropped{0};
+
+    // producer-only state
+    /// number of open (recorded) actions
+    int mOpenDepth = 0;
+    /// > 0 while inside a dropped action (DropNewest)
+    int mSkipDepth = 0;
+    /// labels of open actions (also read by the sample signal handler of this thread)
+    int32_t mLabelStack[MaxLabelDepth];
+
+public:
+    /// capacity is rounded up to a power of two (and at least ChunkSize)
+    ActionRingBuffer(size_t capacity, OverflowPolicy policy, int32_t threadIdx = 0);
+
+    ActionRingBuffer(ActionRingBuffer const&) = delete;
+    ActionRingBuffer& operator=(ActionRingBuffer const&) = delete;
+
+    size_t capacity() const { return mActions.capacity; }
+    size_t counterCapacity() const { return mCounters.capacity; }
+    size_t sampleCapacity() const { return mSamples.capacity; }
+    int32_t threadIdx() const { return mThreadIdx; }
+    uint64_t droppedCount() const { return mDropped.load(std::memory_order_relaxed); }
+
+    OverflowPolicy policy() const { return (OverflowPolicy)mPolicy.load(std::memory_order_relaxed); }
+    void setPolicy(OverflowPolicy policy) { mPolicy.store((int)policy, std::memory_order_relaxed); }
+
+    /// sequence index of the next entry
+    uint64_t head() const { return mActions.head.load(std::memory_order_acquire); }
+    /// sequence index of the oldest stored entry
+    uint64_t tail() const { return mActions.tail.load(std::memory_order_acquire); }
+
+    /// same for counter values
+    uint64_t counterHead() const { return mCounters.head.load(std::memory_order_acquire); }
+    uint64_t counterTail() const { return mCounters.tail.load(std::memory_order_acquire); }
+    uint64_t sampleHead() const { return mSamples.head.load(std::memory_order_acquire); }
+
+public: // producer
+    void pushStart(uint64_t ticks, int32_t labelIdx);
+    void pushEnd(uint64_t ticks);
+    void pushValue(uint64_t ticks, int32_t labelIdx, int64_t value);
+    /// async-signal-safe, must be called on the owning thread (attributed to the innermost open action)
+    /// never blocks (Block behaves like DropNewest)
+    void pushSample(uint64_t ticks, uint64_t const* frames, int depth);
+
+public: // consumer
+    /// appends and releases all stored entries with sequence index below endIdx
+    /// returns the number of drained entries
+    /// can be called concurrently by multiple consumers and while recording
+    size_t drain(std::vector<ActionEntry>& out, uint64_t endIdx = UINT64_MAX);
+
+    /// appends all still stored entries with sequence index in [startIdx, endIdx] without releasing them
+    /// (entries that were already drained or dropped are skipped)
+    void copy(uint64_t startIdx, uint64_t endIdx, std::vector<ActionEntry>& out) const;
+
+    /// same as drain and copy for counter values
+    size_t drainCounters(std::vector<CounterEntry>& out, uint64_t endIdx = UINT64_MAX);
+    void copyCounters(uint64_t startIdx, uint64_t endIdx, std::vector<CounterEntry>& out) const;
+
+    /// same as drain and copy for call stack samples
+    size_t drainSamples(std::vector<SampleEntry>& out, uint64_t endIdx = UINT64_MAX);
+    void copySamples(uint64_t startIdx, uint64_t endIdx, std::vector<SampleEntry>& out) const;
+};
+}
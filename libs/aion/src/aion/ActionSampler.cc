@@ -0,0 +1,400 @@
+#include "ActionSampler.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#include "common/auto.hh"
+
+#include "ActionClock.hh"
+#include "ActionLabel.hh"
+#include "ActionRingBuffer.hh"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define AION_HAS_SAMPLING 1
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+using namespace aion;
+
+namespace
+{
+std::mutex sSymbolLock;
+std::unordered_map<uint64_t, std::string> sSymbols;
+
+#ifdef AION_HAS_SAMPLING
+struct ThreadSampler
+{
+    ActionRingBuffer *buffer;
+    pthread_t thread;
+    pid_t tid;
+    /// valid frame pointer range
+    uint64_t stackLo = 0;
+    uint64_t stackHi = 0;
+    timer_t timer;
+    bool hasTimer = false;
+};
+
+std::mutex sLock;
+std::vector<ThreadSampler *> sThreads;
+std::atomic<bool> sRunning{false};
+int sIntervalUS = 1000;
+bool sHandlerInstalled = false;
+
+/// destructor unregisters the thread on exit
+pthread_key_t sThreadKey;
+pthread_once_t sThreadKeyOnce = PTHREAD_ONCE_INIT;
+
+/// read by the signal handler
+__thread ThreadSampler *sCurrent = nullptr;
+
+int unwind(ucontext_t const *uc, ThreadSampler const *ts, uint64_t *frames)
+{
+#if defined(__x86_64__)
+    uint64_t pc = uc->uc_mcontext.gregs[REG_RIP];
+    uint64_t fp = uc->uc_mcontext.gregs[REG_RBP];
+#else
+    uint64_t pc = uc->uc_mcontext.pc;
+    uint64_t fp = uc->uc_mcontext.regs[29];
+#endif
+
+    _ depth = 0;
+    frames[depth++] = pc;
+
+    // [fp] = previous fp, [fp + 8] = return address
+    while (depth < RawSampleEntry::MaxFrames)
+    {
+        if (fp < ts->stackLo || fp + 16 > ts->stackHi || (fp & 7) != 0)
+            break;
+
+        _ next = ((uint64_t const *)fp)[0];
+        _ ret = ((uint64_t const *)fp)[1];
+        if (ret == 0)
+            break;
+
+        frames[depth++] = ret;
+
+        // stack grows down
+        if (next <= fp)
+            break;
+        fp = next;
+    }
+
+    return depth;
+}
+
+void onSignal(int, siginfo_t *, void *context)
+{
+    _ ts = sCurrent;
+    if (!ts || !sRunning.load(std::memory_order_relaxed))
+        return;
+
+    _ savedErrno = errno;
+
+    uint64_t frames[RawSampleEntry::MaxFrames];
+    _ depth = unwind((ucontext_t const *)context, ts, frames);
+    ts->buffer->pushSample(ActionClock::now(), frames, depth);
+
+    errno = savedErrno;
+}
+
+/// CAUTION: sLock must be held
+bool arm(ThreadSampler *ts)
+{
+    if (!ts->hasTimer)
+    {
+        clockid_t clock;
+        if (pthread_getcpuclockid(ts->thread, &clock) != 0)
+            return false;
+
+        sigevent sev;
+        memset(&sev, 0, sizeof(sev));
+        sev.sigev_notify = SIGEV_THREAD_ID;
+        sev.sigev_signo = SIGPROF;
+        sev.sigev_notify_thread_id = ts->tid;
+        if (timer_create(clock, &sev, &ts->timer) != 0)
+            return false;
+        ts->hasTimer = true;
+    }
+
+    itimerspec its;
+    its.it_interval.tv_sec = sIntervalUS / 1000000;
+    its.it_interval.tv_nsec = (sIntervalUS % 1000000) * 1000L;
+    its.it_value = its.it_interval;
+    return timer_settime(ts->timer, 0, &its, nullptr) == 0;
+}
+
+/// CAUTION: sLock must be held
+void disarm(ThreadSampler *ts)
+{
+    if (!ts->hasTimer)
+        return;
+
+    itimerspec its;
+    memset(&its, 0, sizeof(its));
+    timer_settime(ts->timer, 0, &its, nullptr);
+}
+
+void onThreadExit(void *p)
+{
+    _ ts = (ThreadSampler *)p;
+
+    // handler ignores this thread from now on
+    sCurrent = nullptr;
+
+    std::lock_guard<std::mutex> lock(sLock);
+    if (ts->hasTimer)
+        timer_delete(ts->timer);
+    sThreads.erase(std::remove(begin(sThreads), end(sThreads), ts), end(sThreads));
+    delete ts;
+}
+
+void createThreadKey()
+{
+    pthread_key_create(&sThreadKey, onThreadExit);
+}
+#endif
+}
+
+bool ActionSampler::isSupported()
+{
+#ifdef AION_HAS_SAMPLING
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool ActionSampler::start(int intervalMicroseconds)
+{
+#ifdef AION_HAS_SAMPLING
+    registerCurrentThread();
+
+    std::lock_guard<std::mutex> lock(sLock);
+
+    // never uninstalled (pending signals after stop() would terminate the process otherwise)
+    if (!sHandlerInstalled)
+    {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = onSignal;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        if (sigaction(SIGPROF, &sa, nullptr) != 0)
+            return false;
+        sHandlerInstalled = true;
+    }
+
+    sIntervalUS = std::max(1, intervalMicroseconds);
+    sRunning = true;
+
+    _ ok = true;
+    for (_ ts : sThreads)
+        ok &= arm(ts);
+    return ok;
+#else
+    (void)intervalMicroseconds;
+    return false;
+#endif
+}
+
+void ActionSampler::stop()
+{
+#ifdef AION_HAS_SAMPLING
+    std::lock_guard<std::mutex> lock(sLock);
+    sRunning = false;
+    for (_ ts : sThreads)
+        disarm(ts);
+#endif
+}
+
+bool ActionSampler::isRunning()
+{
+#ifdef AION_HAS_SAMPLING
+    return sRunning;
+#else
+    return false;
+#endif
+}
+
+void ActionSampler::registerCurrentThread()
+{
+    // registers via registerThread if newly created
+    ActionLabel::getCurrentThreadBuffer();
+}
+
+void ActionSampler::registerThread(ActionRingBuffer *buffer)
+{
+#ifdef AION_HAS_SAMPLING
+    if (sCurrent)
+        return;
+
+    _ ts = new ThreadSampler;
+    ts->buffer = buffer;
+    ts->thread = pthread_self();
+    ts->tid = (pid_t)syscall(SYS_gettid);
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0)
+    {
+        void *addr = nullptr;
+        size_t size = 0;
+        if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+        {
+            ts->stackLo = (uint64_t)addr;
+            ts->stackHi = (uint64_t)addr + size;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    pthread_once(&sThreadKeyOnce, createThreadKey);
+    pthread_setspecific(sThreadKey, ts);
+
+    std::lock_guard<std::mutex> lock(sLock);
+    sThreads.push_back(ts);
+    sCurrent = ts;
+    if (sRunning)
+        arm(ts);
+#else
+    (void)buffer;
+#endif
+}
+
+std::string ActionSampler::symbolize(uint64_t address)
+{
+    std::lock_guard<std::mutex> lock(sSymbolLock);
+
+    _ it = sSymbols.find(address);
+    if (it != sSymbols.end())
+        return it->second;
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "0x%llx", (unsigned long long)address);
+    std::string name = buf;
+
+#ifdef AION_HAS_SAMPLING
+    Dl_info info;
+    if (dladdr((void *)address, &info) != 0)
+    {
+        if (info.dli_sname)
+        {
+            _ status = 0;
+            _ demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            name = status == 0 && demangled ? demangled : info.dli_sname;
+            free(demangled);
+        }
+        else if (info.dli_fname)
+        {
+            std::string module = info.dli_fname;
+            module = module.substr(module.rfind('/') + 1);
+            snprintf(buf, sizeof(buf), "+0x%llx", (unsigned long long)(address - (uint64_t)info.dli_fbase));
+            name = module + buf;
+        }
+    }
+#endif
+
+    sSymbols[address] = name;
+    return name;
+}
+
+std::string ActionSampler::frameName(const SampleEntry &sample, size_t i)
+{
+    // return addresses point after the call
+    return symbolize(i == 0 ? sample.frames[i] : sample.frames[i] - 1);
+}
+
+void ActionSampler::writeFoldedStacks(std::ostream &oss,
+                                      const std::vector<SampleEntry> &samples,
+                                      const std::vector<ActionLabel *> &labels,
+                                      const std::vector<std::string> &threadNames)
+{
+    std::map<std::string, int> stacks;
+    for (_ const &s : samples)
+    {
+        std::string stack = s.threadIdx < (int)threadNames.size() ? threadNames[s.threadIdx] : "?";
+        stack += ";[";
+        stack += s.labelIdx >= 0 && s.labelIdx < (int)labels.size() ? labels[s.labelIdx]->nameOrFunc() : "no action";
+        stack += "]";
+        for (_ i = s.frames.size(); i > 0; --i)
+            stack += ";" + frameName(s, i - 1);
+
+        // ';' separates frames
+        std::replace(begin(stack) + stack.find(";[") + 1, end(stack), ' ', '_');
+        ++stacks[stack];
+    }
+
+    for (_ const &kvp : stacks)
+        oss << kvp.first << " " << kvp.second << "\n";
+}
+
+void ActionSampler::dumpSummary(std::ostream &oss,
+                                const std::vector<SampleEntry> &samples,
+                                const std::vector<ActionLabel *> &labels,
+                                size_t maxRows)
+{
+    if (samples.empty())
+        return;
+
+    _ byLabel = std::map<int32_t, int>{};
+    _ byFunction = std::unordered_map<std::string, int>{};
+    for (_ const &s : samples)
+    {
+        ++byLabel[s.labelIdx < (int)labels.size() ? s.labelIdx : -1];
+        if (!s.frames.empty())
+            ++byFunction[frameName(s, 0)];
+    }
+
+    _ percent = [&](int cnt)
+    {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%5.1f%%", 100.0 * cnt / samples.size());
+        return std::string(buf);
+    };
+
+    oss << "Samples: " << samples.size() << "\n";
+
+    oss << "  by innermost action:\n";
+    _ labelRows = std::vector<std::pair<int32_t, int>>(begin(byLabel), end(byLabel));
+    std::sort(begin(labelRows), end(labelRows), [](std::pair<int32_t, int> const &l, std::pair<int32_t, int> const &r)
+              {
+                  return l.second > r.second;
+              });
+    for (_ i = 0u; i < labelRows.size() && i < maxRows; ++i)
+    {
+        _ l = labelRows[i].first;
+        oss << "    " << percent(labelRows[i].second) << "  " << (l >= 0 ? labels[l]->shortDesc() : "(no action)") << "\n";
+    }
+
+    oss << "  by function (self):\n";
+    _ functionRows = std::vector<std::pair<std::string, int>>(begin(byFunction), end(byFunction));
+    std::sort(begin(functionRows), end(functionRows),
+              [](std::pair<std::string, int> const &l, std::pair<std::string, int> const &r)
+              {
+                  return l.second > r.second;
+              });
+    for (_ i = 0u; i < functionRows.size() && i < maxRows; ++i)
+    {
+        _ name = functionRows[i].first;
+        if (name.size() > 100)
+            name = name.substr(0, 97) + "...";
+        oss << "    " << percent(functionRows[i].second) << "  " << name << "\n";
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "ActionEntry.hh"
+
+namespace aion
+{
+class ActionLabel;
+class ActionRingBuffer;
+
+/**
+ * @brief Optional sampling profiler (Linux only)
+ *
+ * Each recording thread gets a SIGPROF timer on its own CPU-time clock (timer_create).
+ * The signal handler unwinds the stack via frame pointers and stores the sample
+ * (timestamp, innermost open ACTION label, return addresses) in the thread's ActionRingBuffer.
+ * Samples are thus attributed to annotated scopes AND to the raw call stack,
+ * including code without ACTIONs (e.g. assimp, noise generation).
+ *
+ * Threads are registered automatically with their first ACTION,
+ * threads without ACTIONs can call registerCurrentThread().
+ *
+ * CAUTION: unwinding requires frame pointers (-fno-omit-frame-pointer),
+ *          otherwise stacks are truncated (never invalid reads: frames are checked against the thread stack).
+ *          Symbol names of the executable require -rdynamic (otherwise module+offset is shown).
+ *
+ * Usage:
+ *   aion::ActionSampler::start(1000); // every ms of CPU time
+ *   ...
+ *   aion::ActionSampler::stop();
+ *
+ *   auto samples = aion::ActionLabel::copyAllSamples();
+ *   aion::ActionSampler::writeFoldedStacks(file, samples, labels, threadNames); // flamegraph.pl, speedscope
+ *   // also part of ActionAnalyzer::dumpSummary and ActionTraceWriter::exportAll
+ */
+class ActionSampler
+{
+public:
+    /// true if sampling is implemented on this platform
+    static bool isSupported();
+
+    /// arms the timers of all registered (and future) threads
+    /// returns false if not supported or timers could not be created
+    static bool start(int intervalMicroseconds = 1000);
+    /// disarms all timers (already recorded samples are kept)
+    static void stop();
+    static bool isRunning();
+
+    /// registers the current thread for sampling (creates its buffer if needed)
+    static void registerCurrentThread();
+    /// called when a thread buffer is created (on the owning thread)
+    static void registerThread(ActionRingBuffer* buffer);
+
+public: // analysis
+    /// function name (demangled) or module+offset of an address, cached
+    static std::string symbolize(uint64_t address);
+    /// symbolized frame i of a sample (0 = innermost)
+    static std::string frameName(SampleEntry const& sample, size_t i);
+
+    /// writes "thread;[label];outer;...;inner count" lines (collapsed stack format for flame graphs)
+    static void writeFoldedStacks(std::ostream& oss,
+                                  std::vector<SampleEntry> const& samples,
+                                  std::vector<ActionLabel*> const& labels,
+                                  std::vector<std::string> const& threadNames);
+
+    /// samples per innermost ACTION label and functions with the most self samples
+    static void dumpSummary(std::ostream& oss, std::vector<SampleEntry> const& samples, std::vector<ActionLabel*> const& labels, size_t maxRows = 10);
+};
+}
@@ -0,0 +1,171 @@
+#include "ActionStatistics.hh"
+
+#include <algorithm>
+#include <cassert>
+
+#include "common/auto.hh"
+
+using namespace aion;
+
+QuantileSketch::QuantileSketch(double accuracy, int maxBuckets) : mAccuracy(accuracy), mMaxBuckets(maxBuckets)
+{
+    assert(0 < accuracy && accuracy < 1);
+    assert(maxBuckets > 0);
+    mGamma = (1.0 + accuracy) / (1.0 - accuracy);
+    mLogGammaInv = 1.0 / std::log(mGamma);
+}
+
+void QuantileSketch::add(int64_t value)
+{
+    ++mCount;
+    if (value <= 0)
+        ++mZeroCount;
+    else
+        addToBucket(bucketIndex(value), 1);
+}
+
+void QuantileSketch::merge(const QuantileSketch &rhs)
+{
+    assert(mAccuracy == rhs.mAccuracy && "incompatible sketches");
+
+    mCount += rhs.mCount;
+    mZeroCount += rhs.mZeroCount;
+    for (_ i = 0u; i < rhs.mBuckets.size(); ++i)
+        if (rhs.mBuckets[i] > 0)
+            addToBucket(rhs.mOffset + (int)i, rhs.mBuckets[i]);
+}
+
+void QuantileSketch::clear()
+{
+    mBuckets.clear();
+    mOffset = 0;
+    mZeroCount = 0;
+    mCount = 0;
+}
+
+int64_t QuantileSketch::quantile(double q) const
+{
+    if (mCount == 0)
+        return 0;
+
+    q = std::min(std::max(q, 0.0), 1.0);
+    _ rank = (uint64_t)(q * (mCount - 1));
+
+    if (rank < mZeroCount)
+        return 0;
+
+    _ cum = mZeroCount;
+    for (_ i = 0u; i < mBuckets.size(); ++i)
+    {
+        cum += mBuckets[i];
+        if (cum > rank)
+            return bucketValue(mOffset + (int)i);
+    }
+
+    return bucketValue(mOffset + (int)mBuckets.size() - 1);
+}
+
+void QuantileSketch::addToBucket(int index, uint64_t count)
+{
+    if (mBuckets.empty())
+    {
+        mOffset = index;
+        mBuckets.push_back(count);
+        return;
+    }
+
+    // grow downwards
+    if (index < mOffset)
+    {
+        _ grow = mOffset - index;
+        // collapse if too large: lowest buckets are merged into the lowest kept one
+        if ((int)mBuckets.size() + grow > mMaxBuckets)
+        {
+            _ maxIndex = mOffset + (int)mBuckets.size() - 1;
+            if (maxIndex - index + 1 > mMaxBuckets)
+                index = maxIndex - mMaxBuckets + 1;
+            grow = mOffset - index;
+        }
+        if (grow > 0)
+        {
+            mBuckets.insert(mBuckets.begin(), grow, 0);
+            mOffset = index;
+        }
+    }
+    // grow upwards
+    else if (index >= mOffset + (int)mBuckets.size())
+    {
+        mBuckets.resize(index - mOffset + 1, 0);
+
+        // collapse lowest buckets
+        if ((int)mBuckets.size() > mMaxBuckets)
+        {
+            _ excess = (int)mBuckets.size() - mMaxBuckets;
+            uint64_t collapsed = 0;
+            for (_ i = 0; i < excess; ++i)
+                collapsed += mBuckets[i];
+            mBuckets.erase(mBuckets.begin(), mBuckets.begin() + excess);
+            mBuckets[0] += collapsed;
+            mOffset += excess;
+        }
+    }
+
+    mBuckets[index - mOffset] += count;
+}
+
+void ActionStatistics::add(int64_t durationNs)
+{
+    ++mCount;
+    mSumNs += durationNs;
+    mMin = std::min(mMin, durationNs);
+    mMax = std::max(mMax, durationNs);
+
+    // Welford
+    _ delta = durationNs - mMean;
+    mMean += delta / mCount;
+    mM2 += delta * (durationNs - mMean);
+
+    mSketch.add(durationNs);
+}
+
+void ActionStatistics::merge(const ActionStatistics &rhs)
+{
+    if (rhs.mCount == 0)
+        return;
+    if (mCount == 0)
+    {
+        *this = rhs;
+        return;
+    }
+
+    // Chan et al.
+    _ n = mCount + rhs.mCount;
+    _ delta = rhs.mMean - mMean;
+    mM2 += rhs.mM2 + delta * delta * mCount * rhs.mCount / double(n);
+    mMean += delta * rhs.mCount / double(n);
+
+    mCount = n;
+    mSumNs += rhs.mSumNs;
+    mMin = std::min(mMin, rhs.mMin);
+    mMax = std::max(mMax, rhs.mMax);
+
+    mSketch.merge(rhs.mSketch);
+}
+
+void ActionStatistics::clear()
+{
+    *this = ActionStatistics();
+}
+
+int64_t ActionStatistics::quantileNS(double q) const
+{
+    if (mCount == 0)
+        return 0;
+
+    // sketch values are bucket representatives, exact extremes are known
+    if (q <= 0.0)
+        return mMin;
+    if (q >= 1.0)
+        return mMax;
+    return std::min(std::max(mSketch.quantile(q), mMin), mMax);
+}
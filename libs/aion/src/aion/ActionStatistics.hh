@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace aion
+{
+/**
+ * @brief Mergeable streaming quantile sketch for durations (DDSketch)
+ *
+ * Values are counted in logarithmic buckets, i.e. every quantile is returned with a relative error of at most 'accuracy'.
+ * Memory is bounded by maxBuckets (if exceeded, the lowest buckets are collapsed)
+ * Sketches are only mergeable if they have the same accuracy.
+ *
+ * See "DDSketch: A Fast and Fully-Mergeable Quantile Sketch with Relative-Error Guarantees", Masson et al. 2019
+ */
+class QuantileSketch
+{
+private:
+    double mAccuracy;
+    double mGamma;
+    double mLogGammaInv;
+    int mMaxBuckets;
+
+    /// bucket i counts values in (gamma^(i-1+offset), gamma^(i+offset)]
+    std::vector<uint64_t> mBuckets;
+    int mOffset = 0;
+    /// values <= 0
+    uint64_t mZeroCount = 0;
+    uint64_t mCount = 0;
+
+public:
+    /// accuracy: relative error, e.g. 0.01 = 1%
+    QuantileSketch(double accuracy = 0.01, int maxBuckets = 2048);
+
+    uint64_t count() const { return mCount; }
+    double accuracy() const { return mAccuracy; }
+    size_t bucketCount() const { return mBuckets.size(); }
+
+    void add(int64_t value);
+    /// CAUTION: requires same accuracy
+    void merge(QuantileSketch const& rhs);
+    void clear();
+
+    /// returns the q-quantile (q in [0, 1]), 0 if empty
+    int64_t quantile(double q) const;
+
+private:
+    int bucketIndex(int64_t value) const { return (int)std::ceil(std::log((double)value) * mLogGammaInv); }
+    int64_t bucketValue(int index) const { return (int64_t)(2.0 * std::pow(mGamma, index) / (mGamma + 1.0)); }
+    void addToBucket(int index, uint64_t count);
+};
+
+/**
+ * @brief Online statistics of durations (in ns)
+ *
+ * Moments are maintained incrementally (Welford), quantiles via a QuantileSketch.
+ * Constant memory, mergeable, cheap enough to be queried every frame.
+ */
+class ActionStatistics
+{
+private:
+    int64_t mCount = 0;
+    int64_t mSumNs = 0;
+    int64_t mMin = std::numeric_limits<int64_t>::max();
+    int64_t mMax = std::numeric_limits<int64_t>::min();
+    double mMean = 0.0;
+    /// sum of squared differences from the mean
+    double mM2 = 0.0;
+
+    QuantileSketch mSketch;
+
+public:
+    void add(int64_t durationNs);
+    void merge(ActionStatistics const& rhs);
+    void clear();
+
+    int64_t count() const { return mCount; }
+    int64_t totalTimeNS() const { return mSumNs; }
+    double averageNS() const { return mMean; }
+    /// population variance
+    double varianceNS() const { return mCount == 0 ? 0.0 : mM2 / mCount; }
+    double standardDeviationNS() const { return std::sqrt(varianceNS()); }
+    int64_t minNS() const { return mMin; }
+    int64_t maxNS() const { return mMax; }
+
+    /// q in [0, 1] (e.g. 0.999), relative error see QuantileSketch::accuracy
+    int64_t quantileNS(double q) const;
+    int64_t medianNS() const { return quantileNS(0.5); }
+
+    QuantileSketch const& sketch() const { return mSketch; }
+};
+}
@@ -0,0 +1,315 @@
+#include "ActionTraceWriter.hh"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "common/auto.hh"
+
+#include "ActionLabel.hh"
+#include "ActionRingBuffer.hh"
+#include "ActionSampler.hh"
+
+using namespace aion;
+
+ActionTraceWriter::ActionTraceWriter(const std::string &filename)
+{
+    mOut.open(filename, std::ios::trunc);
+    if (!mOut.is_open())
+        return;
+
+    mOut << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+}
+
+ActionTraceWriter::~ActionTraceWriter()
+{
+    close();
+}
+
+void ActionTraceWriter::writeThreadName(int tid, const std::string &name)
+{
+    beginEvent();
+    mOut << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+    writeString(name);
+    mOut << "}}";
+}
+
+void ActionTraceWriter::writeEntries(int tid, const ActionEntry *entries, size_t count, const std::vector<ActionLabel *> &labels)
+{
+    _ &t = thread(tid);
+
+    for (_ i = size_t{0}; i < count; ++i)
+    {
+        _ const &e = entries[i];
+        _ time = e.timestamp();
+
+        if (e.labelIdx >= 0) // begin
+        {
+            _ l = labels[e.labelIdx];
+
+            beginEvent();
+            mOut << "{\"ph\":\"B\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+            writeTimestamp(time);
+            mOut << ",\"name\":";
+            writeString(l->nameOrFunc());
+            mOut << ",\"args\":{\"file\":";
+            writeString(l->getFile());
+            mOut << ",\"line\":" << l->getLine() << ",\"function\":";
+            writeString(l->getFunction());
+            mOut << "}}";
+
+            ++t.depth;
+        }
+        else // end
+        {
+            // start was dropped
+            if (t.depth == 0)
+                continue;
+
+            beginEvent();
+            mOut << "{\"ph\":\"E\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+            writeTimestamp(time);
+            mOut << "}";
+
+            --t.depth;
+        }
+
+        t.lastTime = time;
+    }
+}
+
+void ActionTraceWriter::writeCounter(const std::string &name, int64_t timestampNs, double value)
+{
+    beginEvent();
+    mOut << "{\"ph\":\"C\",\"pid\":1,\"ts\":";
+    writeTimestamp(timestampNs);
+    mOut << ",\"name\":";
+    writeString(name);
+    mOut << ",\"args\":{\"value\":" << value << "}}";
+}
+
+void ActionTraceWriter::writeCounterEntries(int tid, const CounterEntry *entries, size_t count, const std::vector<ActionLabel *> &labels)
+{
+    _ &t = thread(tid);
+
+    for (_ i = size_t{0}; i < count; ++i)
+    {
+        _ const &e = entries[i];
+        _ l = labels[e.labelIdx];
+
+        _ value = e.value;
+        if (l->getKind() == LabelKind::Counter)
+        {
+            if (e.labelIdx >= (int)t.counterSums.size())
+                t.counterSums.resize(e.labelIdx + 1, 0);
+            value = t.counterSums[e.labelIdx] += e.value;
+        }
+
+        beginEvent();
+        mOut << "{\"ph\":\"C\",\"pid\":1,\"id\":" << tid << ",\"ts\":";
+        writeTimestamp(e.timestamp());
+        mOut << ",\"name\":";
+        writeString(l->nameOrFunc());
+        mOut << ",\"args\":{\"value\":" << value << "}}";
+    }
+}
+
+void ActionTraceWriter::writeSamples(int tid, const SampleEntry *samples, size_t count, const std::vector<ActionLabel *> &labels)
+{
+    for (_ i = size_t{0}; i < count; ++i)
+    {
+        _ const &s = samples[i];
+
+        // outermost frame first
+        _ frame = 0;
+        for (_ f = s.frames.size(); f > 0; --f)
+            frame = stackFrame(frame, ActionSampler::frameName(s, f - 1));
+
+        beginEvent();
+        mOut << "{\"ph\":\"P\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+        writeTimestamp(s.timestamp());
+        mOut << ",\"name\":\"sample\",\"sf\":" << frame << ",\"args\":{\"action\":";
+        writeString(s.labelIdx >= 0 && s.labelIdx < (int)labels.size() ? labels[s.labelIdx]->nameOrFunc() : "");
+        mOut << "}}";
+    }
+}
+
+void ActionTraceWriter::close()
+{
+    if (!mOut.is_open())
+        return;
+
+    // close open actions at the last known time
+    for (_ tid = 0u; tid < mThreads.size(); ++tid)
+    {
+        _ &t = mThreads[tid];
+        while (t.depth > 0)
+        {
+            beginEvent();
+            mOut << "{\"ph\":\"E\",\"pid\":1,\"tid\":" << tid << ",\"ts\":";
+            writeTimestamp(t.lastTime);
+            mOut << "}";
+            --t.depth;
+        }
+    }
+
+    mOut << "\n]";
+
+    if (!mStackFrames.empty())
+    {
+        mOut << ",\"stackFrames\":{";
+        for (_ i = 0u; i < mStackFrames.size(); ++i)
+        {
+            _ const &f = mStackFrames[i];
+            mOut << (i > 0 ? ",\n" : "\n") << "\"" << i + 1 << "\":{\"name\":";
+            writeString(f.second);
+            if (f.first > 0)
+                mOut << ",\"parent\":\"" << f.first << "\"";
+            mOut << "}";
+        }
+        mOut << "\n}";
+    }
+
+    mOut << "}\n";
+    mOut.close();
+}
+
+bool ActionTraceWriter::exportAll(const std::string &filename, bool drain)
+{
+    ActionTraceWriter w(filename);
+    if (!w.isOpen())
+        return false;
+
+    _ buffers = ActionLabel::getThreadBuffers();
+    _ names = ActionLabel::getThreadNames();
+    _ labels = ActionLabel::getAllLabels();
+
+    std::vector<ActionEntry> chunk;
+    for (_ tid = 0u; tid < buffers.size(); ++tid)
+    {
+        _ b = buffers[tid];
+        w.writeThreadName(tid, names[tid]);
+
+        // stream the current content chunk-wise
+        _ end = b->head();
+        _ idx = b->tail();
+        while (idx < end)
+        {
+            chunk.clear();
+            _ next = std::min<uint64_t>(idx + ActionRingBuffer::ChunkSize, end);
+            if (drain)
+                b->drain(chunk, next);
+            else
+                b->copy(idx, next - 1, chunk);
+            idx = next;
+
+            // entries might reference labels created after the first query
+            for (_ const &e : chunk)
+                if (e.labelIdx >= (int)labels.size())
+                {
+                    labels = ActionLabel::getAllLabels();
+                    break;
+                }
+
+            w.writeEntries(tid, chunk.data(), chunk.size(), labels);
+        }
+
+        // counter values
+        std::vector<CounterEntry> counters;
+        if (drain)
+            b->drainCounters(counters);
+        else
+            b->copyCounters(0, UINT64_MAX, counters);
+        for (_ const &e : counters)
+            if (e.labelIdx >= (int)labels.size())
+            {
+                labels = ActionLabel::getAllLabels();
+                break;
+            }
+        w.writeCounterEntries(tid, counters.data(), counters.size(), labels);
+
+        // sampled stacks
+        std::vector<SampleEntry> samples;
+        if (drain)
+            b->drainSamples(samples);
+        else
+            b->copySamples(0, UINT64_MAX, samples);
+        for (_ const &e : samples)
+            if (e.labelIdx >= (int)labels.size())
+            {
+                labels = ActionLabel::getAllLabels();
+                break;
+            }
+        w.writeSamples(tid, samples.data(), samples.size(), labels);
+    }
+
+    w.close();
+    return true;
+}
+
+int ActionTraceWriter::stackFrame(int parent, const std::string &name)
+{
+    _ key = std::make_pair(parent, name);
+    _ it = mStackFrameIds.find(key);
+    if (it != mStackFrameIds.end())
+        return it->second;
+
+    mStackFrames.push_back(key);
+    _ id = (int)mStackFrames.size();
+    mStackFrameIds[key] = id;
+    return id;
+}
+
+ActionTraceWriter::ThreadState &ActionTraceWriter::thread(int tid)
+{
+    if (tid >= (int)mThreads.size())
+        mThreads.resize(tid + 1);
+    return mThreads[tid];
+}
+
+void ActionTraceWriter::beginEvent()
+{
+    if (!mFirstEvent)
+        mOut << ",\n";
+    mFirstEvent = false;
+}
+
+void ActionTraceWriter::writeTimestamp(int64_t ns)
+{
+    // microseconds with ns precision
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld.%03d", (long long)(ns / 1000), int(ns % 1000));
+    mOut << buf;
+}
+
+void ActionTraceWriter::writeString(const std::string &s)
+{
+    mOut << '"';
+    for (_ c : s)
+    {
+        switch (c)
+        {
+        case '"':
+            mOut << "\\\"";
+            break;
+        case '\\':
+            mOut << "\\\\";
+            break;
+        case '\n':
+            mOut << "\\n";
+            break;
+        case '\t':
+            mOut << "\\t";
+            break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                mOut << buf;
+            }
+            else
+                mOut << c;
+        }
+    }
+    mOut << '"';
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ActionEntry.hh"
+
+namespace aion
+{
+class ActionLabel;
+
+/**
+ * @brief Streaming writer for the Chrome Trace Event Format (JSON)
+ *
+ * Output can be opened in chrome://tracing or https://ui.perfetto.dev
+ *
+ * Entries are written as begin/end events while streaming,
+ * i.e. no ActionTree is constructed and memory usage is independent of the recording size.
+ * Label file, line and function are stored as event args.
+ *
+ * Usage:
+ *   // everything recorded so far (all threads, not consumed)
+ *   aion::ActionTraceWriter::exportAll("trace.json");
+ *
+ *   // manual
+ *   ActionTraceWriter w("trace.json");
+ *   w.writeThreadName(0, "Main");
+ *   w.writeEntries(0, entries.data(), entries.size(), labels);
+ *   w.writeCounterEntries(0, counters.data(), counters.size(), labels);
+ *   w.writeCounter("Chunks", timestampNs, 42);
+ *   w.close(); // also done in dtor
+ */
+class ActionTraceWriter
+{
+private:
+    std::ofstream mOut;
+    bool mFirstEvent = true;
+
+    /// per-thread stack depth and last timestamp (for orphaned ends and closing open actions)
+    struct ThreadState
+    {
+        int depth = 0;
+        int64_t lastTime = 0;
+        /// running sum per counter label
+        std::vector<int64_t> counterSums;
+    };
+    std::vector<ThreadState> mThreads;
+
+    /// sampled call stacks as frame tree (written as "stackFrames" on close)
+    /// id of a frame is its index + 1
+    std::vector<std::pair<int, std::string>> mStackFrames; ///< parent id (0 = root) and name
+    std::map<std::pair<int, std::string>, int> mStackFrameIds;
+
+public:
+    /// opens the file and writes the header
+    ActionTraceWriter(std::string const& filename);
+    ~ActionTraceWriter();
+
+    bool isOpen() const { return mOut.is_open(); }
+
+    /// names a thread track
+    void writeThreadName(int tid, std::string const& name);
+
+    /// writes begin/end events for a contiguous part of a thread's entries
+    /// can be called repeatedly with consecutive parts
+    /// ends without a start (dropped entries) are skipped
+    void writeEntries(int tid, ActionEntry const* entries, size_t count, std::vector<ActionLabel*> const& labels);
+
+    /// writes a counter sample (counter tracks are per name)
+    void writeCounter(std::string const& name, int64_t timestampNs, double value);
+
+    /// writes recorded counter and gauge values of a thread (one track per label and thread)
+    /// counters are shown as running sum, gauges as is
+    void writeCounterEntries(int tid, CounterEntry const* entries, size_t count, std::vector<ActionLabel*> const& labels);
+
+    /// writes samples of the sampling profiler (see ActionSampler)
+    /// stacks are shown as flame chart, the innermost action is stored as arg
+    void writeSamples(int tid, SampleEntry const* samples, size_t count, std::vector<ActionLabel*> const& labels);
+
+    /// closes all still open actions and finishes the file
+    void close();
+
+    /// writes all recorded entries, counter values and samples of all threads (chunk-wise)
+    /// if 'drain' is true, the entries are consumed
+    /// returns false if the file could not be written
+    static bool exportAll(std::string const& filename, bool drain = false);
+
+private:
+    ThreadState& thread(int tid);
+    int stackFrame(int parent, std::string const& name);
+    void beginEvent();
+    void writeTimestamp(int64_t ns);
+    void writeString(std::string const& s);
+};
+}
@@ -1,6 +1,8 @@
 #include "ActionTree.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <future>
 
 #include "common/auto.hh"
 
@@ -10,154 +12,321 @@ using namespace aion;
 
 namespace
 {
-void writeStart(Action *a, std::vector<ActionEntry> &entries)
+/// builds the nodes of one thread, actions are written from 'actionIdx' on
+/// (threads write disjoint parts of the arrays)
+void buildThread(ActionNodes &n, ActionEntry const *entries, size_t count, int32_t actionIdx, std::vector<int32_t> &roots)
 {
-    entries.push_back({int32_t(a->starttime / 1000000000LL), int32_t(a->starttime % 1000000000LL), a->label->getIndex()});
-}
-void writeEnd(Action *a, std::vector<ActionEntry> &entries)
-{
-    entries.push_back({int32_t(a->endtime / 1000000000LL), int32_t(a->endtime % 1000000000LL), -1});
-}
+    std::vector<int32_t> actionStack;
+    _ prevAction = int32_t(-1);
+    _ lastTime = int64_t(-1);
 
-void writeAction(Action *a, std::vector<ActionEntry> &entries)
-{
-    writeStart(a, entries);
-
-    _ c = a->firstChild;
-    while (c)
+    for (_ i = size_t{0}; i < count; ++i)
     {
-        writeAction(c, entries);
-        c = c->nextSibling;
+        _ const &e = entries[i];
+
+        // start action
+        if (e.labelIdx >= 0)
+        {
+            _ a = actionIdx++;
+            _ parent = actionStack.empty() ? -1 : actionStack.back();
+
+            n.start[a] = e.timestamp();
+            n.duration[a] = -1;
+            n.label[a] = e.labelIdx;
+            n.parent[a] = parent;
+            n.firstChild[a] = -1;
+            n.nextSibling[a] = -1;
+
+            // parent and 1st child
+            if (parent >= 0)
+            {
+                if (n.firstChild[parent] < 0)
+                    n.firstChild[parent] = a;
+            }
+            else
+                roots.push_back(a);
+
+            // next sibling
+            if (prevAction >= 0 && n.parent[prevAction] == parent)
+                n.nextSibling[prevAction] = a;
+
+            actionStack.push_back(a);
+            lastTime = n.start[a];
+        }
+        else // end action
+        {
+            // start was dropped (see OverflowPolicy::DropOldest)
+            if (actionStack.empty())
+                continue;
+
+            _ a = actionStack.back();
+            actionStack.pop_back();
+
+            lastTime = e.timestamp();
+            n.duration[a] = lastTime - n.start[a];
+            assert(n.duration[a] >= 0);
+
+            prevAction = a;
+        }
     }
 
-    writeEnd(a, entries);
+    // closure
+    for (_ a : actionStack)
+        n.duration[a] = lastTime - n.start[a];
+}
 }
+
+ActionTree::ActionTree() : mNodes(std::make_shared<ActionNodes>()), mCounters(std::make_shared<std::vector<CounterEntry>>())
+{
+}
+
+std::vector<Action> ActionTree::getRoots() const
+{
+    std::vector<Action> roots;
+    roots.reserve(mRoots.size());
+    for (_ r : mRoots)
+        roots.push_back(action(r));
+    return roots;
 }
 
-ActionTree::ActionTree()
+std::vector<Action> ActionTree::getActions() const
 {
+    std::vector<Action> actions;
+    actions.reserve(mActionCount);
+    forEachAction([&](Action a)
+                  {
+                      actions.push_back(a);
+                  });
+    return actions;
 }
 
-SharedActionTree ActionTree::scopeTo(ActionLabel *label)
+SharedActionTree ActionTree::scopeTo(ActionLabel *label) const
 {
-    std::vector<Action *> actions;
-    for (_ &a : mActions)
-        if (a.label == label)
-            actions.push_back(&a);
+    std::vector<Action> actions;
+    forEachAction([&](Action a)
+                  {
+                      if (a.label() == label)
+                          actions.push_back(a);
+                  });
     return scopeTo(actions);
 }
 
-SharedActionTree ActionTree::scopeTo(const std::vector<Action *> &actions)
+SharedActionTree ActionTree::scopeTo(const std::vector<Action> &actions) const
 {
-    std::vector<ActionEntry> entries;
+    _ tree = std::make_shared<ActionTree>();
+    tree->mNodes = mNodes;
+    tree->mCounters = mCounters;
+
     for (_ const &a : actions)
-        writeAction(a, entries);
-    return construct(entries, mLabels);
+    {
+        assert(a.nodes() == mNodes.get() && "action of another tree");
+        tree->mRoots.push_back(a.index());
+    }
+    std::sort(begin(tree->mRoots), end(tree->mRoots));
+
+    // skip actions inside previous ones
+    _ rootCnt = size_t{0};
+    _ end = int32_t(-1);
+    for (_ r : tree->mRoots)
+    {
+        if (r < end)
+            continue;
+
+        end = mNodes->subtreeEnd(r);
+        tree->mActionCount += end - r;
+        tree->mRoots[rootCnt++] = r;
+    }
+    tree->mRoots.resize(rootCnt);
+
+    return tree;
 }
 
 SharedActionTree ActionTree::construct(const std::vector<ActionEntry> &entries, const std::vector<ActionLabel *> &labels)
 {
     ACTION("ActionTree::construct");
 
-    _ tree = std::make_shared<ActionTree>();
-    tree->mLabels = labels;
+    _ nodes = std::make_shared<ActionNodes>();
+    nodes->labels = labels;
 
-    _ actionCnt = 0;
+    // count per thread
+    std::vector<size_t> entryCnt;
+    std::vector<int32_t> actionCnt;
+    _ grouped = true; // entries already sorted by thread
+    _ lastThread = 0;
     for (_ const &e : entries)
+    {
+        assert(e.threadIdx >= 0);
+        if (e.threadIdx >= (int)entryCnt.size())
+        {
+            entryCnt.resize(e.threadIdx + 1, 0);
+            actionCnt.resize(e.threadIdx + 1, 0);
+        }
         if (e.labelIdx >= 0)
         {
             assert(e.labelIdx < (int)labels.size());
-            ++actionCnt;
+            ++actionCnt[e.threadIdx];
         }
+        grouped = grouped && e.threadIdx >= lastThread;
+        lastThread = e.threadIdx;
+        ++entryCnt[e.threadIdx];
+    }
 
-    tree->mActions.resize(actionCnt);
+    _ threadCnt = entryCnt.size();
 
-    std::vector<Action *> actionStack;
+    // entries of different threads may be interleaved (stable partition otherwise)
+    std::vector<size_t> entryBegin(threadCnt + 1, 0);
+    for (_ t = 0u; t < threadCnt; ++t)
+        entryBegin[t + 1] = entryBegin[t] + entryCnt[t];
 
-    _ actionIdx = size_t{0};
-    Action *prevAction = nullptr;
-    int64_t lastTime = -1;
-    for (_ const &e : entries)
+    std::vector<ActionEntry> partitioned;
+    if (!grouped)
     {
-        // start action
-        if (e.labelIdx >= 0)
-        {
-            assert(actionIdx < tree->mActions.size());
-            _ a = &tree->mActions[actionIdx];
-            a->tree = tree;
-            ++actionIdx;
+        partitioned.resize(entries.size());
+        _ pos = entryBegin;
+        for (_ const &e : entries)
+            partitioned[pos[e.threadIdx]++] = e;
+    }
+    _ threadEntries = grouped ? entries.data() : partitioned.data();
 
-            a->starttime = e.timestamp();
-            a->label = labels[e.labelIdx];
+    // node arrays
+    nodes->threadBegin.resize(threadCnt + 1, 0);
+    for (_ t = 0u; t < threadCnt; ++t)
+    {
+        assert(int64_t(nodes->threadBegin[t]) + actionCnt[t] < INT32_MAX && "too many actions");
+        nodes->threadBegin[t + 1] = nodes->threadBegin[t] + actionCnt[t];
+    }
 
-            // parent and 1st child
-            if (!actionStack.empty())
-            {
-                a->parent = actionStack.back();
-                if (!a->parent->firstChild)
-                    a->parent->firstChild = a;
-            }
-            else
-                tree->mRoots.push_back(a);
+    _ actionTotal = nodes->threadBegin.empty() ? 0 : nodes->threadBegin.back();
+    nodes->start.resize(actionTotal);
+    nodes->duration.resize(actionTotal);
+    nodes->label.resize(actionTotal);
+    nodes->parent.resize(actionTotal);
+    nodes->firstChild.resize(actionTotal);
+    nodes->nextSibling.resize(actionTotal);
 
-            // next sibling
-            if (prevAction && prevAction->parent == a->parent)
-                prevAction->nextSibling = a;
+    // one task per thread, the last one runs here
+    // (tasks do not record actions, so the helper threads get no entry buffers)
+    std::vector<std::vector<int32_t>> roots(threadCnt);
+    std::vector<std::future<void>> futures;
+    for (_ t = 0u; t < threadCnt; ++t)
+    {
+        if (entryCnt[t] == 0)
+            continue;
 
-            actionStack.push_back(a);
-            lastTime = a->starttime;
-        }
-        else // end action
+        _ build = [&, t]
         {
-            assert(actionStack.size() > 0);
-            _ a = actionStack.back();
-            actionStack.pop_back();
-
-            a->endtime = e.timestamp();
-            a->duration = a->endtime - a->starttime;
-            lastTime = a->endtime;
-            assert(a->duration >= 0);
+            buildThread(*nodes, threadEntries + entryBegin[t], entryCnt[t], nodes->threadBegin[t], roots[t]);
+        };
 
-            prevAction = a;
-        }
+        if (t + 1 < threadCnt)
+            futures.push_back(std::async(std::launch::async, build));
+        else
+            build();
     }
+    for (_ &f : futures)
+        f.get();
 
-    // closure
-    while (!actionStack.empty())
-    {
-        _ a = actionStack.back();
-        actionStack.pop_back();
+    _ tree = std::make_shared<ActionTree>();
+    tree->mNodes = nodes;
+    tree->mActionCount = actionTotal;
+    for (_ const &r : roots)
+        tree->mRoots.insert(end(tree->mRoots), begin(r), end(r));
+
+    return tree;
+}
+
+std::vector<SharedActionTree> ActionTree::constructPerThread(const std::vector<ActionEntry> &entries, const std::vector<ActionLabel *> &labels)
+{
+    ACTION("ActionTree::constructPerThread");
 
-        assert(a->starttime >= 0);
-        assert(a->endtime == -1);
+    _ all = construct(entries, labels);
+    _ const &nodes = all->nodes();
 
-        a->endtime = lastTime;
-        a->duration = a->endtime - a->starttime;
+    std::vector<SharedActionTree> trees;
+    for (_ t = 0; t < nodes.threadCount(); ++t)
+    {
+        _ tree = std::make_shared<ActionTree>();
+        tree->mNodes = all->mNodes;
+        tree->mCounters = all->mCounters;
+        tree->mActionCount = nodes.threadBegin[t + 1] - nodes.threadBegin[t];
+        trees.push_back(tree);
     }
 
-    // sanity
-    for (_ const &a : tree->mActions)
+    // roots are sorted by thread
+    for (_ r : all->mRoots)
+        trees[nodes.threadOf(r)]->mRoots.push_back(r);
+
+    return trees;
+}
+
+void ActionTree::addCounters(const std::vector<CounterEntry> &counters)
+{
+    // counters might be shared with scoped trees
+    _ all = std::make_shared<std::vector<CounterEntry>>(*mCounters);
+
+    for (_ const &c : counters)
+        if (c.labelIdx >= 0 && c.labelIdx < (int)getLabels().size())
+            all->push_back(c);
+
+    std::stable_sort(begin(*all), end(*all), [](CounterEntry const &l, CounterEntry const &r)
+                     {
+                         if (l.threadIdx != r.threadIdx)
+                             return l.threadIdx < r.threadIdx;
+                         return l.timestamp() < r.timestamp();
+                     });
+
+    mCounters = all;
+}
+
+std::vector<ActionTree::CounterSummary> ActionTree::countersOf(Action a) const
+{
+    std::vector<CounterSummary> result;
+
+    _ const &counters = *mCounters;
+    _ thread = a.thread();
+    _ starttime = a.starttime();
+    _ endtime = a.endtime();
+    _ it = std::lower_bound(begin(counters), end(counters), starttime, [thread](CounterEntry const &c, int64_t starttime)
+                            {
+                                if (c.threadIdx != thread)
+                                    return c.threadIdx < thread;
+                                return c.timestamp() < starttime;
+                            });
+
+    for (; it != end(counters) && it->threadIdx == thread && it->timestamp() <= endtime; ++it)
     {
-        assert(a.starttime >= 0);
-        assert(a.endtime >= 0);
-        assert(a.duration >= 0);
-        assert(a.label);
-        if (a.firstChild)
-            assert(a.firstChild->parent == &a);
+        _ label = getLabels()[it->labelIdx];
+        _ s = std::find_if(begin(result), end(result), [label](CounterSummary const &s)
+                           {
+                               return s.label == label;
+                           });
+        if (s == end(result))
+        {
+            result.push_back({label, 0, 0, 0});
+            s = end(result) - 1;
+        }
+
+        ++s->count;
+        s->sum += it->value;
+        s->last = it->value;
     }
 
-    return tree;
+    return result;
 }
 
-static void dumpAction(std::ostream &oss, Action *a, std::string const &prefix)
+static void dumpAction(std::ostream &oss, ActionTree const &tree, Action a, std::string const &prefix)
 {
-    oss << prefix << " - " << aion_systime::formatHuman(a->duration) << " (" << a->label->nameOrFunc() << ")\n";
-    _ c = a->firstChild;
+    oss << prefix << " - " << aion_systime::formatHuman(a.duration()) << " (" << a.label()->nameOrFunc() << ")";
+    for (_ const &c : tree.countersOf(a))
+        oss << " [" << c.label->nameOrFunc() << ": " << (c.label->getKind() == LabelKind::Gauge ? c.last : c.sum) << "]";
+    oss << "\n";
+
+    _ c = a.firstChild();
     _ cp = prefix + "   ";
     while (c)
     {
-        dumpAction(oss, c, cp);
-        c = c->nextSibling;
+        dumpAction(oss, tree, c, cp);
+        c = c.nextSibling();
     }
 }
 
@@ -165,10 +334,10 @@ void ActionTree::dump(std::ostream &oss) const
 {
     _ totalTime = 0 * aion_systime::ns;
     for (_ r : mRoots)
-        totalTime += r->duration;
+        totalTime += mNodes->duration[r];
 
     oss << "Total Time: " << aion_systime::formatHuman(totalTime) << "\n";
     for (_ r : mRoots)
-        dumpAction(oss, r, "");
+        dumpAction(oss, *this, action(r), "");
     oss.flush();
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/property.hh"
@@ -12,36 +13,96 @@
 namespace aion
 {
 AION_SHARED(class, ActionTree);
+
+/**
+ * @brief Action tree of a recording or a scoped view of one
+ *
+ * Nodes are stored index-based in ActionNodes (see there), which are shared
+ * between a tree and all its scoped views and never copied.
+ * A tree is a list of root actions, its actions are the subtrees of its roots
+ * (contiguous index ranges).
+ *
+ * Construction builds the nodes of every thread in parallel.
+ */
 class ActionTree
 {
 private:
-    /// all saved actions. Careful, their adresses are pinned
-    std::vector<Action> mActions;
-    std::vector<Action*> mRoots;
-    std::vector<ActionLabel*> mLabels;
+    std::shared_ptr<ActionNodes const> mNodes;
+    /// sorted, subtrees do not overlap
+    std::vector<int32_t> mRoots;
+    size_t mActionCount = 0;
+    /// sorted by thread, then time (see addCounters)
+    std::shared_ptr<std::vector<CounterEntry> const> mCounters;
 
 public:
-    AION_GETTER(Actions);
-    AION_GETTER(Roots);
-    AION_GETTER(Labels);
+    ActionNodes const& nodes() const { return *mNodes; }
+    std::vector<ActionLabel*> const& getLabels() const { return mNodes->labels; }
+    std::vector<CounterEntry> const& getCounters() const { return *mCounters; }
+
+    /// values of one counter or gauge label
+    struct CounterSummary
+    {
+        ActionLabel* label;
+        int64_t count;
+        /// sum of all values (meaningful for counters)
+        int64_t sum;
+        /// latest value (meaningful for gauges)
+        int64_t last;
+    };
+
+    size_t getActionCount() const { return mActionCount; }
+    size_t getRootCount() const { return mRoots.size(); }
+
+    /// handle of a node (index into nodes())
+    Action action(int32_t idx) const { return {mNodes.get(), idx}; }
+    std::vector<Action> getRoots() const;
+    /// all actions of this tree (pre-order per root)
+    std::vector<Action> getActions() const;
 
-    size_t getActionCount() const { return mActions.size(); }
+    /// calls f(Action) for all actions of this tree (pre-order per root)
+    template <class F>
+    void forEachAction(F&& f) const
+    {
+        for (auto r : mRoots)
+        {
+            auto end = mNodes->subtreeEnd(r);
+            for (auto i = r; i < end; ++i)
+                f(action(i));
+        }
+    }
+
+    /// empty tree
     ActionTree();
 
-    /// Scopes to all actions of this label (may result in strange behavior for recursive labels)
-    /// New tree is independent
-    SharedActionTree scopeTo(ActionLabel* label);
-    /// Scopes to all given actions (they are the new roots)
-    /// New tree is independent and does not share Action*
-    SharedActionTree scopeTo(std::vector<Action*> const& actions);
+    /// Scopes to all actions of this label
+    /// Nested actions of the same label are part of their outermost one
+    /// New tree references the nodes of this one (no copy)
+    SharedActionTree scopeTo(ActionLabel* label) const;
+    /// Scopes to all given actions (they are the new roots, actions inside another one are skipped)
+    /// New tree references the nodes of this one (no copy)
+    SharedActionTree scopeTo(std::vector<Action> const& actions) const;
 
     /// Dumps the _complete_ tree into the provided oss
     void dump(std::ostream& oss) const;
 
+    /// adds counter values (e.g. ActionLabel::copyAllCounterEntries)
+    /// labelIdx refers to the labels of this tree (values of unknown labels are ignored)
+    void addCounters(std::vector<CounterEntry> const& counters);
+    /// all counter values recorded by the thread of 'a' while 'a' was running (incl. its children)
+    /// e.g. vertices built per buildMesh() call
+    std::vector<CounterSummary> countersOf(Action a) const;
+
 public:
     /// constructs an action tree from a given recording
     /// all unterminated actions will be aligned to the last entry
     /// if entry stack goes below zero, it is invalid (behavior may change in the future)
+    /// entries of different threads may be interleaved (one stack per ActionEntry::threadIdx)
     static SharedActionTree construct(std::vector<ActionEntry> const& entries, std::vector<ActionLabel*> const& labels);
+
+    /// constructs one tree per thread
+    /// result is indexed by ActionEntry::threadIdx (threads without entries get empty trees)
+    /// all trees reference the same nodes
+    static std::vector<SharedActionTree> constructPerThread(std::vector<ActionEntry> const& entries,
+                                                            std::vector<ActionLabel*> const& labels);
 };
 }
@@ -1,6 +1,56 @@
 #include "MessageQueue.hh"
 
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#endif
 
-void _dummy_MessageQueue_cc()
+using namespace aion;
+
+#ifdef __linux__
+void detail::parkWait(std::atomic<uint32_t> *addr, uint32_t expected, int timeoutMS)
+{
+    timespec ts;
+    ts.tv_sec = timeoutMS / 1000;
+    ts.tv_nsec = (timeoutMS % 1000) * 1000000L;
+
+    // (std::atomic<uint32_t> has the layout of uint32_t)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, expected, timeoutMS < 0 ? nullptr : &ts, nullptr, 0);
+}
+
+void detail::parkWakeAll(std::atomic<uint32_t> *addr)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+#else
+namespace
+{
+// shared by all queues (waking is rare)
+std::mutex sParkMutex;
+std::condition_variable sParkCondition;
+}
+
+void detail::parkWait(std::atomic<uint32_t> *addr, uint32_t expected, int timeoutMS)
+{
+    std::unique_lock<std::mutex> lock(sParkMutex);
+    if (addr->load() != expected)
+        return;
+
+    if (timeoutMS < 0)
+        sParkCondition.wait(lock);
+    else
+        sParkCondition.wait_for(lock, std::chrono::milliseconds(timeoutMS));
+}
+
+void detail::parkWakeAll(std::atomic<uint32_t> *)
 {
-}
\ No newline at end of file
+    // lock: waiters are either before their check or waiting
+    std::lock_guard<std::mutex> lock(sParkMutex);
+    sParkCondition.notify_all();
+}
+#endif
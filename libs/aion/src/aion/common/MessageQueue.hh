@@ -1,11 +1,25 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
-#include <queue>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <queue>
+#include <type_traits>
+#include <vector>
 
 namespace aion
 {
+namespace detail
+{
+/// blocks while *addr == expected (futex on Linux), timeoutMS < 0 means no timeout
+/// may return spuriously
+void parkWait(std::atomic<uint32_t>* addr, uint32_t expected, int timeoutMS);
+/// wakes all threads parked on addr
+void parkWakeAll(std::atomic<uint32_t>* addr);
+}
+
 /**
  * @brief A generic message queue
  *
@@ -25,8 +39,14 @@ namespace aion
  *          // Do something with msg
  *      }
  *
- * Can also be used as priority queue:
+ * Blocking receiver:
+ *      while (q.receiveWait(msg))
+ *          ...
+ *
+ * Can also be used as priority queue (mutex-based):
  * MessageQueue<int, std::priority_queue<int> > q;
+ *
+ * The default (FIFO) queue is lock-free for senders (see specialization below).
  */
 template <class T, class QueueT = std::queue<T>>
 class MessageQueue
@@ -35,6 +55,9 @@ private:
     /// The queue
     QueueT mQueue;
 
+    /// number of queued messages (readable without lock)
+    std::atomic<std::size_t> mSize{0};
+
     /// message mutex
     std::mutex mMutex;
 
@@ -44,13 +67,16 @@ private:
 public:
     /// ctor
     MessageQueue() {}
-    MessageQueue(MessageQueue const &q) : mQueue(q.mQueue) {}
+    MessageQueue(MessageQueue const &) = delete;
+    MessageQueue &operator=(MessageQueue const &) = delete;
+
     /// Sends a msg
     void send(const T &_msg)
     {
         std::lock_guard<std::mutex> _lock(mMutex);
 
         mQueue.push(_msg);
+        ++mSize;
     }
 
     /// Sends a msg
@@ -59,16 +85,17 @@ public:
         std::lock_guard<std::mutex> _lock(mMutex);
 
         mQueue.push(std::move(_msg));
+        ++mSize;
     }
 
     /// Gets the size of the msg queue
-    std::size_t size() const { return mQueue.size(); }
+    std::size_t size() const { return mSize.load(); }
     /// Checks if messages are available (does not lock)
-    bool hasMessage() const { return mQueue.size() > 0; }
+    bool hasMessage() const { return mSize.load() > 0; }
     /// Receives messages (leaves it unchanged if nothing is available)
     bool receive(T &_msg)
     {
-        if (mQueue.size() == 0)
+        if (mSize.load() == 0)
             return false;
 
         std::lock_guard<std::mutex> _lock(mMutex);
@@ -78,16 +105,34 @@ public:
 
         _msg = front(mQueue);
         mQueue.pop();
+        --mSize;
 
         return true;
     }
 
+    /**
+     * @brief appends all messages to 'msgs', returns the number of messages
+     */
+    std::size_t drain(std::vector<T> &msgs)
+    {
+        std::lock_guard<std::mutex> _lock(mMutex);
+        auto cnt = mQueue.size();
+        while (!mQueue.empty())
+        {
+            msgs.push_back(front(mQueue));
+            mQueue.pop();
+        }
+        mSize -= cnt;
+        return cnt;
+    }
+
     /**
      * @brief clears this queue
      */
     void clear()
     {
         std::lock_guard<std::mutex> _lock(mMutex);
+        mSize -= mQueue.size();
         while (!mQueue.empty())
             mQueue.pop();
     }
@@ -97,14 +142,204 @@ public:
      */
     std::vector<T> copyAndClear()
     {
-        std::lock_guard<std::mutex> _lock(mMutex);
         std::vector<T> v;
-        while (!mQueue.empty())
+        drain(v);
+        return v;
+    }
+};
+
+/**
+ * @brief Lock-free multi-producer single-consumer FIFO queue
+ *
+ * Intrusive linked list (Vyukov): send() is one allocation, one atomic exchange and one store,
+ * senders never wait for each other or the reader.
+ * Readers are serialized by a reader mutex (uncontended with a single reader).
+ *
+ * Blocking receives park the reader (futex on Linux),
+ * senders only issue a wake-up syscall if the reader is parked.
+ */
+template <class T>
+class MessageQueue<T, std::queue<T>>
+{
+private:
+    struct Node
+    {
+        std::atomic<Node*> next{nullptr};
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* value() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    /// last sent node (senders)
+    std::atomic<Node*> mTail;
+    /// consumed node before the first message (reader, value already moved out)
+    Node* mHead;
+
+    std::atomic<std::size_t> mSize{0};
+
+    /// incremented on every send (parking word)
+    std::atomic<uint32_t> mSignal{0};
+    /// true while the reader is parked
+    std::atomic<bool> mParked{false};
+
+    /// serializes readers
+    std::mutex mReadMutex;
+
+public:
+    /// ctor
+    MessageQueue()
+    {
+        mHead = new Node;
+        mTail.store(mHead);
+    }
+    MessageQueue(MessageQueue const&) = delete;
+    MessageQueue& operator=(MessageQueue const&) = delete;
+
+    ~MessageQueue()
+    {
+        clear();
+        delete mHead;
+    }
+
+    /// Sends a msg
+    void send(const T& _msg)
+    {
+        auto n = new Node;
+        new (n->value()) T(_msg);
+        push(n);
+    }
+
+    /// Sends a msg
+    void send(T&& _msg)
+    {
+        auto n = new Node;
+        new (n->value()) T(std::move(_msg));
+        push(n);
+    }
+
+    /// Gets the size of the msg queue
+    std::size_t size() const { return mSize.load(); }
+    /// Checks if messages are available (does not lock)
+    /// (may be true shortly before a concurrently sent message can be received)
+    bool hasMessage() const { return mSize.load() > 0; }
+
+    /// Receives messages (leaves it unchanged if nothing is available)
+    bool receive(T& _msg)
+    {
+        if (mSize.load() == 0)
+            return false;
+
+        std::lock_guard<std::mutex> _lock(mReadMutex);
+        return pop(_msg);
+    }
+
+    /// Receives a message, parks until one is available or the timeout (< 0: none) expires
+    bool receiveWait(T& _msg, int timeoutMS = -1)
+    {
+        std::lock_guard<std::mutex> _lock(mReadMutex);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMS);
+        while (true)
         {
-            v.push_back(front(mQueue));
-            mQueue.pop();
+            auto signal = mSignal.load();
+            if (pop(_msg))
+                return true;
+
+            auto waitMS = -1;
+            if (timeoutMS >= 0)
+            {
+                waitMS = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (waitMS < 0)
+                    return false;
+            }
+
+            mParked.store(true);
+            // re-check after announcing (senders check mParked after signaling)
+            if (mSignal.load() == signal)
+                detail::parkWait(&mSignal, signal, waitMS);
+            mParked.store(false);
         }
+    }
+
+    /**
+     * @brief appends all messages to 'msgs', returns the number of messages
+     */
+    std::size_t drain(std::vector<T>& msgs)
+    {
+        std::lock_guard<std::mutex> _lock(mReadMutex);
+
+        auto cnt = std::size_t{0};
+        while (popWith([&](T& v)
+                       {
+                           msgs.push_back(std::move(v));
+                       }))
+            ++cnt;
+        return cnt;
+    }
+
+    /**
+     * @brief clears this queue
+     */
+    void clear()
+    {
+        std::lock_guard<std::mutex> _lock(mReadMutex);
+        while (popWith([](T&)
+                       {
+                       }))
+        {
+        }
+    }
+
+    /**
+     * @brief clears this queue and returns a copy of all elements
+     */
+    std::vector<T> copyAndClear()
+    {
+        std::vector<T> v;
+        drain(v);
         return v;
     }
+
+private:
+    void push(Node* n)
+    {
+        // counted before linking: the reader can only pop (and decrement) linked nodes,
+        // so mSize never underflows (it may briefly include a message that is not yet poppable)
+        ++mSize;
+        auto prev = mTail.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+
+        mSignal.fetch_add(1);
+        if (mParked.load())
+            detail::parkWakeAll(&mSignal);
+    }
+
+    /// CAUTION: mReadMutex must be held
+    /// calls f(first message) and removes it, false if empty
+    template <class F>
+    bool popWith(F&& f)
+    {
+        auto next = mHead->next.load(std::memory_order_acquire);
+        if (!next) // empty (or a sender is between exchange and link)
+            return false;
+
+        f(*next->value());
+        next->value()->~T();
+
+        // next becomes the new (consumed) head
+        delete mHead;
+        mHead = next;
+        --mSize;
+        return true;
+    }
+
+    /// CAUTION: mReadMutex must be held
+    bool pop(T& msg)
+    {
+        return popWith([&](T& v)
+                       {
+                           msg = std::move(v);
+                       });
+    }
 };
 }
@@ -2,16 +2,24 @@
 
 #include "snappy/snappy.hh"
 
+#include <fcntl.h>
 #include <fstream>
 
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "NetMessageReader.hh"
+#include "SnappyStream.hh"
 
 using namespace aion;
 
 void NetMessage::appendData(const char *data, std::size_t count)
 {
-    mData.resize(mData.size() + count);
-    memcpy(&mData[mData.size() - count], data, count);
+    // no zero-fill (unlike resize)
+    mData.insert(mData.end(), data, data + count);
 }
 
 void NetMessage::appendByte(char _c)
@@ -133,61 +141,31 @@ void NetMessage::verifyTypeInfo(const std::string &type, const std::string &fiel
     break;
     case TypeInformation::Strings:
     {
-        // Read Type Info
-        unsigned int size = 0;
-        readData((char *)&size, sizeof(size));
-        if (size > MaxStringSize)
-        {
-            if (mVerboseErrors)
-            {
-                std::cerr << "Trying to read a std::string with size " << size << "which is quite too long" << std::endl;
-                assert(0);
-            }
-            mGood = false;
+        // compared in place
+        std::string stype, sfield;
+        auto typeOk = matchString(type, stype);
+        if (!mGood)
             return;
-        }
-        char *stype = new char[size + 1];
-        if (size > 0)
-            readData(stype, size);
-        stype[size] = '\0';
-
-        // Read Field Info
-        readData((char *)&size, sizeof(size));
-        if (size > MaxStringSize)
-        {
-            if (mVerboseErrors)
-            {
-                std::cerr << "Trying to read a std::string with size " << size << "which is quite too long" << std::endl;
-                assert(0);
-            }
-            delete[] stype;
-            mGood = false;
+        auto fieldOk = matchString(field, sfield);
+        if (!mGood)
             return;
-        }
-        char *sfield = new char[size + 1];
-        if (size > 0)
-            readData(sfield, size);
-        sfield[size] = '\0';
 
         // Verify Type and Field
-        if (strcmp(stype, type.c_str()) != 0 || strcmp(sfield, field.c_str()) != 0)
+        if (!typeOk || !fieldOk)
         {
             mGood = false;
             if (mVerboseErrors)
             {
+                if (typeOk)
+                    stype = type;
+                if (fieldOk)
+                    sfield = field;
                 std::cerr << "Expected [type `" << type << "', field `" << field << "'] but found [type `" << stype
                           << "', field `" << sfield << "']" << std::endl;
                 assert(0);
             }
-            delete[] stype;
-            delete[] sfield;
             return;
         }
-        else
-        {
-            delete[] stype;
-            delete[] sfield;
-        }
     }
     break;
     default:
@@ -197,6 +175,33 @@ void NetMessage::verifyTypeInfo(const std::string &type, const std::string &fiel
     }
 }
 
+bool NetMessage::matchString(const std::string &expected, std::string &found)
+{
+    unsigned int size = 0;
+    readData((char *)&size, sizeof(size));
+    if (!mGood)
+        return false;
+    if (size > MaxStringSize || size > mData.size() - mPosition)
+    {
+        if (mVerboseErrors)
+        {
+            std::cerr << "Trying to read a std::string with size " << size << "which is quite too long" << std::endl;
+            assert(0);
+        }
+        mGood = false;
+        return false;
+    }
+
+    auto data = mData.data() + mPosition;
+    mPosition += size;
+
+    if (size == expected.size() && memcmp(data, expected.data(), size) == 0)
+        return true;
+
+    found.assign(data, size);
+    return false;
+}
+
 void NetMessage::internalWriteIntPacked(int64_t value)
 {
     // write sign and first byte
@@ -393,19 +398,117 @@ void NetMessage::send(std::vector<char> &output)
     }
 }
 
+namespace
+{
+/// file header of writeToFd (first byte is never a valid options byte)
+const char sFileMagic[8] = {'\xFF', 'A', 'I', 'O', 'N', 'M', 'S', 'G'};
+
+struct FileHeader
+{
+    char magic[8];
+    uint8_t options;
+    uint8_t typeInfo;
+    uint8_t reserved[6];
+    uint64_t size;
+};
+static_assert(sizeof(FileHeader) == 24, "unexpected padding");
+
+int openFile(std::string const &filename, bool write)
+{
+#ifdef _MSC_VER
+    return write ? _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE) :
+                   _open(filename.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    return write ? ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644) : ::open(filename.c_str(), O_RDONLY);
+#endif
+}
+
+void closeFile(int fd)
+{
+#ifdef _MSC_VER
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+}
+
+bool NetMessage::writeToFd(int fd, int threads)
+{
+    // stream is compressed chunk-wise
+    decompress();
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, sFileMagic, sizeof(sFileMagic));
+    header.options = mOptions;
+    header.typeInfo = (uint8_t)mTypeInfo;
+    header.size = mData.size();
+    if (!writeAllToFd(fd, (char const *)&header, sizeof(header)))
+        return false;
+
+    SnappyStreamWriter w(fd, threads);
+    w.write(mData.data(), mData.size());
+    return w.finish();
+}
+
+SharedNetMessage NetMessage::readFromFd(int fd)
+{
+    FileHeader header;
+    if (readAllFromFd(fd, (char *)&header, sizeof(header)) != sizeof(header) || memcmp(header.magic, sFileMagic, sizeof(sFileMagic)) != 0)
+    {
+        std::cerr << "No framed NetMessage found" << std::endl;
+        return nullptr;
+    }
+
+    if (header.options == NetMessageOptions::UNINITIALIZED || header.typeInfo > (uint8_t)TypeInformation::Strings)
+    {
+        std::cerr << "Invalid NetMessage header" << std::endl;
+        return nullptr;
+    }
+
+    auto msg = std::make_shared<NetMessage>(header.options, (TypeInformation)header.typeInfo);
+
+    // grows step-wise (size is not trusted)
+    const uint64_t step = 64 * 1024 * 1024;
+    msg->mData.reserve(std::min(header.size, step));
+    SnappyStreamReader r(fd);
+    while (msg->mData.size() < header.size)
+    {
+        auto offset = msg->mData.size();
+        auto cnt = std::min(header.size - offset, step);
+        msg->mData.resize(offset + cnt);
+        if (r.read(msg->mData.data() + offset, cnt) != cnt)
+        {
+            std::cerr << "NetMessage data is truncated or corrupt" << std::endl;
+            return nullptr;
+        }
+    }
+
+    // end frame
+    char rest;
+    if (r.read(&rest, 1) != 0 || !r.isEnd())
+    {
+        std::cerr << "NetMessage data has an unexpected size" << std::endl;
+        return nullptr;
+    }
+
+    return msg;
+}
+
 void NetMessage::writeToFile(const std::string &filename)
 {
-    std::ofstream file(filename);
-    if (!file.good())
+    auto fd = openFile(filename, true);
+    if (fd < 0)
     {
         std::cerr << "Unable to open " << filename << " for writing" << std::endl;
         return;
     }
 
-    std::vector<char> data;
-    send(data);
+    if (!writeToFd(fd))
+        std::cerr << "Unable to write " << filename << std::endl;
 
-    file.write(data.data(), data.size());
+    closeFile(fd);
 }
 
 static std::vector<char> ReadAllBytes(std::string const &filename)
@@ -423,12 +526,28 @@ static std::vector<char> ReadAllBytes(std::string const &filename)
 
 SharedNetMessage NetMessage::readFromFile(const std::string &filename)
 {
-    if (!std::ifstream(filename).good())
+    auto fd = openFile(filename, false);
+    if (fd < 0)
     {
         std::cerr << "Unable to open " << filename << " for reading" << std::endl;
         return nullptr;
     }
 
+    char magic[sizeof(sFileMagic)];
+    auto framed = readAllFromFd(fd, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, sFileMagic, sizeof(magic)) == 0;
+    closeFile(fd);
+
+    if (framed)
+    {
+        fd = openFile(filename, false);
+        auto m = readFromFd(fd);
+        closeFile(fd);
+        if (!m)
+            std::cerr << "Unable to read " << filename << std::endl;
+        return m;
+    }
+
+    // older files: output of send()
     auto bytes = ReadAllBytes(filename);
     NetMessageReader r;
     r.pushBytes(bytes.data(), bytes.size());
@@ -498,15 +617,16 @@ void NetMessage::compress()
     if (!(mOptions & NetMessageOptions::compressed))
         return;
 
-    std::string compressedData;
-    auto bytes_written = snappy::Compress(mData.data(), mData.size(), &compressedData);
+    std::vector<char> compressedData(snappy::MaxCompressedLength(mData.size()));
+    size_t bytes_written = 0;
+    snappy::RawCompress(mData.data(), mData.size(), compressedData.data(), &bytes_written);
     assert(bytes_written > 0);
 
     // UE_LOG(Info, Low, "Compression : " << mData.size() << " -> " << compressedData.size() << " (" <<
     // double(compressedData.size()*100)/mData.size() << "%)");
 
-    mData.resize(bytes_written);
-    std::copy(begin(compressedData), end(compressedData), begin(mData));
+    compressedData.resize(bytes_written);
+    mData.swap(compressedData);
 
     mIsCompressed = true;
 }
@@ -520,15 +640,24 @@ void NetMessage::decompress()
     if (!(mOptions & NetMessageOptions::compressed))
         return;
 
-
-    std::string uncompressedData(snappy::MaxCompressedLength(mData.size()), 'x');
-    auto success = snappy::Uncompress(mData.data(), mData.size(), &uncompressedData);
+    // (size is stored in the snappy header)
+    size_t uncompressedSize = 0;
+    std::vector<char> uncompressedData;
+    auto success = snappy::GetUncompressedLength(mData.data(), mData.size(), &uncompressedSize);
+    if (success)
+    {
+        uncompressedData.resize(uncompressedSize);
+        success = snappy::RawUncompress(mData.data(), mData.size(), uncompressedData.data());
+    }
     if (!success)
+    {
         std::cerr << "Decompression of NetMessage was not successful" << std::endl;
+        mGood = false;
+        return;
+    }
     // UE_LOG(Info, Low, "Decompression: " << mData.size() << " -> " << uncompressedData.size() << " ("
     // << double(mData.size())/uncompressedData.size() << "%)");
-    mData.resize(uncompressedData.size());
-    std::copy(begin(uncompressedData), end(uncompressedData), begin(mData));
+    mData.swap(uncompressedData);
 
     mIsCompressed = false;
 }
@@ -578,12 +707,13 @@ std::string NetMessage::readString(const std::string &field)
         mGood = false;
         return "";
     }
-    char *stype = new char[size + 1];
-    if (size > 0)
-        readData((char *)stype, size);
-    stype[size] = '\0';
+    if (size > mData.size() - mPosition)
+    {
+        readData(nullptr, size); // reports the error
+        return "";
+    }
 
-    std::string value(stype);
-    delete[] stype;
+    std::string value(mData.data() + mPosition, size);
+    mPosition += size;
     return value;
 }
@@ -256,6 +256,18 @@ private:
     /// Verifies type information about type and field
     void verifyTypeInfo(const std::string &type, const std::string &field);
 
+    /// type name of writeStruct/readStruct (built once per type)
+    template <typename T>
+    static std::string const &structTypeName()
+    {
+        static const std::string name = std::string("struct ") + typeid(T).name();
+        return name;
+    }
+
+    /// Compares a stored string with the expected one (without copy), advances mPosition
+    /// 'found' is only set on mismatch
+    bool matchString(const std::string &expected, std::string &found);
+
     /// writes a packed int without type info
     void internalWriteIntPacked(int64_t value);
 
@@ -284,7 +296,16 @@ public:
     /// Writes a header and the content of this message to a stream
     void send(std::vector<char> &output);
 
+    /// Writes the message framed and chunk-wise compressed (see SnappyStreamWriter)
+    /// Memory use is independent of the message size, blocks are compressed in parallel
+    /// Returns false on errors
+    bool writeToFd(int fd, int threads = 0);
+    /// Reads a message written by writeToFd, nullptr on errors
+    static SharedNetMessage readFromFd(int fd);
+
+    /// Uses writeToFd
     void writeToFile(std::string const& filename);
+    /// Reads files of writeToFile (and older files containing the output of send())
     static SharedNetMessage readFromFile(std::string const& filename);
 
     /// Append another netMessage
@@ -366,14 +387,15 @@ public:
     template <typename T>
     void writeStruct(T &value, const std::string &field)
     {
-        writeTypeInfo(std::string("struct ") + typeid(T).name(), field);
+        writeTypeInfo(structTypeName<T>(), field);
         appendData((char *)&value, sizeof(T));
     }
 
-    template <typename T>
+    /// 'TagT' is the type the struct was written as (for reading older layouts of a type)
+    template <typename T, typename TagT = T>
     T readStruct(const std::string &field)
     {
-        verifyTypeInfo(std::string("struct ") + typeid(T).name(), field);
+        verifyTypeInfo(structTypeName<TagT>(), field);
         T value;
         readData((char *)&value, sizeof(T));
         return value;
@@ -382,10 +404,11 @@ public:
     template <typename T>
     void readStruct(T &value, const std::string &field)
     {
-        verifyTypeInfo(std::string("struct ") + typeid(T).name(), field);
+        verifyTypeInfo(structTypeName<T>(), field);
         readData((char *)&value, sizeof(T));
     }
 
     friend class NetMessageReader;
+    friend class NetMessageView;
 };
 }
@@ -2,8 +2,89 @@
 
 #include "NetMessage.hh"
 
+#include "snappy/snappy.hh"
+
 using namespace aion;
 
+void NetMessageView::loadInto(NetMessage &msg) const
+{
+    msg.setData(mData, mSize, false);
+    msg.mOptions = mOptions;
+    msg.mTypeInfo = mTypeInfo;
+    msg.mGood = true;
+}
+
+bool NetMessageReader::parseHeader(const char *data, std::size_t size, std::size_t &headerSize, std::size_t &msgSize)
+{
+    const int nextMask = 1 << 7;
+
+    // options byte and at least one size byte
+    if (size < 2)
+        return false;
+
+    auto c = (uint8_t)data[1];
+    if ((c & 0x3) > (int)NetMessage::TypeInformation::Strings)
+    {
+        std::cerr << "Invalid NetMessage header (type information " << (c & 0x3) << ")" << std::endl;
+        mCorrupt = true;
+        return false;
+    }
+
+    msgSize = (c & ~nextMask) >> 2;
+    headerSize = 2;
+    auto shift = 5;
+    while (c & nextMask)
+    {
+        // at most 4 size bytes (see NetMessage::send)
+        if (headerSize == 5)
+        {
+            std::cerr << "Invalid NetMessage header (size too large)" << std::endl;
+            mCorrupt = true;
+            return false;
+        }
+        if (headerSize == size)
+            return false;
+
+        c = (uint8_t)data[headerSize++];
+        msgSize += (std::size_t)(c & ~nextMask) << shift;
+        shift += 7;
+    }
+
+    return true;
+}
+
+bool NetMessageReader::makeView(const char *msg, std::size_t headerSize, std::size_t msgSize, NetMessageView &view)
+{
+    auto options = (NetMessageOptions::Type)msg[0];
+    auto typeInfo = (NetMessage::TypeInformation)(msg[1] & 0x3);
+    auto payload = msg + headerSize;
+
+    if (!(options & NetMessageOptions::compressed) || msgSize == 0)
+    {
+        view = NetMessageView(payload, msgSize, options, typeInfo);
+        return true;
+    }
+
+    // (scratch only grows)
+    size_t uncompressedSize = 0;
+    auto success = snappy::GetUncompressedLength(payload, msgSize, &uncompressedSize);
+    if (success)
+    {
+        if (mScratch.size() < uncompressedSize)
+            mScratch.resize(uncompressedSize);
+        success = snappy::RawUncompress(payload, msgSize, mScratch.data());
+    }
+    if (!success)
+    {
+        std::cerr << "Decompression of NetMessage was not successful" << std::endl;
+        mCorrupt = true;
+        return false;
+    }
+
+    view = NetMessageView(mScratch.data(), uncompressedSize, options, typeInfo);
+    return true;
+}
+
 void NetMessageReader::pushByte(uint8_t _c)
 {
     const int nextMask = 1 << 7;
@@ -1,15 +1,51 @@
 #pragma once
 
 //! Includes System
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <vector>
 
 #include "shared.hh"
 
 #include "MessageQueue.hh"
+#include "NetMessage.hh"
 
 namespace aion
 {
-AION_SHARED(class, NetMessage);
+/**
+ * @brief Non-owning view of a received message (see NetMessageReader::parseMessages)
+ *
+ * References the input bytes (or the decompression scratch of the reader),
+ * only valid during the parseMessages callback.
+ */
+class NetMessageView
+{
+private:
+    char const *mData = nullptr;
+    std::size_t mSize = 0;
+    NetMessageOptions::Type mOptions = 0;
+    NetMessage::TypeInformation mTypeInfo = NetMessage::TypeInformation::None;
+
+public:
+    NetMessageView() = default;
+    NetMessageView(char const *data, std::size_t size, NetMessageOptions::Type options, NetMessage::TypeInformation typeInfo)
+      : mData(data), mSize(size), mOptions(options), mTypeInfo(typeInfo)
+    {
+    }
+
+    /// (uncompressed) payload
+    char const *data() const { return mData; }
+    std::size_t size() const { return mSize; }
+
+    NetMessageOptions::Type options() const { return mOptions; }
+    NetMessage::TypeInformation typeInfo() const { return mTypeInfo; }
+
+    /// Copies the payload into 'msg' for typed reading (resets its position)
+    /// Reusing the same message does not allocate once its capacity suffices
+    void loadInto(NetMessage &msg) const;
+};
 
 /**
  * @brief Convenience class for reading netmessages
@@ -38,6 +74,19 @@ private:
 
     void pushByte(uint8_t _c);
 
+private: // in-place parsing
+    /// decompressed payload of the current view
+    std::vector<char> mScratch;
+    /// message that wrapped around the end of a ring buffer
+    std::vector<char> mJoined;
+    /// true after invalid data was encountered
+    bool mCorrupt = false;
+
+    /// Parses the header at 'data', returns false if incomplete or invalid (sets mCorrupt)
+    bool parseHeader(char const *data, std::size_t size, std::size_t &headerSize, std::size_t &msgSize);
+    /// Creates the view of a complete message (decompressed into mScratch), false on errors
+    bool makeView(char const *msg, std::size_t headerSize, std::size_t msgSize, NetMessageView &view);
+
 public:
     /// Receives a message or returns false if no msg available
     bool receiveMessage(NetMessage *&_msg, bool _doNotDecompress = false);
@@ -45,6 +94,76 @@ public:
     /// "receives" a bytes
     void pushBytes(const char *_data, int _count);
 
+    /**
+     * @brief Parses all complete messages of 'data' in place and calls f(NetMessageView const&) for each
+     *
+     * Returns the number of consumed bytes, a trailing incomplete message is not consumed
+     * (keep its bytes, e.g. in a ring buffer, and pass them again together with new data).
+     * Compressed messages are decompressed into a reused scratch buffer,
+     * i.e. no allocations per message once the buffers are large enough.
+     *
+     * CAUTION: views are only valid during the callback
+     * CAUTION: do not mix with pushBytes on the same stream
+     */
+    template <class F>
+    std::size_t parseMessages(char const *data, std::size_t size, F &&f)
+    {
+        auto pos = std::size_t{0};
+        std::size_t headerSize, msgSize;
+        NetMessageView view;
+        while (parseHeader(data + pos, size - pos, headerSize, msgSize) && headerSize + msgSize <= size - pos)
+        {
+            if (!makeView(data + pos, headerSize, msgSize, view))
+                break;
+            f(view);
+            pos += headerSize + msgSize;
+        }
+        return pos;
+    }
+
+    /**
+     * @brief Same as parseMessages(data, size, f) for a wrapped ring buffer region
+     *
+     * The region starts at 'first' and continues at 'second' (usually the beginning of the ring buffer).
+     * Only a message crossing the wrap is copied (into a reused buffer).
+     */
+    template <class F>
+    std::size_t parseMessages(char const *first, std::size_t firstSize, char const *second, std::size_t secondSize, F &&f)
+    {
+        auto pos = parseMessages(first, firstSize, f);
+        auto rest = firstSize - pos;
+        if (rest == 0)
+            return pos + parseMessages(second, secondSize, f);
+        if (mCorrupt)
+            return pos;
+
+        // header may cross the wrap as well (at most 5 bytes)
+        char header[5];
+        auto headerBytes = std::min(rest, sizeof(header));
+        memcpy(header, first + pos, headerBytes);
+        auto fromSecond = std::min(sizeof(header) - headerBytes, secondSize);
+        memcpy(header + headerBytes, second, fromSecond);
+
+        std::size_t headerSize, msgSize;
+        if (!parseHeader(header, headerBytes + fromSecond, headerSize, msgSize) || headerSize + msgSize > rest + secondSize)
+            return pos;
+
+        auto inSecond = headerSize + msgSize - rest;
+        mJoined.resize(headerSize + msgSize);
+        memcpy(mJoined.data(), first + pos, rest);
+        memcpy(mJoined.data() + rest, second, inSecond);
+
+        NetMessageView view;
+        if (!makeView(mJoined.data(), headerSize, msgSize, view))
+            return pos;
+        f(view);
+
+        return firstSize + inSecond + parseMessages(second + inSecond, secondSize - inSecond, f);
+    }
+
+    /// true if invalid data was encountered by parseMessages
+    bool isCorrupt() const { return mCorrupt; }
+
 public:
     /// ctor
     NetMessageReader();
@@ -0,0 +1,358 @@
+#include "SnappyStream.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "snappy/snappy.hh"
+
+using namespace aion;
+
+const std::size_t SnappyStreamWriter::BlockSize;
+const std::size_t SnappyStreamWriter::FrameHeaderSize;
+const uint32_t SnappyStreamWriter::StoredRaw;
+
+namespace
+{
+/// blocks per worker and batch
+const int sBlocksPerWorker = 4;
+
+/// slicing-by-8 tables (polynomial 0x82F63B78, reflected)
+struct CrcTables
+{
+    uint32_t t[8][256];
+
+    CrcTables()
+    {
+        for (auto i = 0u; i < 256; ++i)
+        {
+            auto c = i;
+            for (auto k = 0; k < 8; ++k)
+                c = c & 1 ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t[0][i] = c;
+        }
+        for (auto i = 0u; i < 256; ++i)
+            for (auto k = 1; k < 8; ++k)
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    }
+};
+
+void writeU32(char *dst, uint32_t v)
+{
+    memcpy(dst, &v, sizeof(v));
+}
+uint32_t readU32(char const *src)
+{
+    uint32_t v;
+    memcpy(&v, src, sizeof(v));
+    return v;
+}
+
+/// compresses one block into 'frame' (header + payload)
+void compressBlock(char const *data, std::size_t size, std::vector<char> &frame)
+{
+    auto const header = SnappyStreamWriter::FrameHeaderSize;
+    frame.resize(header + snappy::MaxCompressedLength(size));
+
+    size_t stored = 0;
+    snappy::RawCompress(data, size, frame.data() + header, &stored);
+
+    auto flags = 0u;
+    if (stored >= size) // incompressible
+    {
+        memcpy(frame.data() + header, data, size);
+        stored = size;
+        flags = SnappyStreamWriter::StoredRaw;
+    }
+
+    writeU32(frame.data(), (uint32_t)size);
+    writeU32(frame.data() + 4, (uint32_t)stored | flags);
+    writeU32(frame.data() + 8, crc32c(data, size));
+    frame.resize(header + stored);
+}
+}
+
+uint32_t aion::crc32c(const char *data, std::size_t size, uint32_t crc)
+{
+    static const CrcTables tables;
+    auto const &t = tables.t;
+
+    auto p = (uint8_t const *)data;
+    crc = ~crc;
+
+    // (little endian)
+    while (size >= 8)
+    {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        w ^= crc;
+        crc = t[7][w & 0xFF] ^ t[6][(w >> 8) & 0xFF] ^ t[5][(w >> 16) & 0xFF] ^ t[4][(w >> 24) & 0xFF] ^ //
+              t[3][(w >> 32) & 0xFF] ^ t[2][(w >> 40) & 0xFF] ^ t[1][(w >> 48) & 0xFF] ^ t[0][w >> 56];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+
+    return ~crc;
+}
+
+bool aion::writeAllToFd(int fd, const char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        // (at most 1 GiB per call)
+        auto chunk = std::min<std::size_t>(size, 1u << 30);
+#ifdef _MSC_VER
+        auto written = _write(fd, data, (unsigned)chunk);
+#else
+        auto written = ::write(fd, data, chunk);
+#endif
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+std::size_t aion::readAllFromFd(int fd, char *data, std::size_t size)
+{
+    auto total = std::size_t{0};
+    while (total < size)
+    {
+        auto chunk = std::min<std::size_t>(size - total, 1u << 30);
+#ifdef _MSC_VER
+        auto cnt = _read(fd, data + total, (unsigned)chunk);
+#else
+        auto cnt = ::read(fd, data + total, chunk);
+#endif
+        if (cnt < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (cnt == 0) // EOF
+            break;
+        total += cnt;
+    }
+    return total;
+}
+
+SnappyStreamWriter::SnappyStreamWriter(int fd, int threads) : mFd(fd)
+{
+    mWorkers = threads > 0 ? threads : std::max(1, (int)std::thread::hardware_concurrency());
+    mFrames.resize(mWorkers * sBlocksPerWorker);
+    mBatch.reserve(batchSize());
+}
+
+SnappyStreamWriter::~SnappyStreamWriter()
+{
+    finish();
+}
+
+bool SnappyStreamWriter::write(const char *data, std::size_t size)
+{
+    assert(!mFinished && "stream already finished");
+    if (!mGood)
+        return false;
+
+    mBytesIn += size;
+
+    // fill pending batch
+    if (!mBatch.empty())
+    {
+        auto cnt = std::min(size, batchSize() - mBatch.size());
+        mBatch.insert(mBatch.end(), data, data + cnt);
+        data += cnt;
+        size -= cnt;
+
+        if (mBatch.size() < batchSize())
+            return true;
+
+        if (!writeBatch(mBatch.data(), mBatch.size()))
+            return false;
+        mBatch.clear();
+    }
+
+    // full batches directly from the input
+    while (size >= batchSize())
+    {
+        if (!writeBatch(data, batchSize()))
+            return false;
+        data += batchSize();
+        size -= batchSize();
+    }
+
+    mBatch.insert(mBatch.end(), data, data + size);
+    return true;
+}
+
+bool SnappyStreamWriter::finish()
+{
+    if (mFinished)
+        return mGood;
+    mFinished = true;
+
+    if (mGood && !mBatch.empty())
+        writeBatch(mBatch.data(), mBatch.size());
+    mBatch.clear();
+
+    // end frame
+    char end[FrameHeaderSize] = {};
+    if (mGood && !writeAllToFd(mFd, end, sizeof(end)))
+        mGood = false;
+    mBytesOut += sizeof(end);
+
+    return mGood;
+}
+
+bool SnappyStreamWriter::writeBatch(const char *data, std::size_t size)
+{
+    auto blocks = (int)((size + BlockSize - 1) / BlockSize);
+    assert(blocks <= (int)mFrames.size());
+
+    auto compressRange = [&](int begin, int step)
+    {
+        for (auto b = begin; b < blocks; b += step)
+        {
+            auto offset = b * BlockSize;
+            compressBlock(data + offset, std::min(BlockSize, size - offset), mFrames[b]);
+        }
+    };
+
+    // last worker runs on this thread
+    auto workers = std::min(mWorkers, blocks);
+    std::vector<std::future<void>> futures;
+    for (auto w = 0; w < workers; ++w)
+        futures.push_back(std::async(w + 1 == workers ? std::launch::deferred : std::launch::async, compressRange, w, workers));
+    for (auto &f : futures)
+        f.get();
+
+    for (auto b = 0; b < blocks; ++b)
+    {
+        if (!writeAllToFd(mFd, mFrames[b].data(), mFrames[b].size()))
+        {
+            std::cerr << "Unable to write compressed stream: " << strerror(errno) << std::endl;
+            mGood = false;
+            return false;
+        }
+        mBytesOut += mFrames[b].size();
+    }
+
+    return true;
+}
+
+SnappyStreamReader::SnappyStreamReader(int fd) : mFd(fd)
+{
+}
+
+std::size_t SnappyStreamReader::read(char *data, std::size_t size)
+{
+    auto total = std::size_t{0};
+    while (total < size)
+    {
+        // buffered block
+        if (mBlockPos < mBlock.size())
+        {
+            auto cnt = std::min(size - total, mBlock.size() - mBlockPos);
+            memcpy(data + total, mBlock.data() + mBlockPos, cnt);
+            mBlockPos += cnt;
+            total += cnt;
+            continue;
+        }
+
+        if (mEnd || !mGood)
+            break;
+
+        auto inTarget = false;
+        auto cnt = nextFrame(data + total, size - total, inTarget);
+        if (inTarget)
+            total += cnt;
+    }
+    return total;
+}
+
+std::size_t SnappyStreamReader::nextFrame(char *target, std::size_t targetSize, bool &inTarget)
+{
+    inTarget = false;
+    mBlock.clear();
+    mBlockPos = 0;
+
+    char header[SnappyStreamWriter::FrameHeaderSize];
+    if (readAllFromFd(mFd, header, sizeof(header)) != sizeof(header))
+    {
+        std::cerr << "Compressed stream is truncated" << std::endl;
+        mGood = false;
+        return 0;
+    }
+
+    auto rawSize = readU32(header);
+    auto storedSize = readU32(header + 4) & ~SnappyStreamWriter::StoredRaw;
+    auto isRaw = (readU32(header + 4) & SnappyStreamWriter::StoredRaw) != 0;
+    auto crc = readU32(header + 8);
+
+    if (rawSize == 0)
+    {
+        mEnd = true;
+        return 0;
+    }
+
+    if (rawSize > SnappyStreamWriter::BlockSize || storedSize > snappy::MaxCompressedLength(rawSize))
+    {
+        std::cerr << "Compressed stream has an invalid frame" << std::endl;
+        mGood = false;
+        return 0;
+    }
+
+    mStored.resize(storedSize);
+    if (readAllFromFd(mFd, mStored.data(), storedSize) != storedSize)
+    {
+        std::cerr << "Compressed stream is truncated" << std::endl;
+        mGood = false;
+        return 0;
+    }
+
+    inTarget = rawSize <= targetSize;
+    char *out;
+    if (inTarget)
+        out = target;
+    else
+    {
+        mBlock.resize(rawSize);
+        out = mBlock.data();
+    }
+
+    size_t uncompressedSize = 0;
+    auto ok = isRaw ? storedSize == rawSize
+                    : snappy::GetUncompressedLength(mStored.data(), storedSize, &uncompressedSize) && uncompressedSize == rawSize
+                          && snappy::RawUncompress(mStored.data(), storedSize, out);
+    if (ok && isRaw)
+        memcpy(out, mStored.data(), rawSize);
+
+    if (!ok || crc32c(out, rawSize) != crc)
+    {
+        std::cerr << "Compressed stream is corrupt (checksum mismatch)" << std::endl;
+        mGood = false;
+        mBlock.clear();
+        inTarget = false;
+        return 0;
+    }
+
+    return rawSize;
+}
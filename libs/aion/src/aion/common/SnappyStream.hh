@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aion
+{
+/// CRC-32C (Castagnoli) of the given data, 'crc' continues a previous checksum
+uint32_t crc32c(char const *data, std::size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Framed, chunked snappy compression to a file descriptor
+ *
+ * Data is split into blocks of BlockSize bytes, every block is a frame:
+ *   uint32 raw size (0 = end of stream)
+ *   uint32 stored size (high bit set: stored uncompressed)
+ *   uint32 CRC-32C of the raw data
+ *   payload
+ *
+ * Blocks are buffered in batches and compressed in parallel,
+ * memory use is bounded by the batch size (independent of the stream size).
+ *
+ * Usage:
+ *   SnappyStreamWriter w(fd);
+ *   w.write(data, size); // any number of times
+ *   w.finish();          // also done in dtor
+ */
+class SnappyStreamWriter
+{
+public:
+    /// raw bytes per frame
+    static const std::size_t BlockSize = 64 * 1024;
+    /// bytes of a frame header
+    static const std::size_t FrameHeaderSize = 12;
+    /// stored size flag for uncompressed blocks
+    static const uint32_t StoredRaw = 1u << 31;
+
+private:
+    int mFd;
+    int mWorkers;
+    bool mGood = true;
+    bool mFinished = false;
+
+    /// raw data of the current batch
+    std::vector<char> mBatch;
+    /// one output buffer per block of a batch (header + payload)
+    std::vector<std::vector<char>> mFrames;
+
+    uint64_t mBytesIn = 0;
+    uint64_t mBytesOut = 0;
+
+public:
+    /// threads = 0 uses all hardware threads
+    /// the fd is not closed
+    explicit SnappyStreamWriter(int fd, int threads = 0);
+    ~SnappyStreamWriter();
+
+    SnappyStreamWriter(SnappyStreamWriter const &) = delete;
+    SnappyStreamWriter &operator=(SnappyStreamWriter const &) = delete;
+
+    /// appends data to the stream, returns false on write errors
+    bool write(char const *data, std::size_t size);
+
+    /// writes all pending blocks and the end frame
+    bool finish();
+
+    bool good() const { return mGood; }
+    uint64_t bytesIn() const { return mBytesIn; }
+    uint64_t bytesOut() const { return mBytesOut; }
+
+private:
+    std::size_t batchSize() const { return mFrames.size() * BlockSize; }
+
+    /// compresses and writes full or final blocks
+    bool writeBatch(char const *data, std::size_t size);
+};
+
+/**
+ * @brief Reads streams of SnappyStreamWriter from a file descriptor
+ *
+ * Frames are read and decompressed one at a time (directly into the target if it is large enough).
+ * Checksums are verified, errors are reported on std::cerr.
+ */
+class SnappyStreamReader
+{
+private:
+    int mFd;
+    bool mGood = true;
+    bool mEnd = false;
+
+    /// stored data of the current frame
+    std::vector<char> mStored;
+    /// decompressed block (if not decompressed into the target)
+    std::vector<char> mBlock;
+    std::size_t mBlockPos = 0;
+
+public:
+    /// the fd is not closed
+    explicit SnappyStreamReader(int fd);
+
+    /// reads up to 'size' bytes, returns the number of bytes read
+    /// (less than 'size' only at the end of the stream or on errors)
+    std::size_t read(char *data, std::size_t size);
+
+    /// false if the stream is corrupt or could not be read
+    bool good() const { return mGood; }
+    /// true if the end frame was read
+    bool isEnd() const { return mEnd; }
+
+private:
+    /// reads the next frame, decompresses into 'target' if it fits (returns raw size), otherwise into mBlock
+    /// returns 0 at the end or on errors
+    std::size_t nextFrame(char *target, std::size_t targetSize, bool &inTarget);
+};
+
+/// loops until all bytes are written (returns false on errors)
+bool writeAllToFd(int fd, char const *data, std::size_t size);
+/// loops until 'size' bytes are read or EOF, returns the number of bytes read
+std::size_t readAllFromFd(int fd, char *data, std::size_t size);
+}
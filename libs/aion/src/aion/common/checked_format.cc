@@ -0,0 +1,190 @@
+#include "checked_format.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+using namespace aion;
+
+int detail::invalidFormatString(const char *)
+{
+    // only reached in constant evaluation (see AION_FMT)
+    return -1;
+}
+
+void FixedFormatBuffer::append(const char *data, std::size_t size)
+{
+    auto cnt = std::min(size, mCapacity - mSize);
+    memcpy(mData + mSize, data, cnt);
+    mSize += cnt;
+    mTruncated |= cnt < size;
+}
+
+void FixedFormatBuffer::append(std::size_t count, char c)
+{
+    auto cnt = std::min(count, mCapacity - mSize);
+    memset(mData + mSize, c, cnt);
+    mSize += cnt;
+    mTruncated |= cnt < count;
+}
+
+void detail::StreamSink::append(const char *data, std::size_t size)
+{
+    if (mSize + size > sizeof(mBuffer))
+    {
+        flush();
+        if (size > sizeof(mBuffer))
+        {
+            mStream.write(data, size);
+            return;
+        }
+    }
+    memcpy(mBuffer + mSize, data, size);
+    mSize += size;
+}
+
+void detail::StreamSink::append(std::size_t count, char c)
+{
+    while (count > 0)
+    {
+        if (mSize == sizeof(mBuffer))
+            flush();
+        auto cnt = std::min(count, sizeof(mBuffer) - mSize);
+        memset(mBuffer + mSize, c, cnt);
+        mSize += cnt;
+        count -= cnt;
+    }
+}
+
+void detail::StreamSink::flush()
+{
+    if (mSize > 0)
+        mStream.write(mBuffer, mSize);
+    mSize = 0;
+}
+
+const char *detail::parseField(const char *s, FormatSpec &spec)
+{
+    // (validated by AION_FMT)
+    if (*s == '}')
+        return s + 1;
+    ++s; // ':'
+
+    if (*s != '}' && isAlign(s[1]))
+    {
+        spec.fill = *s;
+        spec.align = s[1];
+        s += 2;
+    }
+    else if (isAlign(*s))
+        spec.align = *s++;
+
+    if (isSign(*s))
+        spec.sign = *s++;
+    if (*s == '#')
+    {
+        spec.alt = true;
+        ++s;
+    }
+    if (*s == '0')
+    {
+        spec.zero = true;
+        ++s;
+    }
+    while (isDigit(*s))
+        spec.width = spec.width * 10 + (*s++ - '0');
+    if (*s == '.')
+    {
+        ++s;
+        spec.precision = 0;
+        while (isDigit(*s))
+            spec.precision = spec.precision * 10 + (*s++ - '0');
+    }
+    if (*s != '}')
+        spec.type = *s++;
+
+    return s + 1;
+}
+
+char *detail::formatInteger(char *end, uint64_t value, bool negative, const FormatSpec &spec, int &signSize)
+{
+    static const char lower[] = "0123456789abcdef";
+    static const char upper[] = "0123456789ABCDEF";
+
+    auto p = end;
+    switch (spec.type)
+    {
+    case 'x':
+    case 'X':
+    {
+        auto digits = spec.type == 'x' ? lower : upper;
+        do
+            *--p = digits[value & 0xF];
+        while (value >>= 4);
+        break;
+    }
+    case 'o':
+        do
+            *--p = char('0' + (value & 0x7));
+        while (value >>= 3);
+        break;
+    case 'b':
+        do
+            *--p = char('0' + (value & 0x1));
+        while (value >>= 1);
+        break;
+    default:
+        do
+            *--p = char('0' + value % 10);
+        while (value /= 10);
+        break;
+    }
+
+    auto digitsBegin = p;
+    if (spec.alt)
+    {
+        if (spec.type == 'x' || spec.type == 'X' || spec.type == 'b')
+        {
+            *--p = spec.type;
+            *--p = '0';
+        }
+        else if (spec.type == 'o')
+            *--p = '0';
+    }
+
+    if (negative)
+        *--p = '-';
+    else if (spec.sign == '+' || spec.sign == ' ')
+        *--p = spec.sign;
+
+    signSize = int(digitsBegin - p);
+    return p;
+}
+
+int detail::formatFloat(char *buffer, double value, const FormatSpec &spec, int &signSize)
+{
+    // printf format without width (padding is done by writePadded)
+    char format[8];
+    auto f = format;
+    *f++ = '%';
+    if (spec.sign == '+' || spec.sign == ' ')
+        *f++ = spec.sign;
+    if (spec.alt)
+        *f++ = '#';
+    if (spec.precision >= 0)
+    {
+        *f++ = '.';
+        *f++ = '*';
+    }
+    *f++ = spec.type && spec.type != 's' ? spec.type : 'g';
+    *f = 0;
+
+    // (precision is bounded such that every double fits into FloatBufferSize)
+    auto size = spec.precision >= 0 ? snprintf(buffer, FloatBufferSize, format, std::min(spec.precision, 100), value)
+                                    : snprintf(buffer, FloatBufferSize, format, value);
+    size = std::max(0, std::min(size, FloatBufferSize - 1));
+
+    signSize = size > 0 && (buffer[0] == '-' || buffer[0] == '+' || buffer[0] == ' ') ? 1 : 0;
+    return size;
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+
+/**
+ * Compile-time checked, allocation-free formatting (subset of the aion_fmt/Python syntax)
+ *
+ * Format strings are validated at compile time (syntax and argument count),
+ * output is written into a caller-supplied sink without std::string temporaries:
+ *   - FixedFormatBuffer / StackFormatBuffer<N> (truncates, never allocates)
+ *   - std::string (appends, reusing its capacity)
+ *   - std::ostream (via a small stack buffer)
+ *
+ * Usage:
+ *   StackFormatBuffer<64> buf;
+ *   aion::formatTo(buf, AION_FMT("{:6.2f}ms"), ms);
+ *   aion::formatTo(oss, AION_FMT("{} of {}"), a, b);
+ *   auto s = aion::formatString(AION_FMT("Thread {}"), idx);
+ *
+ * Replacement fields: {} or {:spec} with spec = [[fill]align][sign][#][0][width][.precision][type]
+ *   align: < > ^, sign: + - space, type: d x X o b c (integers), f F e E g G (floats), s (strings), p (pointers)
+ * Arguments: integers, bool, char, floats, char const*, std::string, pointers
+ * Positional arguments and dynamic widths are not supported.
+ *
+ * CAUTION: format strings are parsed by constexpr recursion (one level per character),
+ *          i.e. they are limited to a few hundred characters
+ */
+
+namespace aion
+{
+namespace detail
+{
+/// not constexpr: reaching it during constant evaluation is a compile error showing 'reason'
+int invalidFormatString(char const *reason);
+
+constexpr bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+constexpr bool isAlign(char c)
+{
+    return c == '<' || c == '>' || c == '^';
+}
+constexpr bool isSign(char c)
+{
+    return c == '+' || c == '-' || c == ' ';
+}
+constexpr bool isType(char c)
+{
+    return c == 'd' || c == 'x' || c == 'X' || c == 'o' || c == 'b' || c == 'c' || c == 'f' || c == 'F' || c == 'e'
+           || c == 'E' || c == 'g' || c == 'G' || c == 's' || c == 'p';
+}
+
+// spec parsing, nullptr on errors
+constexpr char const *skipDigits(char const *s)
+{
+    return isDigit(*s) ? skipDigits(s + 1) : s;
+}
+constexpr char const *parseAlign(char const *s)
+{
+    return *s != '{' && *s != '}' && *s != 0 && isAlign(s[1]) ? s + 2 : isAlign(*s) ? s + 1 : s;
+}
+constexpr char const *parseSign(char const *s)
+{
+    return isSign(*s) ? s + 1 : s;
+}
+constexpr char const *parseAlt(char const *s)
+{
+    return *s == '#' ? s + 1 : s;
+}
+constexpr char const *parsePrecision(char const *s)
+{
+    return *s != '.' ? s : isDigit(s[1]) ? skipDigits(s + 1) : nullptr;
+}
+constexpr char const *parseType(char const *s)
+{
+    return s && isType(*s) ? s + 1 : s;
+}
+constexpr char const *parseSpec(char const *s)
+{
+    return parseType(parsePrecision(skipDigits(parseAlt(parseSign(parseAlign(s))))));
+}
+
+/// end of a replacement field (after '}'), s points behind '{'
+constexpr char const *fieldEnd(char const *s)
+{
+    return *s == '}' ? s + 1 : *s != ':' ? nullptr : parseSpec(s + 1) && *parseSpec(s + 1) == '}' ? parseSpec(s + 1) + 1 : nullptr;
+}
+
+constexpr int countArgs(char const *s, int n = 0);
+constexpr int countArgsAfterField(char const *s, char const *field, int n)
+{
+    return s ? countArgs(s, n)
+             : isDigit(*field) ? invalidFormatString("positional arguments are not supported")
+                               : invalidFormatString("invalid replacement field");
+}
+/// number of replacement fields (compile error if the format string is invalid)
+constexpr int countArgs(char const *s, int n)
+{
+    return *s == 0 ? n : *s == '{' ? (s[1] == '{' ? countArgs(s + 2, n) : countArgsAfterField(fieldEnd(s + 1), s + 1, n + 1))
+                       : *s == '}' ? (s[1] == '}' ? countArgs(s + 2, n) : invalidFormatString("unmatched '}'"))
+                                   : countArgs(s + 1, n);
+}
+}
+
+/// Format string checked at compile time, use AION_FMT("...")
+template <int ArgCount>
+struct FormatString
+{
+    static_assert(ArgCount >= 0, "invalid format string");
+    char const *str;
+    constexpr explicit FormatString(char const *s) : str(s) {}
+};
+
+/// validates a format string literal at compile time
+#define AION_FMT(str) ::aion::FormatString<::aion::detail::countArgs(str)>(str)
+
+/// Writes into a caller-supplied buffer, output that does not fit is dropped
+class FixedFormatBuffer
+{
+private:
+    char *mData;
+    std::size_t mCapacity;
+    std::size_t mSize = 0;
+    bool mTruncated = false;
+
+public:
+    FixedFormatBuffer(char *data, std::size_t capacity) : mData(data), mCapacity(capacity) {}
+
+    FixedFormatBuffer(FixedFormatBuffer const &) = delete;
+    FixedFormatBuffer &operator=(FixedFormatBuffer const &) = delete;
+
+    void append(char const *data, std::size_t size);
+    void append(std::size_t count, char c);
+
+    char const *data() const { return mData; }
+    std::size_t size() const { return mSize; }
+    std::size_t capacity() const { return mCapacity; }
+    /// true if output was dropped
+    bool truncated() const { return mTruncated; }
+
+    void clear()
+    {
+        mSize = 0;
+        mTruncated = false;
+    }
+
+    std::string str() const { return {mData, mSize}; }
+};
+
+/// FixedFormatBuffer with N bytes of storage (e.g. on the stack)
+template <std::size_t N>
+class StackFormatBuffer : public FixedFormatBuffer
+{
+private:
+    char mStorage[N];
+
+public:
+    StackFormatBuffer() : FixedFormatBuffer(mStorage, N) {}
+};
+
+namespace detail
+{
+struct FormatSpec
+{
+    char fill = ' ';
+    char align = 0;
+    char sign = 0;
+    bool alt = false;
+    bool zero = false;
+    int width = 0;
+    int precision = -1;
+    char type = 0;
+};
+
+/// parses a (validated) replacement field, s points behind '{', returns the position behind '}'
+char const *parseField(char const *s, FormatSpec &spec);
+/// writes the digits (and prefix/sign) into [.., end), returns the begin, 'signSize' = size of sign and prefix
+char *formatInteger(char *end, uint64_t value, bool negative, FormatSpec const &spec, int &signSize);
+/// formats into 'buffer' (at least FloatBufferSize bytes) via snprintf, returns the size, 'signSize' = size of the sign
+int formatFloat(char *buffer, double value, FormatSpec const &spec, int &signSize);
+const int FloatBufferSize = 512;
+const int IntegerBufferSize = 80;
+
+/// buffers output for std::ostream
+class StreamSink
+{
+private:
+    std::ostream &mStream;
+    char mBuffer[256];
+    std::size_t mSize = 0;
+
+public:
+    explicit StreamSink(std::ostream &oss) : mStream(oss) {}
+    ~StreamSink() { flush(); }
+
+    void append(char const *data, std::size_t size);
+    void append(std::size_t count, char c);
+    void flush();
+};
+
+template <class Sink>
+void writePadded(Sink &sink, FormatSpec const &spec, char const *data, std::size_t size, char defaultAlign, std::size_t signSize = 0)
+{
+    auto padding = spec.width > (int)size ? spec.width - (int)size : 0;
+    if (padding == 0)
+    {
+        sink.append(data, size);
+        return;
+    }
+
+    // zero padding goes between sign/prefix and digits
+    if (spec.zero && !spec.align)
+    {
+        sink.append(data, signSize);
+        sink.append((std::size_t)padding, '0');
+        sink.append(data + signSize, size - signSize);
+        return;
+    }
+
+    auto align = spec.align ? spec.align : defaultAlign;
+    auto left = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+    if (left > 0)
+        sink.append((std::size_t)left, spec.fill);
+    sink.append(data, size);
+    if (padding - left > 0)
+        sink.append((std::size_t)(padding - left), spec.fill);
+}
+
+template <class Sink>
+void formatArg(Sink &sink, FormatSpec const &spec, char const *str)
+{
+    auto size = std::char_traits<char>::length(str);
+    if (spec.precision >= 0 && (std::size_t)spec.precision < size)
+        size = spec.precision;
+    writePadded(sink, spec, str, size, '<');
+}
+template <class Sink>
+void formatArg(Sink &sink, FormatSpec const &spec, std::string const &str)
+{
+    auto size = str.size();
+    if (spec.precision >= 0 && (std::size_t)spec.precision < size)
+        size = spec.precision;
+    writePadded(sink, spec, str.data(), size, '<');
+}
+
+template <class Sink, class T>
+typename std::enable_if<std::is_integral<T>::value>::type formatArg(Sink &sink, FormatSpec const &spec, T value)
+{
+    // bool and char are printed as such unless an integer type is given
+    if (std::is_same<T, bool>::value && (spec.type == 0 || spec.type == 's'))
+    {
+        formatArg(sink, spec, value ? "true" : "false");
+        return;
+    }
+    if ((std::is_same<T, char>::value && (spec.type == 0 || spec.type == 'c')) || spec.type == 'c')
+    {
+        auto c = (char)value;
+        writePadded(sink, spec, &c, 1, '<');
+        return;
+    }
+
+    char buffer[IntegerBufferSize];
+    auto negative = value < T(0);
+    // (two's complement negation also works for the minimum)
+    auto magnitude = negative ? 0 - (uint64_t)value : (uint64_t)value;
+    auto signSize = 0;
+    auto begin = formatInteger(buffer + sizeof(buffer), magnitude, negative, spec, signSize);
+    writePadded(sink, spec, begin, buffer + sizeof(buffer) - begin, '>', signSize);
+}
+
+template <class Sink, class T>
+typename std::enable_if<std::is_floating_point<T>::value>::type formatArg(Sink &sink, FormatSpec const &spec, T value)
+{
+    char buffer[FloatBufferSize];
+    auto signSize = 0;
+    auto size = formatFloat(buffer, (double)value, spec, signSize);
+    writePadded(sink, spec, buffer, size, '>', signSize);
+}
+
+template <class Sink>
+void formatArg(Sink &sink, FormatSpec const &spec, void const *ptr)
+{
+    auto hex = spec;
+    hex.type = 'x';
+    hex.alt = true;
+    formatArg(sink, hex, (uintptr_t)ptr);
+}
+template <class Sink, class T>
+void formatArg(Sink &sink, FormatSpec const &spec, T *ptr)
+{
+    formatArg(sink, spec, (void const *)ptr);
+}
+template <class Sink>
+void formatArg(Sink &sink, FormatSpec const &spec, char *str)
+{
+    formatArg(sink, spec, (char const *)str);
+}
+
+/// writes literal text up to the next replacement field, returns its position (or the end)
+template <class Sink>
+char const *writeLiteral(Sink &sink, char const *f)
+{
+    auto begin = f;
+    while (*f)
+    {
+        if ((*f == '{' || *f == '}') && f[1] == *f) // escaped
+        {
+            sink.append(begin, f + 1 - begin);
+            f += 2;
+            begin = f;
+        }
+        else if (*f == '{')
+            break;
+        else
+            ++f;
+    }
+    sink.append(begin, f - begin);
+    return f;
+}
+
+template <class Sink>
+void formatImpl(Sink &sink, char const *f)
+{
+    writeLiteral(sink, f);
+}
+template <class Sink, class T, class... Args>
+void formatImpl(Sink &sink, char const *f, T const &value, Args const &... args)
+{
+    f = writeLiteral(sink, f);
+
+    FormatSpec spec;
+    f = parseField(f + 1, spec);
+    formatArg(sink, spec, value);
+
+    formatImpl(sink, f, args...);
+}
+
+/// std::ostreams are written through a StreamSink, other targets need append(data, size) and append(count, char)
+template <class Target, bool isStream = std::is_base_of<std::ostream, Target>::value>
+struct SinkOf
+{
+    using type = Target &;
+};
+template <class Target>
+struct SinkOf<Target, true>
+{
+    using type = StreamSink;
+};
+}
+
+/// Formats into 'target' (FixedFormatBuffer, std::string, std::ostream, ...)
+/// Allocates only if a std::string target has to grow
+template <class Target, int ArgCount, class... Args>
+void formatTo(Target &target, FormatString<ArgCount> format, Args const &... args)
+{
+    static_assert(sizeof...(Args) == ArgCount, "number of arguments does not match the format string");
+    typename detail::SinkOf<Target>::type sink(target);
+    detail::formatImpl(sink, format.str, args...);
+}
+
+/// Formats into a new string
+template <int ArgCount, class... Args>
+std::string formatString(FormatString<ArgCount> format, Args const &... args)
+{
+    std::string s;
+    formatTo(s, format, args...);
+    return s;
+}
+}
@@ -94,9 +94,11 @@ static const int64 kint64max = static_cast<int64>(0x7FFFFFFFFFFFFFFFLL);
 
 // Potentially unaligned loads and stores.
 
-// x86 and PowerPC can simply do these loads and stores native.
+// PowerPC can simply do these loads and stores native.
+// x86 uses the memcpy versions below: the casts violate strict aliasing and
+// newer GCCs miscompile the decompressor with -O2 (memcpy compiles to a single mov).
 
-#if defined(__i386__) || defined(__x86_64__) || defined(__powerpc__)
+#if defined(__powerpc__)
 
 #define UNALIGNED_LOAD16(_p) (*reinterpret_cast<const uint16 *>(_p))
 #define UNALIGNED_LOAD32(_p) (*reinterpret_cast<const uint32 *>(_p))
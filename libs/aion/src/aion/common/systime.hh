@@ -6,7 +6,7 @@
 #include <string>
 #include <vector>
 
-#include "format.hh"
+#include "checked_format.hh"
 
 /// Contains constants for conversion from ns to other times
 /// Examples: 10 * systime::ms are 10ms
@@ -77,13 +77,13 @@ inline std::string formatNs(int64_t ns)
 inline void formatHuman(int64_t ns, std::ostream &oss)
 {
     if (ns < 1 * us)
-        oss << aion_fmt::format("{:6}ns", ns);
+        aion::formatTo(oss, AION_FMT("{:6}ns"), ns);
     else if (ns < 1 * ms)
-        oss << aion_fmt::format("{:6.2f}us", ns / 1000.);
+        aion::formatTo(oss, AION_FMT("{:6.2f}us"), ns / 1000.);
     else if (ns < 1 * sec)
-        oss << aion_fmt::format("{:6.2f}ms", ns / 1000. / 1000.);
+        aion::formatTo(oss, AION_FMT("{:6.2f}ms"), ns / 1000. / 1000.);
     else
-        oss << aion_fmt::format("{:6.2f}s ", ns / 1000. / 1000. / 1000.);
+        aion::formatTo(oss, AION_FMT("{:6.2f}s "), ns / 1000. / 1000. / 1000.);
 }
 inline std::string formatHuman(int64_t ns)
 {
@@ -94,13 +94,13 @@ inline std::string formatHuman(int64_t ns)
 inline void formatHumanHtml(int64_t ns, std::ostream &oss)
 {
     if (ns < 1 * us)
-        oss << aion_fmt::format("<font color=\"#bbb\">{:}ns</font>", ns);
+        aion::formatTo(oss, AION_FMT("<font color=\"#bbb\">{:}ns</font>"), ns);
     else if (ns < 1 * ms)
-        oss << aion_fmt::format("<font color=\"#686\">{:.2f}us</font>", ns / 1000.);
+        aion::formatTo(oss, AION_FMT("<font color=\"#686\">{:.2f}us</font>"), ns / 1000.);
     else if (ns < 1 * sec)
-        oss << aion_fmt::format("{:.2f}ms", ns / 1000. / 1000.);
+        aion::formatTo(oss, AION_FMT("{:.2f}ms"), ns / 1000. / 1000.);
     else
-        oss << aion_fmt::format("<font color=\"#BB4500\">{:.2f}s</font> ", ns / 1000. / 1000. / 1000.);
+        aion::formatTo(oss, AION_FMT("<font color=\"#BB4500\">{:.2f}s</font> "), ns / 1000. / 1000. / 1000.);
 }
 inline std::string formatHumanHtml(int64_t ns)
 {
@@ -6,6 +6,8 @@
 #include <glm/glm.hpp>
 
 #include <cassert>
+#include <cstdlib>
+#include <ctime>
 
 #include <chrono>
 #include <iostream>
@@ -22,10 +24,12 @@
 #include <glow/common/log.hh>
 #include <glow/common/str_utils.hh>
 #include <glow/glow.hh>
+#include <glow/state.hh>
 
 #include <glow/util/DefaultShaderParser.hh>
 
 #include <glow/objects/OcclusionQuery.hh>
+#include <glow/objects/Program.hh>
 #include <glow/objects/PrimitiveQuery.hh>
 #include <glow/objects/TimerQuery.hh>
 
@@ -33,6 +37,9 @@
 #include <glow-extras/debugging/DebugRenderer.hh>
 #include <glow-extras/pipeline/RenderingPipeline.hh>
 
+#include "ProfilerOverlay.hh"
+#include "ReplayLog.hh"
+
 using namespace glow;
 using namespace glow::glfw;
 
@@ -48,6 +55,13 @@ static std::string thousandSep(size_t val)
     return s;
 }
 
+void GlfwApp::setShowProfiler(bool show)
+{
+    mShowProfiler = show;
+    if (mProfiler)
+        mProfiler->setVisible(show);
+}
+
 void GlfwApp::setTitle(const std::string &title)
 {
     mTitle = title;
@@ -68,14 +82,30 @@ std::string GlfwApp::getClipboardString() const
 
 bool GlfwApp::isMouseButtonPressed(int button) const
 {
+    if (isReplaying())
+        return button >= 0 && button < (int)mReplayMouseButtons.size() && mReplayMouseButtons[button];
+
     return glfwGetMouseButton(mWindow, button) == GLFW_PRESS;
 }
 
 bool GlfwApp::isKeyPressed(int key) const
 {
+    if (isReplaying())
+        return key >= 0 && key < (int)mReplayKeys.size() && mReplayKeys[key];
+
     return glfwGetKey(mWindow, key) == GLFW_PRESS;
 }
 
+bool GlfwApp::isRecording() const
+{
+    return mReplayLog && mReplayLog->isWriting();
+}
+
+bool GlfwApp::isReplaying() const
+{
+    return mReplayLog && mReplayLog->isReading();
+}
+
 bool GlfwApp::shouldClose() const
 {
     return glfwWindowShouldClose(mWindow);
@@ -107,16 +137,16 @@ void GlfwApp::update(float elapsedSeconds)
     if (mCamera && mUseDefaultCameraHandling)
     {
         auto speed = mCameraMoveSpeed;
-        if (glfwGetKey(mWindow, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+        if (isKeyPressed(GLFW_KEY_LEFT_SHIFT))
             speed *= mCameraMoveSpeedFactor;
 
-        if (glfwGetKey(mWindow, GLFW_KEY_W) == GLFW_PRESS)
+        if (isKeyPressed(GLFW_KEY_W))
             mCamera->moveForward(elapsedSeconds * speed);
-        if (glfwGetKey(mWindow, GLFW_KEY_S) == GLFW_PRESS)
+        if (isKeyPressed(GLFW_KEY_S))
             mCamera->moveBack(elapsedSeconds * speed);
-        if (glfwGetKey(mWindow, GLFW_KEY_A) == GLFW_PRESS)
+        if (isKeyPressed(GLFW_KEY_A))
             mCamera->moveLeft(elapsedSeconds * speed);
-        if (glfwGetKey(mWindow, GLFW_KEY_D) == GLFW_PRESS)
+        if (isKeyPressed(GLFW_KEY_D))
             mCamera->moveRight(elapsedSeconds * speed);
     }
 }
@@ -151,36 +181,48 @@ void GlfwApp::onClose() {}
 
 bool GlfwApp::onKey(int key, int scancode, int action, int mods)
 {
-    if (TwEventKeyGLFW(mWindow, key, scancode, action, mods))
+    if (!isReplaying() && TwEventKeyGLFW(mWindow, key, scancode, action, mods))
         return true;
 
+    recordEvent({ReplayEventType::Key, key, scancode, action, mods});
+
     if (key == GLFW_KEY_HOME && action == GLFW_PRESS)
     {
         onResetView();
         return true;
     }
 
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS)
+    {
+        setShowProfiler(!mShowProfiler);
+        return true;
+    }
+
     return false;
 }
 
 bool GlfwApp::onChar(unsigned int codepoint, int mods)
 {
-    if (TwEventCharGLFW(mWindow, codepoint))
+    if (!isReplaying() && TwEventCharGLFW(mWindow, codepoint))
         return true;
 
+    recordEvent({ReplayEventType::Char, (int32_t)codepoint, mods});
+
     return false;
 }
 
 bool GlfwApp::onMousePosition(double x, double y)
 {
-    if (TwEventMousePosGLFW(mWindow, x, y))
+    if (!isReplaying() && TwEventMousePosGLFW(mWindow, x, y))
         return true;
 
+    recordEvent({ReplayEventType::MousePosition, 0, 0, 0, 0, x, y});
+
     if (mMouseLastX >= 0.0 && mCamera && mUseDefaultCameraHandling)
     {
-        auto shift = glfwGetKey(mWindow, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
-        auto alt = glfwGetKey(mWindow, GLFW_KEY_LEFT_ALT) == GLFW_PRESS;
-        auto ctrl = glfwGetKey(mWindow, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
+        auto shift = isKeyPressed(GLFW_KEY_LEFT_SHIFT);
+        auto alt = isKeyPressed(GLFW_KEY_LEFT_ALT);
+        auto ctrl = isKeyPressed(GLFW_KEY_LEFT_CONTROL);
 
         auto dx = x - mMouseLastX;
         auto dy = y - mMouseLastY;
@@ -230,9 +272,11 @@ bool GlfwApp::onMouseButton(double x, double y, int button, int action, int mods
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_RELEASE)
         mMouseRight = false;
 
-    if (TwEventMouseButtonGLFW(mWindow, button, action, mods))
+    if (!isReplaying() && TwEventMouseButtonGLFW(mWindow, button, action, mods))
         return true;
 
+    recordEvent({ReplayEventType::MouseButton, button, action, mods, clickCount, x, y});
+
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
         mMouseLeft = true;
     if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
@@ -259,9 +303,11 @@ bool GlfwApp::onMouseButton(double x, double y, int button, int action, int mods
 
 bool GlfwApp::onMouseScroll(double sx, double sy)
 {
-    if (TwEventMouseWheelGLFW(mWindow, sx, sy))
+    if (!isReplaying() && TwEventMouseWheelGLFW(mWindow, sx, sy))
         return true;
 
+    recordEvent({ReplayEventType::MouseScroll, 0, 0, 0, 0, sx, sy});
+
     // camera handling
     if (mCamera && mUseDefaultCameraHandling && sy != 0)
     {
@@ -308,6 +354,28 @@ void GlfwApp::onResetView()
     mCamera->setTarget({0, 0, 0}, {0, 1, 0});
 }
 
+void GlfwApp::onRecordParameters(std::vector<char> &data) {}
+
+void GlfwApp::onReplayParameters(const std::vector<char> &data) {}
+
+void GlfwApp::recordEvent(const ReplayEvent &e)
+{
+    if (isRecording())
+        mReplayLog->addEvent(e);
+}
+
+void GlfwApp::performUpdate(float elapsedSeconds)
+{
+    if (isRecording())
+    {
+        std::vector<char> params;
+        onRecordParameters(params);
+        mReplayLog->writeTick(params);
+    }
+
+    update(elapsedSeconds);
+}
+
 void GlfwApp::mainLoop()
 {
     // Loop until the user closes the window
@@ -338,12 +406,15 @@ void GlfwApp::mainLoop()
 
             auto dt = 1.0 / mUpdateRate;
             auto cpuStart = glfwGetTime();
-            update(dt);
+            performUpdate(dt);
             cpuTime += glfwGetTime() - cpuStart;
             timeAccum -= dt;
             mCurrentTime += dt;
         }
 
+        // the simulation is up to one timestep ahead of the real time (timeAccum <= 0)
+        mInterpolationAlpha = glm::clamp(1.0 + timeAccum * mUpdateRate, 0.0, 1.0);
+
         beginRender();
 
         // Render here
@@ -375,6 +446,9 @@ void GlfwApp::mainLoop()
         lastTime = now;
         ++frames;
 
+        if (mProfiler)
+            mProfiler->onFrame(renderTimestep);
+
         if (mQueryStats && mPrimitiveQuery)
         {
             primitives += mPrimitiveQuery->getResult64();
@@ -391,6 +465,15 @@ void GlfwApp::mainLoop()
                                             thousandSep(primitives / frames), thousandSep(fragments / frames));
             else
                 glow::info() << fmt::format("FPS: {:.1f}, CPU: {:.1f} ms", fps, cpuTime / frames * 1000.);
+
+            // redundant state changes skipped by glow (per frame)
+            auto uniforms = Program::getUniformStatistics();
+            auto binds = glow::state::getStatistics();
+            glow::info() << fmt::format("Uniforms: {} sent, {} skipped, Binds: {} sent, {} skipped", //
+                                        thousandSep(uniforms.issued / frames), thousandSep(uniforms.skipped / frames),
+                                        thousandSep(binds.issued / frames), thousandSep(binds.skipped / frames));
+            Program::resetUniformStatistics();
+            glow::state::resetStatistics();
             lastStatsTime = lastTime;
             frames = 0;
             primitives = 0;
@@ -401,6 +484,59 @@ void GlfwApp::mainLoop()
     }
 }
 
+void GlfwApp::replayLoop()
+{
+    mReplayKeys.assign(GLFW_KEY_LAST + 1, false);
+    mReplayMouseButtons.assign(GLFW_MOUSE_BUTTON_LAST + 1, false);
+
+    auto dt = 1.0 / mUpdateRate;
+    mCurrentTime = 0.0;
+    mInterpolationAlpha = 1.0f;
+
+    ReplayLog::Tick tick;
+    size_t ticks = 0;
+    auto startTime = glfwGetTime();
+    while (mReplayLog->readTick(tick))
+    {
+        // input of this tick
+        for (auto const &e : tick.events)
+            switch (e.type)
+            {
+            case ReplayEventType::Key:
+                if (e.i0 >= 0 && e.i0 < (int)mReplayKeys.size())
+                    mReplayKeys[e.i0] = e.i2 != GLFW_RELEASE;
+                onKey(e.i0, e.i1, e.i2, e.i3);
+                break;
+            case ReplayEventType::Char:
+                onChar((unsigned int)e.i0, e.i1);
+                break;
+            case ReplayEventType::MousePosition:
+                mMouseX = e.x;
+                mMouseY = e.y;
+                onMousePosition(e.x, e.y);
+                break;
+            case ReplayEventType::MouseButton:
+                if (e.i0 >= 0 && e.i0 < (int)mReplayMouseButtons.size())
+                    mReplayMouseButtons[e.i0] = e.i1 != GLFW_RELEASE;
+                onMouseButton(e.x, e.y, e.i0, e.i1, e.i2, e.i3);
+                break;
+            case ReplayEventType::MouseScroll:
+                onMouseScroll(e.x, e.y);
+                break;
+            }
+
+        onReplayParameters(tick.parameters);
+
+        update(dt);
+        mCurrentTime += dt;
+        ++ticks;
+    }
+    auto duration = glfwGetTime() - startTime;
+
+    glow::info() << fmt::format("Replayed {} ticks ({:.1f} s simulated) in {:.3f} s ({:.0f} ticks/s)", ticks,
+                                mCurrentTime, duration, ticks / glm::max(duration, 1e-9));
+}
+
 void GlfwApp::internalOnMouseButton(double x, double y, int button, int action, int mods)
 {
     // check double click
@@ -452,7 +588,10 @@ void GlfwApp::endRender()
 {
     // draw the tweak bar(s)
     if (mDrawTweakbars)
+    {
         TwDraw();
+        glow::state::invalidate(); // AntTweakBar binds its own objects
+    }
 
     // Swap front and back buffers
     glfwSwapBuffers(mWindow);
@@ -543,6 +682,11 @@ int GlfwApp::run(int argc, char *argv[])
     TwWindowSize(mWindowWidth, mWindowHeight);
     mTweakbar = TwNewBar("Tweakbar");
 
+    // live profiler
+    mProfiler = std::make_shared<ProfilerOverlay>();
+    if (mShowProfiler)
+        mProfiler->setVisible(true);
+
     // input callbacks
     {
         glfwSetKeyCallback(mWindow, [](GLFWwindow *win, int key, int scancode, int action, int mods) {
@@ -587,6 +731,35 @@ int GlfwApp::run(int argc, char *argv[])
         });
     }
 
+    // recording and replay (BEFORE init so that rand() is seeded for it)
+    for (auto i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--record")
+            mRecordFile = argv[i + 1];
+        if (std::string(argv[i]) == "--replay")
+            mReplayFile = argv[i + 1];
+    }
+    if (!mReplayFile.empty())
+    {
+        mReplayLog = std::make_shared<ReplayLog>();
+        if (!mReplayLog->openRead(mReplayFile))
+            return -1;
+
+        mUpdateRate = mReplayLog->getUpdateRate();
+        srand(mReplayLog->getSeed());
+        glow::info() << "Replaying " << mReplayFile;
+    }
+    else if (!mRecordFile.empty())
+    {
+        auto seed = (uint32_t)time(nullptr);
+        mReplayLog = std::make_shared<ReplayLog>();
+        if (!mReplayLog->openWrite(mRecordFile, mUpdateRate, seed))
+            return -1;
+
+        srand(seed);
+        glow::info() << "Recording into " << mRecordFile;
+    }
+
     // init app
     init();
 
@@ -594,12 +767,19 @@ int GlfwApp::run(int argc, char *argv[])
     onResize(mWindowWidth, mWindowHeight);
 
     // Execute main loop
-    mainLoop();
+    if (isReplaying())
+        replayLoop();
+    else
+        mainLoop();
 
     // cleanup
     {
+        if (mReplayLog)
+            mReplayLog->close();
+
         onClose();
 
+        mProfiler = nullptr;
         TwTerminate();
         glfwTerminate();
 
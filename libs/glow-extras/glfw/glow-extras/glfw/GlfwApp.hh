@@ -32,6 +32,10 @@ GLOW_SHARED(class, DebugRenderer);
 
 namespace glfw
 {
+GLOW_SHARED(class, ReplayLog);
+GLOW_SHARED(class, ProfilerOverlay);
+struct ReplayEvent;
+
 enum class CursorMode
 {
     /// normal behavior
@@ -49,6 +53,8 @@ enum class CursorMode
  *   - init(...): initialize and allocate all your resources and objects
  *   - update(...): called with a constant rate (default 60 Hz, configurable) before rendering
  *   - render(...): called as fast as possible (affected by vsync)
+ *        NOTE: the simulation is usually a bit ahead of the rendered time,
+ *              use getInterpolationAlpha() to interpolate between the last two update states
  *   - renderPass(...): if rendering pipeline enabled (default), default render(...) will call this (RECOMMENDED)
  *        NOTE: if you use debug()->renderXYZ, do so BEFORE call to base
  *   - onResize(...): called when window is resized
@@ -61,8 +67,16 @@ enum class CursorMode
  *   - setUpdateRate(...): set the update rate
  *   - window(): get the GLFW window
  *   - tweakbar(): get the AntTweakBar instance
+ *   - setShowProfiler(...): live AION statistics per label and frame time histogram (F3)
  *   - setWindowWidth/Height(...): set initial window size before run(...)
  *
+ * Recording and replay:
+ *   - "--record <file>" records all input events and app parameters per update step
+ *   - "--replay <file>" replays such a log as fast as possible (update(...) only, no rendering)
+ *     and prints the achieved update rate (useful for profiling and regression tests)
+ *   - override onRecordParameters/onReplayParameters for state that changes outside of update(...) (e.g. tweakbar)
+ *   - update(...) must only depend on input events, parameters and rand() (seeded from the log)
+ *
  * Notes:
  *   - if you use primitive/occlusion queries, use setQueryStats(false);
  *   - overwrite onResetView if you want a different default view
@@ -89,6 +103,8 @@ private:
     int mWindowHeight = 720; ///< window height, only set before run!
 
     bool mDumpTimingsOnShutdown = true; ///< if true, dumps AION timings on shutdown
+    bool mShowProfiler = false;         ///< if true, shows live AION statistics (toggle with F3)
+    SharedProfilerOverlay mProfiler;    ///< live AION statistics
 
     double mMouseX = -1.0; ///< cursor X in pixels
     double mMouseY = -1.0; ///< cursor Y in pixels
@@ -107,6 +123,14 @@ private:
 
     double mCurrentTime = 0.0; ///< current frame time (starts with 0)
 
+    float mInterpolationAlpha = 1.0f; ///< rendered time between last (0) and current (1) update state
+
+    std::string mRecordFile;               ///< if non-empty, input and parameters are recorded into this file
+    std::string mReplayFile;               ///< if non-empty, this file is replayed instead of the normal main loop
+    SharedReplayLog mReplayLog;            ///< current replay log (recording or replaying)
+    std::vector<bool> mReplayKeys;         ///< key state during replay
+    std::vector<bool> mReplayMouseButtons; ///< mouse button state during replay
+
     double mDoubleClickTime = 0.35f; ///< max number of seconds for multi clicks
     int mClickCount = 0;             ///< current click count
     int mClickButton = -1;           ///< last clicked button
@@ -145,6 +169,9 @@ public:
     GLOW_PROPERTY(WindowWidth);
     GLOW_PROPERTY(WindowHeight);
     GLOW_PROPERTY(DumpTimingsOnShutdown);
+    GLOW_GETTER(ShowProfiler);
+    void setShowProfiler(bool show);
+    GLOW_GETTER(Profiler);
     GLOW_PROPERTY(CursorMode);
     GLOW_PROPERTY(DrawTweakbars);
     GLOW_PROPERTY(VSync);
@@ -154,6 +181,11 @@ public:
     GLOW_PROPERTY(DoubleClickTime);
     float getCurrentTime() const { return mCurrentTime; }
     double getCurrentTimeD() const { return mCurrentTime; }
+    GLOW_GETTER(InterpolationAlpha);
+    GLOW_PROPERTY(RecordFile);
+    GLOW_PROPERTY(ReplayFile);
+    bool isRecording() const;
+    bool isReplaying() const;
     GLOW_GETTER(Camera);
     GLOW_GETTER(Pipeline);
 
@@ -190,6 +222,7 @@ protected:
     /// Called with at 1 / getUpdateRate() Hz (timestep)
     virtual void update(float elapsedSeconds);
     /// Called as fast as possible for rendering (elapsedSeconds is not fixed here)
+    /// The rendered time is getInterpolationAlpha() between the previous and the current update state
     virtual void render(float elapsedSeconds);
     /// When using the builtin rendering pipeline, this is called for every pass in every render step
     virtual void renderPass(pipeline::RenderPass const& pass, float elapsedSeconds);
@@ -222,12 +255,27 @@ protected:
     /// Called when view should be reset
     virtual void onResetView();
 
+    /// Called before every update step while recording
+    /// Serialize all state that is changed outside of update(...) (e.g. via tweakbar)
+    virtual void onRecordParameters(std::vector<char>& data);
+    /// Called before every update step while replaying (with the data from onRecordParameters)
+    virtual void onReplayParameters(std::vector<char> const& data);
+
     /// Blocking call that executes the complete main loop
     virtual void mainLoop();
 
+    /// Blocking call that replays the log given by setReplayFile(...) as fast as possible
+    virtual void replayLoop();
+
 private:
     void internalOnMouseButton(double x, double y, int button, int action, int mods);
 
+    /// adds an input event to the current recording (no-op if not recording)
+    void recordEvent(ReplayEvent const& e);
+
+    /// performs one update step (incl. recording)
+    void performUpdate(float elapsedSeconds);
+
 protected:
     /// performs glfw polling
     void updateInput();
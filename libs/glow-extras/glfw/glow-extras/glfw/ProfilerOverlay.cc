@@ -0,0 +1,268 @@
+#include "ProfilerOverlay.hh"
+
+#include <AntTweakBar.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include <aion/ActionLabel.hh>
+
+#include <glow/common/profiling.hh>
+
+using namespace glow;
+using namespace glow::glfw;
+
+namespace
+{
+/// upper bounds of the frame time histogram bins (in ms, last bin is open)
+const double sHistogramEdges[ProfilerOverlay::HistogramBins - 1] = {4, 8, 12, 16.7, 20, 25, 33.3, 50, 100};
+
+// row layout
+const int sRowFrame = 0;
+const int sRowCost = 1;
+const int sRowHistogram = 2;
+const int sRowTop = sRowHistogram + ProfilerOverlay::HistogramBins;
+
+double toMS(int64_t ns)
+{
+    return ns / 1000000.0;
+}
+}
+
+void ProfilerOverlay::LabelWindow::push(Sample s, size_t capacity)
+{
+    if (samples.size() != capacity)
+    {
+        samples.assign(std::max(capacity, size_t(1)), Sample{0, 0});
+        first = 0;
+        count = 0;
+        sumNs = 0;
+    }
+
+    if (count == samples.size())
+        popFront();
+
+    auto idx = first + count; // (no modulo, this is called per action)
+    if (idx >= samples.size())
+        idx -= samples.size();
+    samples[idx] = s;
+    ++count;
+    sumNs += s.ns;
+}
+
+ProfilerOverlay::ProfilerOverlay()
+{
+    // only the windows are used, per-label sketches would be wasted work
+    mStats.setCollectStatistics(false);
+    mStats.setActionCallback([this](int32_t label, int32_t, int64_t ns) {
+        if (label >= (int)mLabels.size())
+            mLabels.resize(label + 1);
+
+        mLabels[label].push({mFrame, ns}, mMaxSamplesPerLabel);
+    });
+}
+
+ProfilerOverlay::~ProfilerOverlay()
+{
+    // bars are deleted by TwTerminate
+}
+
+void ProfilerOverlay::setVisible(bool visible)
+{
+    if (visible == mVisible)
+        return;
+
+    mVisible = visible;
+
+    if (visible)
+    {
+        if (!mBar)
+            createBar();
+
+        // start fresh
+        mStats.seekToEnd();
+        mLabels.clear();
+        mFrameTimes.clear();
+        mTimeSinceRefresh = mRefreshInterval;
+    }
+
+    TwSetParam(mBar, nullptr, "visible", TW_PARAM_CSTRING, 1, visible ? "true" : "false");
+}
+
+void ProfilerOverlay::onFrame(double frameSeconds)
+{
+    if (!mVisible)
+        return;
+
+    GLOW_ACTION("ProfilerOverlay::onFrame");
+    auto start = std::chrono::steady_clock::now();
+
+    ++mFrame;
+
+    // consume new entries (callback fills the windows)
+    mStats.update();
+
+    // frame times
+    mFrameTimes.push_back((int64_t)(frameSeconds * 1e9));
+    while ((int)mFrameTimes.size() > mWindowFrames)
+        mFrameTimes.pop_front();
+
+    // evict old samples
+    auto minFrame = mFrame >= (uint32_t)mWindowFrames ? mFrame - mWindowFrames + 1 : 0;
+    for (auto& w : mLabels)
+        while (!w.empty() && w.front().frame < minFrame)
+            w.popFront();
+
+    // text
+    mTimeSinceRefresh += frameSeconds;
+    if (mTimeSinceRefresh >= mRefreshInterval)
+    {
+        mTimeSinceRefresh = 0.0;
+        refreshText();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    mUpdateNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    mAvgUpdateNs = mAvgUpdateNs * 0.95 + mUpdateNs * 0.05;
+}
+
+std::vector<ProfilerOverlay::LabelSummary> ProfilerOverlay::topLabels(int n)
+{
+    std::vector<int> indices;
+    for (auto i = 0u; i < mLabels.size(); ++i)
+        if (!mLabels[i].empty())
+            indices.push_back(i);
+
+    n = std::min(n, (int)indices.size());
+    std::partial_sort(begin(indices), begin(indices) + n, end(indices),
+                      [this](int l, int r) { return mLabels[l].sumNs > mLabels[r].sumNs; });
+
+    auto labels = aion::ActionLabel::getAllLabels();
+    std::vector<LabelSummary> result(n);
+    for (auto i = 0; i < n; ++i)
+    {
+        auto const& w = mLabels[indices[i]];
+        result[i].label = labels[indices[i]];
+
+        mScratch.clear();
+        for (auto j = 0u; j < w.count; ++j)
+            mScratch.push_back(w.at(j).ns);
+        summarize(w.sumNs, result[i]);
+    }
+    return result;
+}
+
+ProfilerOverlay::LabelSummary ProfilerOverlay::frameSummary()
+{
+    int64_t sum = 0;
+    mScratch.clear();
+    for (auto t : mFrameTimes)
+    {
+        mScratch.push_back(t);
+        sum += t;
+    }
+
+    LabelSummary s;
+    summarize(sum, s);
+    return s;
+}
+
+void ProfilerOverlay::summarize(int64_t sumNs, LabelSummary& s)
+{
+    s.count = mScratch.size();
+    s.totalNs = sumNs;
+    if (mScratch.empty())
+        return;
+
+    s.avgNs = sumNs / s.count;
+    s.minNs = *std::min_element(begin(mScratch), end(mScratch));
+
+    auto p99 = begin(mScratch) + (mScratch.size() - 1) * 99 / 100;
+    std::nth_element(begin(mScratch), p99, end(mScratch));
+    s.p99Ns = *p99;
+}
+
+void ProfilerOverlay::createBar()
+{
+    mBar = TwNewBar("Profiler");
+    TwDefine(" Profiler size='560 400' color='40 40 40' alpha=200 refresh=0.25 ");
+
+    mRows.resize(sRowTop + mTopCount);
+    for (auto& r : mRows)
+        r[0] = '\0';
+
+    auto addRow = [this](int idx, std::string const& name, std::string const& def) {
+        TwAddVarRO(mBar, name.c_str(), TW_TYPE_CSSTRING(RowLength), mRows[idx].data(), def.c_str());
+    };
+
+    addRow(sRowFrame, "frame", " label='Frame' help='min / avg / p99 of the frame time' ");
+    addRow(sRowCost, "cost", " label='Overhead' help='cost of the profiler update' ");
+
+    for (auto i = 0; i < HistogramBins; ++i)
+    {
+        auto lo = i == 0 ? 0.0 : sHistogramEdges[i - 1];
+        char label[64];
+        if (i + 1 < HistogramBins)
+            snprintf(label, sizeof(label), "%5.1f - %5.1f ms", lo, sHistogramEdges[i]);
+        else
+            snprintf(label, sizeof(label), "> %5.1f ms", lo);
+        addRow(sRowHistogram + i, "hist" + std::to_string(i), " group='Frame times' label='" + std::string(label) + "' ");
+    }
+
+    for (auto i = 0; i < mTopCount; ++i)
+        addRow(sRowTop + i, "top" + std::to_string(i), " group='Hot labels' label='#" + std::to_string(i + 1) + "' ");
+}
+
+void ProfilerOverlay::refreshText()
+{
+    // frame
+    {
+        auto f = frameSummary();
+        snprintf(mRows[sRowFrame].data(), RowLength, "%.2f / %.2f / %.2f ms (%d frames)", toMS(f.minNs),
+                 toMS(f.avgNs), toMS(f.p99Ns), (int)f.count);
+    }
+
+    // cost
+    snprintf(mRows[sRowCost].data(), RowLength, "%.3f ms (avg %.3f ms)", toMS(mUpdateNs), toMS((int64_t)mAvgUpdateNs));
+
+    // histogram
+    {
+        int bins[HistogramBins] = {};
+        for (auto t : mFrameTimes)
+        {
+            auto ms = toMS(t);
+            auto b = 0;
+            while (b < HistogramBins - 1 && ms >= sHistogramEdges[b])
+                ++b;
+            ++bins[b];
+        }
+
+        auto maxBin = std::max(1, *std::max_element(bins, bins + HistogramBins));
+        for (auto i = 0; i < HistogramBins; ++i)
+        {
+            auto bar = std::string(bins[i] * 40 / maxBin, '|');
+            snprintf(mRows[sRowHistogram + i].data(), RowLength, "%4d %s", bins[i], bar.c_str());
+        }
+    }
+
+    // top labels
+    {
+        auto top = topLabels((int)mRows.size() - sRowTop);
+        auto frames = std::max(1, (int)mFrameTimes.size());
+        for (auto i = 0u; i + sRowTop < mRows.size(); ++i)
+        {
+            auto row = mRows[sRowTop + i].data();
+            if (i >= top.size())
+            {
+                row[0] = '\0';
+                continue;
+            }
+
+            auto const& s = top[i];
+            snprintf(row, RowLength, "%.2f ms/frame, %.3f / %.3f / %.3f ms (%dx) %s", toMS(s.totalNs) / frames,
+                     toMS(s.minNs), toMS(s.avgNs), toMS(s.p99Ns), (int)s.count, s.label->nameOrFunc().c_str());
+        }
+    }
+}
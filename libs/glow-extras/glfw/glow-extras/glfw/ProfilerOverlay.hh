@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <glow/common/property.hh>
+#include <glow/common/shared.hh>
+
+#include <aion/ActionLabelStatistics.hh>
+
+struct CTwBar;
+typedef struct CTwBar TwBar; // structure CTwBar is not exposed.
+
+namespace aion
+{
+class ActionLabel;
+}
+
+namespace glow
+{
+namespace glfw
+{
+GLOW_SHARED(class, ProfilerOverlay);
+
+/**
+ * @brief Live view of the aion recording inside an AntTweakBar
+ *
+ * Every frame, all new entries (of all threads) are consumed incrementally and added to
+ * rolling windows over the last getWindowFrames() frames:
+ *   - min/avg/p99 per label, top-N labels by total time
+ *   - frame time min/avg/p99 and a frame time histogram
+ *
+ * The text is only rebuilt every getRefreshInterval() seconds.
+ * The cost of the last update is shown in the bar as well (and recorded as ACTION "ProfilerOverlay::onFrame").
+ * Only the windows are updated per action (no quantile sketches, no allocations after warm-up).
+ *
+ * Usage (done by GlfwApp, toggle with F3):
+ *   overlay.setVisible(true);
+ *   overlay.onFrame(frameSeconds); // once per frame
+ */
+class ProfilerOverlay
+{
+public:
+    /// characters per text row
+    static const int RowLength = 100;
+    static const int HistogramBins = 10;
+
+    /// rolling statistics of a label
+    struct LabelSummary
+    {
+        aion::ActionLabel* label = nullptr;
+        int64_t count = 0;
+        int64_t totalNs = 0;
+        int64_t minNs = 0;
+        int64_t avgNs = 0;
+        int64_t p99Ns = 0;
+    };
+
+private:
+    struct Sample
+    {
+        uint32_t frame;
+        int64_t ns;
+    };
+    /// ring buffer of the last samples of a label (allocated once)
+    struct LabelWindow
+    {
+        std::vector<Sample> samples;
+        size_t first = 0;
+        size_t count = 0;
+        int64_t sumNs = 0;
+
+        bool empty() const { return count == 0; }
+        Sample const& front() const { return samples[first]; }
+        Sample const& at(size_t i) const { return samples[(first + i) % samples.size()]; }
+        void popFront()
+        {
+            sumNs -= front().ns;
+            if (++first == samples.size())
+                first = 0;
+            --count;
+        }
+        void push(Sample s, size_t capacity);
+    };
+
+    TwBar* mBar = nullptr;
+    bool mVisible = false;
+
+    aion::ActionLabelStatistics mStats;
+    /// indexed by label index
+    std::vector<LabelWindow> mLabels;
+    /// frame times in ns of the last mWindowFrames frames
+    std::deque<int64_t> mFrameTimes;
+    uint32_t mFrame = 0;
+
+    int mWindowFrames = 120;          ///< size of the rolling windows (in frames)
+    int mTopCount = 10;               ///< number of shown labels (only set before first show)
+    size_t mMaxSamplesPerLabel = 4096; ///< bounds memory and p99 cost of very frequent labels
+    double mRefreshInterval = 0.25;   ///< seconds between text updates
+
+    double mTimeSinceRefresh = 0.0;
+    int64_t mUpdateNs = 0;    ///< cost of the last onFrame
+    double mAvgUpdateNs = 0.0; ///< smoothed cost
+
+    /// text rows (addresses are registered in the tweakbar)
+    std::vector<std::array<char, RowLength>> mRows;
+
+    /// scratch for percentiles
+    std::vector<int64_t> mScratch;
+
+public:
+    GLOW_PROPERTY(WindowFrames);
+    GLOW_PROPERTY(TopCount);
+    GLOW_PROPERTY(MaxSamplesPerLabel);
+    GLOW_PROPERTY(RefreshInterval);
+    GLOW_GETTER(UpdateNs);
+
+    ProfilerOverlay();
+    ~ProfilerOverlay();
+
+    ProfilerOverlay(ProfilerOverlay const&) = delete;
+    ProfilerOverlay& operator=(ProfilerOverlay const&) = delete;
+
+    bool isVisible() const { return mVisible; }
+    /// shows or hides the bar (entries recorded while hidden are skipped)
+    /// CAUTION: requires an initialized AntTweakBar
+    void setVisible(bool visible);
+
+    /// consumes new entries and updates all windows, refreshes the bar text if due
+    void onFrame(double frameSeconds);
+
+    /// rolling statistics of the n labels with highest total time in the window
+    std::vector<LabelSummary> topLabels(int n);
+    /// rolling frame time statistics (label is nullptr)
+    LabelSummary frameSummary();
+
+private:
+    void createBar();
+    void refreshText();
+    /// min/avg/p99 of mScratch
+    void summarize(int64_t sumNs, LabelSummary& s);
+};
+}
+}
@@ -0,0 +1,257 @@
+#include "ReplayLog.hh"
+
+#include <cstring>
+
+#include <glow/common/log.hh>
+
+using namespace glow;
+using namespace glow::glfw;
+
+static const char sReplayMagic[4] = {'G', 'L', 'R', 'P'};
+static const uint32_t sReplayVersion = 1;
+
+bool ReplayLog::openWrite(const std::string &filename, uint32_t updateRate, uint32_t seed)
+{
+    close();
+
+    mOut.open(filename, std::ios::binary | std::ios::trunc);
+    if (!mOut.is_open())
+    {
+        error() << "Unable to open replay log " << filename << " for writing";
+        return false;
+    }
+
+    mUpdateRate = updateRate;
+    mSeed = seed;
+    mTickCount = 0;
+    mPendingEvents.clear();
+    mLastParameters.clear();
+    mHasParameters = false;
+
+    mOut.write(sReplayMagic, sizeof(sReplayMagic));
+    writeRaw(sReplayVersion);
+    writeRaw(mUpdateRate);
+    writeRaw(mSeed);
+    return true;
+}
+
+void ReplayLog::addEvent(const ReplayEvent &e)
+{
+    mPendingEvents.push_back(e);
+}
+
+void ReplayLog::writeTick(const std::vector<char> &parameters)
+{
+    if (!mOut.is_open())
+        return;
+
+    writeVarint(mPendingEvents.size());
+    for (auto const &e : mPendingEvents)
+    {
+        writeRaw(e.type);
+        switch (e.type)
+        {
+        case ReplayEventType::Key:
+            writeRaw(e.i0);
+            writeRaw(e.i1);
+            writeRaw((int8_t)e.i2);
+            writeRaw((int8_t)e.i3);
+            break;
+        case ReplayEventType::Char:
+            writeRaw(e.i0);
+            writeRaw((int8_t)e.i1);
+            break;
+        case ReplayEventType::MousePosition:
+        case ReplayEventType::MouseScroll:
+            writeRaw(e.x);
+            writeRaw(e.y);
+            break;
+        case ReplayEventType::MouseButton:
+            writeRaw(e.x);
+            writeRaw(e.y);
+            writeRaw((int8_t)e.i0);
+            writeRaw((int8_t)e.i1);
+            writeRaw((int8_t)e.i2);
+            writeRaw((int8_t)e.i3);
+            break;
+        }
+    }
+    mPendingEvents.clear();
+
+    // parameters (only if changed)
+    auto changed = !mHasParameters || parameters != mLastParameters;
+    writeRaw((uint8_t)changed);
+    if (changed)
+    {
+        writeVarint(parameters.size());
+        mOut.write(parameters.data(), parameters.size());
+        mLastParameters = parameters;
+        mHasParameters = true;
+    }
+
+    ++mTickCount;
+}
+
+bool ReplayLog::openRead(const std::string &filename)
+{
+    close();
+
+    mIn.open(filename, std::ios::binary | std::ios::ate);
+    if (!mIn.is_open())
+    {
+        error() << "Unable to open replay log " << filename;
+        return false;
+    }
+    mFileSize = (uint64_t)mIn.tellg();
+    mIn.seekg(0);
+
+    char magic[4];
+    uint32_t version = 0;
+    if (!mIn.read(magic, sizeof(magic)) || memcmp(magic, sReplayMagic, sizeof(magic)) != 0 || !readRaw(version))
+    {
+        error() << filename << " is not a replay log";
+        close();
+        return false;
+    }
+    if (version != sReplayVersion)
+    {
+        error() << "Unsupported replay log version " << version << " in " << filename;
+        close();
+        return false;
+    }
+    if (!readRaw(mUpdateRate) || !readRaw(mSeed))
+    {
+        error() << "Truncated replay log header in " << filename;
+        close();
+        return false;
+    }
+
+    mTickCount = 0;
+    mLastParameters.clear();
+    mHasParameters = false;
+    return true;
+}
+
+bool ReplayLog::readTick(ReplayLog::Tick &tick)
+{
+    if (!mIn.is_open())
+        return false;
+
+    uint64_t eventCount;
+    if (!readVarint(eventCount))
+        return false; // regular end of log
+
+    // every event occupies at least one byte
+    if (eventCount > remainingBytes())
+    {
+        error() << "Corrupt replay log at tick " << mTickCount;
+        return false;
+    }
+    tick.events.resize(eventCount);
+    for (auto &e : tick.events)
+    {
+        e = ReplayEvent();
+        auto ok = readRaw(e.type);
+        int8_t b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+        switch (e.type)
+        {
+        case ReplayEventType::Key:
+            ok = ok && readRaw(e.i0) && readRaw(e.i1) && readRaw(b2) && readRaw(b3);
+            e.i2 = b2;
+            e.i3 = b3;
+            break;
+        case ReplayEventType::Char:
+            ok = ok && readRaw(e.i0) && readRaw(b1);
+            e.i1 = b1;
+            break;
+        case ReplayEventType::MousePosition:
+        case ReplayEventType::MouseScroll:
+            ok = ok && readRaw(e.x) && readRaw(e.y);
+            break;
+        case ReplayEventType::MouseButton:
+            ok = ok && readRaw(e.x) && readRaw(e.y) && readRaw(b0) && readRaw(b1) && readRaw(b2) && readRaw(b3);
+            e.i0 = b0;
+            e.i1 = b1;
+            e.i2 = b2;
+            e.i3 = b3;
+            break;
+        default:
+            ok = false;
+            break;
+        }
+
+        if (!ok)
+        {
+            error() << "Corrupt replay log at tick " << mTickCount;
+            return false;
+        }
+    }
+
+    uint8_t changed;
+    if (!readRaw(changed))
+    {
+        error() << "Corrupt replay log at tick " << mTickCount;
+        return false;
+    }
+    if (changed)
+    {
+        uint64_t size;
+        if (!readVarint(size) || size > remainingBytes())
+        {
+            error() << "Corrupt replay log at tick " << mTickCount;
+            return false;
+        }
+        mLastParameters.resize(size);
+        if (size > 0 && !mIn.read(mLastParameters.data(), size))
+        {
+            error() << "Corrupt replay log at tick " << mTickCount;
+            return false;
+        }
+        mHasParameters = true;
+    }
+    tick.parameters = mLastParameters;
+
+    ++mTickCount;
+    return true;
+}
+
+void ReplayLog::close()
+{
+    if (mOut.is_open())
+        mOut.close();
+    if (mIn.is_open())
+        mIn.close();
+}
+
+void ReplayLog::writeVarint(uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        mOut.put((char)(v | 0x80));
+        v >>= 7;
+    }
+    mOut.put((char)v);
+}
+
+uint64_t ReplayLog::remainingBytes()
+{
+    auto pos = mIn.tellg();
+    if (pos < 0 || (uint64_t)pos > mFileSize)
+        return 0;
+    return mFileSize - (uint64_t)pos;
+}
+
+bool ReplayLog::readVarint(uint64_t &v)
+{
+    v = 0;
+    for (auto shift = 0; shift < 64; shift += 7)
+    {
+        auto c = mIn.get();
+        if (c == std::char_traits<char>::eof())
+            return false;
+        v |= uint64_t(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
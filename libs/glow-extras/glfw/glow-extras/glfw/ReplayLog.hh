@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace glow
+{
+namespace glfw
+{
+enum class ReplayEventType : uint8_t
+{
+    Key,
+    Char,
+    MousePosition,
+    MouseButton,
+    MouseScroll,
+};
+
+/// A single recorded input event
+/// Only the fields relevant for the event type are stored on disk
+struct ReplayEvent
+{
+    ReplayEventType type;
+
+    // Key: key, scancode, action, mods
+    // Char: codepoint, mods
+    // MouseButton: button, action, mods, clickCount
+    int32_t i0;
+    int32_t i1;
+    int32_t i2;
+    int32_t i3;
+
+    // MousePosition, MouseButton: x, y
+    // MouseScroll: sx, sy
+    double x;
+    double y;
+
+    ReplayEvent(ReplayEventType type = ReplayEventType::Key, //
+                int32_t i0 = 0,
+                int32_t i1 = 0,
+                int32_t i2 = 0,
+                int32_t i3 = 0,
+                double x = 0.0,
+                double y = 0.0)
+      : type(type), i0(i0), i1(i1), i2(i2), i3(i3), x(x), y(y)
+    {
+    }
+};
+
+/**
+ * @brief Compact binary log of the per-tick input and parameter stream of a GlfwApp
+ *
+ * Layout:
+ *   header: "GLRP" | u32 version | u32 update rate | u32 random seed
+ *   per tick: varint #events | events... | u8 has parameters | [varint size | parameter bytes]
+ *
+ * Parameters are only stored if they changed since the last tick.
+ *
+ * Usage (recording):
+ *   log.openWrite(path, updateRate, seed);
+ *   log.addEvent(e); // any number of times
+ *   log.writeTick(parameters); // once per tick
+ *
+ * Usage (replay):
+ *   log.openRead(path);
+ *   while (log.readTick(tick)) { ... }
+ */
+class ReplayLog
+{
+public:
+    struct Tick
+    {
+        std::vector<ReplayEvent> events;
+        /// current parameters (unchanged if the tick did not contain any)
+        std::vector<char> parameters;
+    };
+
+private:
+    std::ofstream mOut;
+    std::ifstream mIn;
+
+    uint32_t mUpdateRate = 0;
+    uint32_t mSeed = 0;
+    size_t mTickCount = 0;
+
+    /// events of the current (not yet written) tick
+    std::vector<ReplayEvent> mPendingEvents;
+    /// last written/read parameters
+    std::vector<char> mLastParameters;
+    bool mHasParameters = false;
+    /// size of the log being read (bounds all sizes read from the file)
+    uint64_t mFileSize = 0;
+
+public:
+    uint32_t getUpdateRate() const { return mUpdateRate; }
+    uint32_t getSeed() const { return mSeed; }
+    size_t getTickCount() const { return mTickCount; }
+
+    bool isWriting() const { return mOut.is_open(); }
+    bool isReading() const { return mIn.is_open(); }
+
+public: // writing
+    /// Creates a new log file, returns false on error
+    bool openWrite(std::string const& filename, uint32_t updateRate, uint32_t seed);
+
+    /// Adds an event to the current tick
+    void addEvent(ReplayEvent const& e);
+
+    /// Writes all pending events and the given parameters as one tick
+    void writeTick(std::vector<char> const& parameters);
+
+public: // reading
+    /// Opens an existing log file, returns false on error
+    bool openRead(std::string const& filename);
+
+    /// Reads the next tick, returns false at the end of the log
+    bool readTick(Tick& tick);
+
+public:
+    /// Closes the log (flushes if writing)
+    void close();
+
+private:
+    void writeVarint(uint64_t v);
+    bool readVarint(uint64_t& v);
+    /// number of unread bytes in the log being read
+    uint64_t remainingBytes();
+    template <typename T>
+    void writeRaw(T const& v)
+    {
+        mOut.write((char const*)&v, sizeof(T));
+    }
+    template <typename T>
+    bool readRaw(T& v)
+    {
+        return (bool)mIn.read((char*)&v, sizeof(T));
+    }
+};
+}
+}
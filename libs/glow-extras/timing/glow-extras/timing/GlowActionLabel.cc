@@ -3,7 +3,7 @@
 #include <algorithm>
 #include <iostream>
 
-#include <aion/common/format.hh>
+#include <aion/common/checked_format.hh>
 #include <aion/common/systime.hh>
 
 #include <cassert>
@@ -232,26 +232,19 @@ void GlowActionLabel::print(int maxLines)
     if (labels.size() == 0)
         return;
 
-    int wTime = 8;
-    int wCount = 6;
-
-    std::cout << aion_fmt::format("{:>" + std::to_string(wTime) + "} {:>" + std::to_string(wTime) + "} {:>" + std::to_string(wTime)
-                                      + "} {:>" + std::to_string(wTime) + "} {:>" + std::to_string(wCount) + "} {}",
-                                  "GPU Sum", "CPU Sum", "GPU", "CPU", "Cnt", "Name")
-              << std::endl;
+    // columns: 8 chars per time, 6 per count
+    aion::formatTo(std::cout, AION_FMT("{:>8} {:>8} {:>8} {:>8} {:>6} {}\n"), "GPU Sum", "CPU Sum", "GPU", "CPU", "Cnt", "Name");
     for (auto i = 0u; i < labels.size(); ++i)
     {
         if (maxLines-- <= 0)
             break;
 
         auto const &r = labels[i];
-        std::cout << aion_fmt::format("{:>" + std::to_string(wTime) + "} {:>" + std::to_string(wTime) + "} {:>" + std::to_string(wTime)
-                                          + "} {:>" + std::to_string(wTime) + "} {:>" + std::to_string(wCount) + "} {}",
-                                      aion_systime::formatHuman(r.sumGPU), aion_systime::formatHuman(r.sumCPU),
-                                      aion_systime::formatHuman(r.avgGPU), aion_systime::formatHuman(r.avgCPU),
-                                      std::to_string(r.count) + "x", r.name)
-                  << std::endl;
+        aion::formatTo(std::cout, AION_FMT("{:>8} {:>8} {:>8} {:>8} {:>5}x {}\n"), aion_systime::formatHuman(r.sumGPU),
+                       aion_systime::formatHuman(r.sumCPU), aion_systime::formatHuman(r.avgGPU), aion_systime::formatHuman(r.avgCPU),
+                       r.count, r.name);
     }
+    std::cout.flush();
 }
 
 SharedTimerQuery GlowActionLabel::getQuery()
@@ -3,23 +3,48 @@
 #include <ctime>
 #include <iomanip>
 #include <cassert>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <vector>
+
+#include "thread_local.hh"
 
 std::ostream *glow::internal::logStream = nullptr;
 std::ostream *glow::internal::logStreamError = nullptr;
 std::string glow::internal::logPrefix = "[$t][$l] ";
 uint8_t glow::internal::logMask = 0xFF;
+bool glow::internal::logAsync = false;
+int glow::internal::logRateLimit = 50;
 
-void glow::setLogStream(std::ostream *ossNormal, std::ostream *ossError)
+struct glow::internal::LogRecord
 {
-    internal::logStream = ossNormal;
-    internal::logStreamError = ossError;
-}
+    /// (written by senders, read by the writer thread)
+    std::atomic<LogRecord *> next{nullptr};
 
-glow::internal::LogObject::LogObject(std::ostream *oss, LogLevel lvl) : oss(oss)
+    std::ostream *oss = nullptr;
+    LogLevel lvl = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    /// formatted message without prefix (capacity is reused)
+    std::string text;
+
+    /// formatting target of an enclosing log of the same thread (restored when sent)
+    std::string *outerTarget = nullptr;
+};
+
+using namespace glow::internal;
+
+namespace
 {
-    auto prefix = logPrefix; // copy
+/// Replaces $l and $t of the prefix
+void formatPrefix(std::string &prefix, glow::LogLevel lvl, std::time_t time)
+{
+    prefix = logPrefix; // copy
 
     // replace $l
     auto pos = prefix.find("$l");
@@ -28,16 +53,16 @@ glow::internal::LogObject::LogObject(std::ostream *oss, LogLevel lvl) : oss(oss)
         const char *stype = nullptr;
         switch (lvl)
         {
-        case LogLevel::Info:
+        case glow::LogLevel::Info:
             stype = "Info";
             break;
-        case LogLevel::Debug:
+        case glow::LogLevel::Debug:
             stype = "Debug";
             break;
-        case LogLevel::Error:
+        case glow::LogLevel::Error:
             stype = "Error";
             break;
-        case LogLevel::Warning:
+        case glow::LogLevel::Warning:
             stype = "Warning";
             break;
         }
@@ -49,27 +74,447 @@ glow::internal::LogObject::LogObject(std::ostream *oss, LogLevel lvl) : oss(oss)
     pos = prefix.find("$t");
     if (pos != std::string::npos)
     {
-        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
         char timestr[10];
-        std::strftime(timestr, sizeof(timestr), "%H:%M:%S", std::localtime(&now));
+        std::strftime(timestr, sizeof(timestr), "%H:%M:%S", std::localtime(&time));
 
         prefix.replace(pos, 2, timestr);
     }
+}
+
+/// streambuf that appends to a (reused) string
+struct AppendBuffer : std::streambuf
+{
+    std::string *target = nullptr;
+
+    int_type overflow(int_type c) override
+    {
+        if (c != traits_type::eof())
+            target->push_back((char)c);
+        return c;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        target->append(s, (std::size_t)n);
+        return n;
+    }
+};
+
+/// per-thread formatting state of the async backend
+struct ThreadState
+{
+    AppendBuffer buffer;
+    std::ostream stream{&buffer};
+
+    /// records taken from the pool
+    std::vector<LogRecord *> records;
+
+    /// rate limiting per call site (direct mapped)
+    struct Site
+    {
+        void const *key = nullptr;
+        int64_t window = -1; // in seconds
+        int count = 0;
+        int suppressed = 0;
+        /// target of the summary line
+        std::ostream *oss = nullptr;
+        glow::LogLevel lvl = glow::LogLevel::Info;
+    };
+    Site sites[64];
+    /// last window in which the sites were checked for pending summaries
+    int64_t sweptWindow = -1;
+};
+
+GLOW_THREADLOCAL ThreadState *sThreadState = nullptr;
+
+/**
+ * Background writer of the async backend
+ *
+ * Records are sent via an intrusive multi-producer queue (Vyukov), i.e. one exchange per log.
+ * Written records are recycled via a pool (taken in batches by the threads).
+ */
+class AsyncLog
+{
+private:
+    std::atomic<LogRecord *> mTail{nullptr};
+    /// consumed node before the first record (writer only)
+    LogRecord *mHead = nullptr;
+
+    std::atomic<uint64_t> mSent{0};
+    std::atomic<uint64_t> mWritten{0};
+
+    std::mutex mPoolMutex;
+    std::vector<LogRecord *> mPool;
+
+    std::mutex mStatesMutex;
+    std::vector<std::unique_ptr<ThreadState>> mStates;
+
+    std::thread mWriter;
+    std::atomic<bool> mRunning{false};
+    std::atomic<bool> mSleeping{false};
+    std::mutex mWaitMutex;
+    std::condition_variable mWakeWriter;
+    std::condition_variable mWrittenCondition;
+
+    static const int PoolBatch = 32;
+
+public:
+    AsyncLog()
+    {
+        mHead = new LogRecord;
+        mTail = mHead;
+    }
+
+    ~AsyncLog()
+    {
+        stop();
+        logAsync = false; // later logs are synchronous
+        delete mHead;
+        for (auto r : mPool)
+            delete r;
+        for (auto const &s : mStates)
+            for (auto r : s->records)
+                delete r;
+    }
+
+    void start()
+    {
+        if (mRunning)
+            return;
+        mRunning = true;
+        mWriter = std::thread([this] { run(); });
+    }
+
+    void stop()
+    {
+        if (!mRunning)
+            return;
+        {
+            // (no other thread logs while stopping)
+            threadState(); // (summaries use the records of this thread)
+            std::lock_guard<std::mutex> lock(mStatesMutex);
+            for (auto const &state : mStates)
+                for (auto &s : state->sites)
+                    sendSuppressed(s);
+        }
+        flush();
+        mRunning = false;
+        wakeWriter();
+        mWriter.join();
+    }
+
+    ThreadState &threadState()
+    {
+        if (!sThreadState)
+        {
+            // (owned here, states of finished threads are kept until shutdown)
+            auto state = new ThreadState;
+            std::lock_guard<std::mutex> lock(mStatesMutex);
+            mStates.emplace_back(state);
+            sThreadState = state;
+        }
+        return *sThreadState;
+    }
+
+    LogRecord *acquire()
+    {
+        auto &records = threadState().records;
+        if (records.empty())
+        {
+            std::lock_guard<std::mutex> lock(mPoolMutex);
+            while (!mPool.empty() && (int)records.size() < PoolBatch)
+            {
+                records.push_back(mPool.back());
+                mPool.pop_back();
+            }
+        }
+
+        if (records.empty())
+            return new LogRecord;
+
+        auto r = records.back();
+        records.pop_back();
+        return r;
+    }
+
+    void release(LogRecord *r) { threadState().records.push_back(r); }
+
+    /// sends the summary line of suppressed logs of a call site (if any)
+    void sendSuppressed(ThreadState::Site &s)
+    {
+        if (s.suppressed == 0)
+            return;
+
+        auto r = acquire();
+        r->oss = s.oss;
+        r->lvl = s.lvl;
+        r->time = std::chrono::system_clock::now();
+        r->text = "(" + std::to_string(s.suppressed) + " similar messages suppressed: \"";
+        r->text += static_cast<char const *>(s.key);
+        r->text += "\")";
+        send(r);
+
+        s.suppressed = 0;
+    }
+
+    /// sends the pending summaries of the calling thread
+    void sendSuppressed()
+    {
+        if (!sThreadState)
+            return;
+        for (auto &s : sThreadState->sites)
+            sendSuppressed(s);
+    }
+
+    void send(LogRecord *r)
+    {
+        r->next.store(nullptr, std::memory_order_relaxed);
+        auto prev = mTail.exchange(r, std::memory_order_acq_rel);
+        prev->next.store(r, std::memory_order_release);
+        ++mSent;
+
+        if (mSleeping)
+            wakeWriter();
+    }
+
+    /// blocks until everything sent so far is written
+    void flush()
+    {
+        auto target = mSent.load();
+        if (mWritten >= target)
+            return;
+
+        wakeWriter();
+        std::unique_lock<std::mutex> lock(mWaitMutex);
+        while (mWritten < target)
+            mWrittenCondition.wait(lock);
+    }
+
+private:
+    void wakeWriter()
+    {
+        std::lock_guard<std::mutex> lock(mWaitMutex);
+        mWakeWriter.notify_one();
+    }
+
+    void run()
+    {
+        std::vector<LogRecord *> written;
+        std::vector<std::ostream *> streams;
+        std::string prefix;
+        auto prefixTime = std::time_t(-1);
+        auto prefixLevel = glow::LogLevel::Info;
+
+        while (true)
+        {
+            // write all available records
+            auto next = mHead->next.load(std::memory_order_acquire);
+            while (next)
+            {
+                auto r = next;
+
+                auto time = std::chrono::system_clock::to_time_t(r->time);
+                if (time != prefixTime || r->lvl != prefixLevel || prefix.empty())
+                {
+                    formatPrefix(prefix, r->lvl, time);
+                    prefixTime = time;
+                    prefixLevel = r->lvl;
+                }
+
+                *r->oss << prefix << r->text << '\n';
+
+                if (std::find(streams.begin(), streams.end(), r->oss) == streams.end())
+                    streams.push_back(r->oss);
+
+                // r becomes the consumed head
+                written.push_back(mHead);
+                mHead = r;
+                next = r->next.load(std::memory_order_acquire);
+            }
+
+            if (!written.empty())
+            {
+                // one flush per batch instead of std::endl per line
+                for (auto s : streams)
+                    s->flush();
+                streams.clear();
+
+                {
+                    std::lock_guard<std::mutex> lock(mPoolMutex);
+                    mPool.insert(mPool.end(), written.begin(), written.end());
+                }
+
+                std::lock_guard<std::mutex> lock(mWaitMutex);
+                mWritten += written.size();
+                mWrittenCondition.notify_all();
+                written.clear();
+                continue;
+            }
+
+            if (!mRunning)
+                break;
+
+            // sleep until woken by senders (timeout covers missed wakeups)
+            std::unique_lock<std::mutex> lock(mWaitMutex);
+            mSleeping = true;
+            if (!mHead->next.load() && mRunning)
+                mWakeWriter.wait_for(lock, std::chrono::milliseconds(50));
+            mSleeping = false;
+        }
+    }
+};
+
+AsyncLog &asyncLog()
+{
+    static AsyncLog log;
+    return log;
+}
+}
+
+void glow::setLogStream(std::ostream *ossNormal, std::ostream *ossError)
+{
+    internal::logStream = ossNormal;
+    internal::logStreamError = ossError;
+}
+
+glow::internal::LogObject::LogObject(std::ostream *oss, LogLevel lvl) : oss(oss), lvl(lvl)
+{
+    if (!oss)
+        return;
+
+    if (logAsync)
+    {
+        // format into a pooled record
+        auto &log = asyncLog();
+        record = log.acquire();
+        record->oss = oss;
+        record->lvl = lvl;
+        record->time = std::chrono::system_clock::now();
+        record->text.clear();
+
+        // (logs may be nested, e.g. info() << f() where f logs)
+        auto &state = log.threadState();
+        record->outerTarget = state.buffer.target;
+        state.buffer.target = &record->text;
+        state.stream.flags(std::ios_base::dec | std::ios_base::skipws);
+        state.stream.precision(6);
+        state.stream.fill(' ');
+        this->oss = &state.stream;
+        return;
+    }
+
+    std::string prefix;
+    formatPrefix(prefix, lvl, std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
 
     *this << prefix;
 }
 
+glow::internal::LogObject::LogObject(LogObject &&rhs) : oss(rhs.oss), record(rhs.record), rateChecked(rhs.rateChecked), lvl(rhs.lvl)
+{
+    rhs.oss = nullptr;
+    rhs.record = nullptr;
+}
+
 glow::internal::LogObject::~LogObject()
 {
-    if (oss)
+    if (record)
+    {
+        auto &log = asyncLog();
+        log.threadState().buffer.target = record->outerTarget;
+        if (oss)
+        {
+            log.send(record);
+
+            // errors are written synchronously
+            if (lvl == LogLevel::Error)
+                log.flush();
+        }
+        else
+            log.release(record); // suppressed
+    }
+    else if (oss)
         *oss << std::endl;
 }
 
+void glow::internal::LogObject::checkRate(void const *site) const
+{
+    rateChecked = true;
+    // warnings and errors are never suppressed
+    if (!site || logRateLimit <= 0 || lvl == LogLevel::Warning || lvl == LogLevel::Error)
+        return;
+
+    auto &log = asyncLog();
+    auto &state = log.threadState();
+    auto window = std::chrono::duration_cast<std::chrono::seconds>(record->time.time_since_epoch()).count();
+
+    // report sites whose window is over (also if they went quiet)
+    if (state.sweptWindow != window)
+    {
+        state.sweptWindow = window;
+        for (auto &s : state.sites)
+            if (s.window != window)
+                log.sendSuppressed(s);
+    }
+
+    auto &s = state.sites[(reinterpret_cast<std::uintptr_t>(site) >> 3) % 64];
+    if (s.key != site)
+    {
+        log.sendSuppressed(s); // (collision)
+        s = ThreadState::Site();
+        s.key = site;
+    }
+    if (s.window != window)
+    {
+        s.window = window;
+        s.count = 0;
+    }
+
+    if (++s.count > logRateLimit)
+    {
+        ++s.suppressed;
+        s.oss = record->oss;
+        s.lvl = lvl;
+        oss = nullptr; // skip formatting
+    }
+}
+
 void glow::setLogPrefix(const std::string &prefix)
 {
     internal::logPrefix = prefix;
 }
 
+void glow::setLogAsync(bool enabled)
+{
+    if (enabled == internal::logAsync)
+        return;
+
+    if (enabled)
+        asyncLog().start();
+    else
+        asyncLog().stop();
+
+    internal::logAsync = enabled;
+}
+
+bool glow::isLogAsync()
+{
+    return internal::logAsync;
+}
+
+void glow::setLogRateLimit(int logsPerSecond)
+{
+    internal::logRateLimit = logsPerSecond;
+}
+
+void glow::flushLog()
+{
+    if (internal::logAsync)
+    {
+        asyncLog().sendSuppressed();
+        asyncLog().flush();
+    }
+}
+
 std::ostream *glow::getLogStreamError()
 {
     return internal::logStreamError ? internal::logStreamError : &std::cerr;
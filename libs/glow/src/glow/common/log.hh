@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 namespace glow
 {
@@ -28,15 +31,44 @@ extern std::ostream* logStream;
 extern std::ostream* logStreamError;
 extern std::string logPrefix;
 extern uint8_t logMask;
+extern bool logAsync;
+extern int logRateLimit;
+
+/// record of the async backend (see log.cc)
+struct LogRecord;
 
 struct LogObject
 {
-    std::ostream* oss;
+    /// target stream (thread-local record stream if async)
+    mutable std::ostream* oss;
+    /// nullptr if synchronous
+    mutable LogRecord* record = nullptr;
+    mutable bool rateChecked = false;
+    LogLevel lvl;
 
     LogObject(std::ostream* oss, LogLevel lvl);
+    LogObject(LogObject&& rhs);
+    LogObject(LogObject const&) = delete;
+    LogObject& operator=(LogObject const&) = delete;
     ~LogObject();
+
+    /// rate limiting of the async backend, called with the first streamed object
+    /// (string literals identify the call site, other objects are not limited)
+    void checkRate(void const* site) const;
 };
 
+/// call site key for rate limiting
+template <typename T>
+void const* logSite(T const&)
+{
+    return nullptr;
+}
+template <std::size_t N>
+void const* logSite(char const (&str)[N])
+{
+    return str;
+}
+
 template <typename T>
 std::string to_string(const T& value)
 {
@@ -45,13 +77,49 @@ std::string to_string(const T& value)
 	return os.str();
 }
 
+/// streams integers and strings directly,
+/// other types via to_string (std::to_string for floats, glm::to_string via ADL)
 template <typename T>
-LogObject const& operator<<(LogObject const& lo, T const& obj)
+void write(std::ostream& os, const T& value, std::true_type)
+{
+    os << value;
+}
+template <typename T>
+void write(std::ostream& os, const T& value, std::false_type)
 {
 	using namespace std;
 
+    os << to_string(value);
+}
+template <typename T>
+void write(std::ostream& os, const T& value)
+{
+    // (wide character types would be streamed as numbers or not at all)
+    using direct = std::integral_constant<bool, (std::is_integral<T>::value && !std::is_same<T, wchar_t>::value
+                                                 && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value)
+                                                    || std::is_convertible<T const&, char const*>::value
+                                                    || std::is_same<T, std::string>::value>;
+    write(os, value, direct());
+}
+/// int8_t/uint8_t are numbers, not characters (plain char is still streamed as character)
+inline void write(std::ostream& os, signed char value)
+{
+    os << +value;
+}
+inline void write(std::ostream& os, unsigned char value)
+{
+    os << +value;
+}
+
+template <typename T>
+LogObject const& operator<<(LogObject const& lo, T const& obj)
+{
+    if (lo.record && !lo.rateChecked)
+        lo.checkRate(logSite(obj));
+
+    // (formatted directly into the record if async)
     if (lo.oss)
-        *lo.oss << to_string(obj);
+        write(*lo.oss, obj);
     return lo;
 }
 }
@@ -75,6 +143,28 @@ void setLogMask(uint8_t mask);
 void setLogMask(LogLevel mask);
 uint8_t getLogMask();
 
+/// Enables the asynchronous backend (disabled by default)
+///
+/// Log lines are formatted into per-thread buffers on the calling thread
+/// and written by a background thread (handed over via a lock-free queue).
+/// Errors are flushed synchronously (i.e. error() returns after everything up to it is written).
+/// Disabling flushes all pending logs.
+/// CAUTION: do not call while other threads log
+void setLogAsync(bool enabled);
+bool isLogAsync();
+
+/// Maximum number of async logs per second and call site (per thread), 0 means unlimited
+/// A call site is identified by the first streamed string literal, e.g. info() << "Created " << n;
+/// Only info and debug logs are limited, warnings and errors are always written
+/// Suppressed logs are reported as a summary line after their second (with the next log of the thread),
+/// by flushLog() (calling thread) and when disabling the async backend
+/// Default: 50
+void setLogRateLimit(int logsPerSecond);
+
+/// Blocks until all pending async logs are written
+/// (including summaries of logs suppressed on the calling thread)
+void flushLog();
+
 /// returns the current log stream for non-error logs
 std::ostream* getLogStream();
 
@@ -8,9 +8,13 @@
 
 #include <aion/Action.hh>
 #define GLOW_ACTION(...) ACTION(__VA_ARGS__)
+#define GLOW_COUNTER(name, value) AION_COUNTER(name, value)
+#define GLOW_GAUGE(name, value) AION_GAUGE(name, value)
 
 #else // deactivate
 
 #define GLOW_ACTION(...) (void)0 // force ;
+#define GLOW_COUNTER(name, value) (void)0
+#define GLOW_GAUGE(name, value) (void)0
 
 #endif
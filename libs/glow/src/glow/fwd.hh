@@ -18,6 +18,7 @@ GLOW_SHARED(class, ElementArrayBuffer);
 GLOW_SHARED(class, UniformBuffer);
 GLOW_SHARED(class, ShaderStorageBuffer);
 GLOW_SHARED(class, AtomicCounterBuffer);
+GLOW_SHARED(class, StreamBuffer);
 
 GLOW_SHARED(class, VertexArray);
 
@@ -6,6 +6,7 @@
 
 int glow::limits::maxCombinedTextureImageUnits = -1;
 float glow::limits::maxAnisotropy = -1;
+int glow::limits::uniformBufferOffsetAlignment = -1;
 
 void glow::limits::update()
 {
@@ -13,4 +14,5 @@ void glow::limits::update()
 
     glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxCombinedTextureImageUnits);
     glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferOffsetAlignment);
 }
@@ -9,6 +9,8 @@ namespace limits
 extern int maxCombinedTextureImageUnits;
 /// max value for anisotropic filtering
 extern float maxAnisotropy;
+/// required alignment of glBindBufferRange offsets for uniform buffers
+extern int uniformBufferOffsetAlignment;
 
 /// updates all limits
 /// Is done in glowInit as well
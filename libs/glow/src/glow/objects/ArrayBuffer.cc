@@ -3,6 +3,7 @@
 #include <algorithm>
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/ogl_typeinfo.hh"
@@ -62,7 +63,7 @@ void ArrayBuffer::defineAttributeWithOffset(const std::string &name, GLenum type
     defineAttribute({name, type, size, offset, divisor, mode});
 }
 
-ArrayBuffer::ArrayBuffer() : Buffer(GL_ARRAY_BUFFER)
+ArrayBuffer::ArrayBuffer(const SharedBuffer &originalBuffer) : Buffer(GL_ARRAY_BUFFER, originalBuffer)
 {
 }
 
@@ -78,6 +79,13 @@ SharedArrayBuffer ArrayBuffer::create(const std::vector<ArrayBufferAttribute> &a
     return ab;
 }
 
+SharedArrayBuffer ArrayBuffer::createAliased(const SharedBuffer &originalBuffer, const std::vector<ArrayBufferAttribute> &attrs)
+{
+    auto ab = std::make_shared<ArrayBuffer>(originalBuffer);
+    ab->defineAttributes(attrs);
+    return ab;
+}
+
 
 bool ArrayBuffer::BoundArrayBuffer::isCurrent() const
 {
@@ -101,8 +109,8 @@ ArrayBuffer::BoundArrayBuffer::BoundArrayBuffer(ArrayBuffer *buffer) : buffer(bu
 {
     checkValidGLOW();
 
-    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, buffer->getObjectName());
+    previousBuffer = state::bound(state::Binding::ArrayBuffer);
+    state::bind(state::Binding::ArrayBuffer, buffer->getObjectName());
 
     previousBufferPtr = sCurrentBuffer;
     sCurrentBuffer = this;
@@ -119,7 +127,7 @@ ArrayBuffer::BoundArrayBuffer::~BoundArrayBuffer()
 {
     if (previousBuffer != -1) // if valid
     {
-        glBindBuffer(GL_ARRAY_BUFFER, previousBuffer);
+        state::bind(state::Binding::ArrayBuffer, previousBuffer);
         sCurrentBuffer = previousBufferPtr;
     }
 }
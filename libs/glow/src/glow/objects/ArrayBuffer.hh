@@ -257,7 +257,7 @@ public: // unbound functions
     void setDivisor(int div);
 
 public:
-    ArrayBuffer();
+    ArrayBuffer(SharedBuffer const& originalBuffer = nullptr);
 
     /// Binds this array buffer.
     /// Unbinding is done when the returned object runs out of scope.
@@ -271,5 +271,9 @@ public: // static construction
     ///   ArrayBuffer::create({{&MyVertex::aPosition, "aPosition"},
     ///                        {&MyVertex::texCoord, "aTexCoord"}});
     static SharedArrayBuffer create(std::vector<ArrayBufferAttribute> const& attrs);
+
+    /// Creates an array buffer that shares memory with another buffer (e.g. a StreamBuffer)
+    /// CAUTION: setData must not be used if the original buffer has immutable storage
+    static SharedArrayBuffer createAliased(SharedBuffer const& originalBuffer, std::vector<ArrayBufferAttribute> const& attrs = {});
 };
 }
@@ -1,6 +1,7 @@
 #include "AtomicCounterBuffer.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include <glow/common/runtime_assert.hh>
 #include <glow/common/thread_local.hh>
@@ -96,8 +97,8 @@ size_t AtomicCounterBuffer::BoundAtomicCounterBuffer::getCounterSize() const
 AtomicCounterBuffer::BoundAtomicCounterBuffer::BoundAtomicCounterBuffer(AtomicCounterBuffer *buffer) : buffer(buffer)
 {
     checkValidGLOW();
-    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &previousBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->getObjectName());
+    previousBuffer = state::bound(state::Binding::ShaderStorageBuffer);
+    state::bind(state::Binding::ShaderStorageBuffer, buffer->getObjectName());
 
     previousBufferPtr = sCurrentBuffer;
     sCurrentBuffer = this;
@@ -114,7 +115,7 @@ AtomicCounterBuffer::BoundAtomicCounterBuffer::~BoundAtomicCounterBuffer()
 {
     if (previousBuffer != -1) // if valid
     {
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, previousBuffer);
+        state::bind(state::Binding::ShaderStorageBuffer, previousBuffer);
         sCurrentBuffer = previousBufferPtr;
     }
 }
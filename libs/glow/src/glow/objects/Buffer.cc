@@ -1,6 +1,7 @@
 #include "Buffer.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include <limits>
 #include <cassert>
@@ -36,6 +37,7 @@ Buffer::~Buffer()
     {
         checkValidGLOW();
 
+        state::forgetBuffer(mObjectName);
         glDeleteBuffers(1, &mObjectName);
     }
 }
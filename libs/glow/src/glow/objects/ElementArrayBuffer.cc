@@ -3,6 +3,7 @@
 #include "VertexArray.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/thread_local.hh"
@@ -212,8 +213,8 @@ ElementArrayBuffer::BoundElementArrayBuffer::BoundElementArrayBuffer(ElementArra
 
     checkValidGLOW();
 
-    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &previousBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->getObjectName());
+    previousBuffer = state::bound(state::Binding::ElementArrayBuffer);
+    state::bind(state::Binding::ElementArrayBuffer, buffer->getObjectName());
 
     previousBufferPtr = sCurrentBuffer;
     sCurrentBuffer = this;
@@ -230,7 +231,7 @@ ElementArrayBuffer::BoundElementArrayBuffer::~BoundElementArrayBuffer()
 {
     if (previousBuffer != -1) // if valid
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, previousBuffer);
+        state::bind(state::Binding::ElementArrayBuffer, previousBuffer);
         sCurrentBuffer = previousBufferPtr;
     }
 }
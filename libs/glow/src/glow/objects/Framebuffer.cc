@@ -9,6 +9,7 @@
 #include "TextureRectangle.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/thread_local.hh"
@@ -173,6 +174,7 @@ Framebuffer::Framebuffer()
 Framebuffer::~Framebuffer()
 {
     checkValidGLOW();
+    state::forgetFramebuffer(mObjectName);
     glDeleteFramebuffers(1, &mObjectName);
 }
 
@@ -285,11 +287,12 @@ void Framebuffer::BoundFramebuffer::attachDepth(GLenum depthFormat)
     auto tex = buffer->mColorAttachments[0].texture;
 
     // save old
-    GLint oldTex;
-    glGetIntegerv(tex->getBindingTarget(), &oldTex);
+    auto unit = state::scratchTextureUnit();
+    auto oldTex = state::boundTexture(unit, tex->getTarget());
 
     // bind color
-    glBindTexture(tex->getTarget(), tex->getObjectName());
+    state::bindTexture(unit, tex->getTarget(), tex->getObjectName());
+    state::activeTexture(unit);
 
     // get dimensions
     GLint w, h;
@@ -297,7 +300,7 @@ void Framebuffer::BoundFramebuffer::attachDepth(GLenum depthFormat)
     glGetTexLevelParameteriv(tex->getTarget(), buffer->mColorAttachments[0].mipmapLevel, GL_TEXTURE_HEIGHT, &h);
 
     // restore
-    glBindTexture(tex->getTarget(), oldTex);
+    state::bindTexture(unit, tex->getTarget(), oldTex);
 
     // create and attach 2DRect depth texture
     attachDepth(TextureRectangle::create(w, h, depthFormat));
@@ -310,17 +313,12 @@ Framebuffer::BoundFramebuffer::BoundFramebuffer(Framebuffer *buffer) : buffer(bu
 {
     checkValidGLOW();
 
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousBuffer);
-
-    GLint readFBO = 0;
-    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFBO);
-    if (readFBO != previousBuffer)
+    previousBuffer = state::bound(state::Binding::DrawFramebuffer);
+    if (state::bound(state::Binding::ReadFramebuffer) != (GLuint)previousBuffer)
         error() << "GLOW does not support differing READ and WRITE Framebuffer.";
 
-    for (auto i = 0u; i < previousDrawBuffers.size(); ++i)
-        glGetIntegerv(GL_DRAW_BUFFER0 + i, (GLint *)&previousDrawBuffers[i]);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, buffer->getObjectName());
+    // (draw buffers are framebuffer state, no need to save them)
+    state::bindFramebuffer(buffer->getObjectName());
 
     GLenum drawBuffers[8] = {};
     for (auto i = 0u; i < buffer->mColorAttachments.size(); ++i)
@@ -346,10 +344,7 @@ Framebuffer::BoundFramebuffer::BoundFramebuffer(Framebuffer *buffer) : buffer(bu
 }
 
 Framebuffer::BoundFramebuffer::BoundFramebuffer(Framebuffer::BoundFramebuffer &&rhs)
-  : buffer(rhs.buffer),
-    previousBuffer(rhs.previousBuffer),
-    previousDrawBuffers(rhs.previousDrawBuffers),
-    previousBufferPtr(rhs.previousBufferPtr)
+  : buffer(rhs.buffer), previousBuffer(rhs.previousBuffer), previousBufferPtr(rhs.previousBufferPtr)
 {
     // invalidate rhs
     rhs.previousBuffer = -1;
@@ -361,11 +356,9 @@ Framebuffer::BoundFramebuffer::~BoundFramebuffer()
     {
         checkValidGLOW();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, previousBuffer);
+        state::bindFramebuffer(previousBuffer);
         sCurrentBuffer = previousBufferPtr;
 
-        glDrawBuffers(previousDrawBuffers.size(), previousDrawBuffers.data());
-
         if (buffer->mAutoViewport)
             glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
     }
@@ -118,10 +118,9 @@ public:
         void attachDepth(GLenum depthFormat = GL_DEPTH_COMPONENT32);
 
     private:
-        GLint previousBuffer;                      ///< previously bound buffer
-        std::array<GLenum, 8> previousDrawBuffers; ///< previously setup draw buffers
-        std::array<GLint, 4> previousViewport;     ///< previously configure viewport
-        BoundFramebuffer* previousBufferPtr;       ///< previously bound buffer
+        GLint previousBuffer;                  ///< previously bound buffer
+        std::array<GLint, 4> previousViewport; ///< previously configure viewport
+        BoundFramebuffer* previousBufferPtr;   ///< previously bound buffer
         BoundFramebuffer(Framebuffer* buffer);
         friend class Framebuffer;
 
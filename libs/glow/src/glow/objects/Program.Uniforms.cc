@@ -1,5 +1,6 @@
 #include "Program.hh"
 
+#include "Shader.hh"
 #include "Texture.hh"
 #include "Texture2D.hh"
 #include "UniformBuffer.hh"
@@ -7,39 +8,171 @@
 #include "AtomicCounterBuffer.hh"
 
 #include "glow/glow.hh"
-#include "glow/limits.hh"
+#include "glow/state.hh"
 #include "glow/util/UniformState.hh"
 
 #include "glow/common/runtime_assert.hh"
+#include "glow/common/thread_local.hh"
+
+#include <chrono>
+#include <cstring>
+#include <ostream>
 
 using namespace glow;
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const GLfloat *values) const
+/// Uniform cache statistics
+static GLOW_THREADLOCAL uint64_t sUniformsIssued = 0;
+static GLOW_THREADLOCAL uint64_t sUniformsSkipped = 0;
+
+bool Program::updateUniformCache(UniformEntry &entry, const void *data, size_t size, int count) const
+{
+    if (entry.value.size() == size && size > 0 && memcmp(entry.value.data(), data, size) == 0)
+    {
+        ++sUniformsSkipped;
+        return false;
+    }
+
+    entry.value.assign((char const *)data, (char const *)data + size);
+    entry.valueCount = count;
+    ++sUniformsIssued;
+
+    // "arr" and "arr[i]" share storage (element i is at location(arr) + i):
+    // cached values of other entries overlapping the written locations are stale now
+    if (mUniformsMayAlias && entry.location >= 0)
+        for (auto &e : mUniformEntries)
+            if (&e != &entry && e.location >= 0 && !e.value.empty() && e.location < entry.location + count
+                && entry.location < e.location + e.valueCount)
+                e.value.clear();
+
+    return true;
+}
+
+Program::UniformStatistics Program::getUniformStatistics()
+{
+    UniformStatistics stats;
+    stats.issued = sUniformsIssued;
+    stats.skipped = sUniformsSkipped;
+    return stats;
+}
+
+void Program::resetUniformStatistics()
+{
+    sUniformsIssued = 0;
+    sUniformsSkipped = 0;
+}
+
+/// ns per call of f(i), including the GL work
+template <class F>
+static double measureUniformCalls(size_t calls, F &&f)
+{
+    // warm up (interning, first GL calls)
+    for (auto i = size_t{0}; i < 1000; ++i)
+        f(i);
+    glFinish();
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = size_t{0}; i < calls; ++i)
+        f(i);
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / double(calls);
+}
+
+void Program::dumpUniformOverhead(std::ostream &oss, size_t calls)
+{
+    // (a few active uniforms so lookups are not trivial)
+    const int uniformCount = 16;
+    std::string fsh = "#version 330 core\nout vec4 fColor;\n";
+    std::string sum = "0.0";
+    for (auto i = 0; i < uniformCount; ++i)
+    {
+        fsh += "uniform float uValue" + std::to_string(i) + ";\n";
+        sum += " + uValue" + std::to_string(i);
+    }
+    fsh += "void main() { fColor = vec4(" + sum + "); }\n";
+
+    auto vsh = "#version 330 core\nvoid main() { gl_Position = vec4(0.0); }\n";
+    auto program = Program::create({Shader::createFromSource(GL_VERTEX_SHADER, vsh), Shader::createFromSource(GL_FRAGMENT_SHADER, fsh)});
+    if (!program->isLinked())
+    {
+        oss << "setUniform overhead: test program could not be linked\n";
+        return;
+    }
+
+    auto const stats = getUniformStatistics();
+
+    auto shader = program->use();
+    std::string stringName = "uValue7";
+    char const *charName = stringName.c_str();
+    auto handle = program->uniform("uValue7");
+
+    // (values change every call, i.e. every call reaches GL)
+    auto nsString = measureUniformCalls(calls, [&](size_t i)
+                                        {
+                                            shader.setUniform(stringName, (float)i);
+                                        });
+    auto nsChar = measureUniformCalls(calls, [&](size_t i)
+                                      {
+                                          shader.setUniform(charName, (float)i);
+                                      });
+    auto nsLiteral = measureUniformCalls(calls, [&](size_t i)
+                                         {
+                                             shader.setUniform("uValue7", (float)i);
+                                         });
+    auto nsHandle = measureUniformCalls(calls, [&](size_t i)
+                                        {
+                                            shader.setUniform(handle, (float)i);
+                                        });
+    auto nsSkipped = measureUniformCalls(calls, [&](size_t)
+                                         {
+                                             shader.setUniform(handle, 1.0f);
+                                         });
+
+    oss << "setUniform(float) overhead (" << calls << " calls, " << uniformCount << " uniforms):\n";
+    oss << "  std::string: " << nsString << " ns/call\n";
+    oss << "  char*: " << nsChar << " ns/call\n";
+    oss << "  literal: " << nsLiteral << " ns/call\n";
+    oss << "  UniformHandle: " << nsHandle << " ns/call\n";
+    oss << "  UniformHandle (unchanged value, skipped): " << nsSkipped << " ns/call\n";
+
+    sUniformsIssued = stats.issued;
+    sUniformsSkipped = stats.skipped;
+}
+
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const GLfloat *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
-    glUniform1fv(program->getUniformLocation(name), count, values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform1fv(entry.location, count, values);
 }
 
-void Program::UsedProgram::setTexture(const std::string &name, const SharedTexture &tex)
+void Program::UsedProgram::setTexture(const UniformName &name, const SharedTexture &tex)
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
 
-    // bind texture to unit
-    auto unit = program->mTextureUnitMapping.getOrAddLocation(name);
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(tex->getTarget(), tex->getObjectName());
+    // bind texture to unit (unit is cached in the uniform entry)
+    auto &entry = program->resolveUniform(name);
+    if (entry.textureUnit < 0)
+        entry.textureUnit = program->mTextureUnitMapping.getOrAddLocation(entry.name);
+    auto unit = (GLuint)entry.textureUnit;
+    state::bindTexture(unit, tex->getTarget(), tex->getObjectName());
 
     // safety net: activate different unit
-    glActiveTexture(GL_TEXTURE0 + limits::maxCombinedTextureImageUnits - 1);
+    state::activeTexture(state::scratchTextureUnit());
 
     // update shader binding
-    glUniform1i(program->getUniformLocation(name), unit);
+    auto unitValue = (int32_t)unit;
+    if (program->updateUniformCache(entry, &unitValue, sizeof(unitValue), 1))
+        glUniform1i(entry.location, unitValue);
 
     // save texture
     while (program->mTextures.size() <= unit)
@@ -57,7 +190,7 @@ void Program::UsedProgram::setImage(size_t bindingLocation, const SharedTexture
     glBindImageTexture(bindingLocation, tex->getObjectName(), mipmapLevel, GL_TRUE, layer, usage, tex->getInternalFormat());
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const bool *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const bool *values) const
 {
     std::vector<int32_t> tmp(count);
     for (auto i = 0; i < count; ++i)
@@ -65,121 +198,160 @@ void Program::UsedProgram::setUniform(const std::string &name, int count, const
     setUniformBool(name, tmp.size(), tmp.data());
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const int32_t *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const int32_t *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
-    glUniform1iv(program->getUniformLocation(name), count, values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform1iv(entry.location, count, values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const uint32_t *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const uint32_t *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
-    glUniform1uiv(program->getUniformLocation(name), count, values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform1uiv(entry.location, count, values);
 }
 
-void Program::UsedProgram::setUniformBool(const std::string &name, int count, const int32_t *values) const
+void Program::UsedProgram::setUniformBool(const UniformName &name, int count, const int32_t *values) const
 {
+    if (!isCurrent())
+        return;
+
     checkValidGLOW();
-    glUniform1iv(program->getUniformLocation(name), count, values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform1iv(entry.location, count, values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::vec2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::vec2 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::vec2) == 2 * sizeof(GLfloat), "glm size check");
-    glUniform2fv(program->getUniformLocation(name), count, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform2fv(entry.location, count, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::vec3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::vec3 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::vec3) == 3 * sizeof(GLfloat), "glm size check");
-    glUniform3fv(program->getUniformLocation(name), count, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform3fv(entry.location, count, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::vec4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::vec4 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::vec4) == 4 * sizeof(GLfloat), "glm size check");
-    glUniform4fv(program->getUniformLocation(name), count, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform4fv(entry.location, count, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::ivec2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::ivec2 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::ivec2) == 2 * sizeof(GLint), "glm size check");
-    glUniform2iv(program->getUniformLocation(name), count, (GLint *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform2iv(entry.location, count, (GLint *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::ivec3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::ivec3 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::ivec3) == 3 * sizeof(GLint), "glm size check");
-    glUniform3iv(program->getUniformLocation(name), count, (GLint *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform3iv(entry.location, count, (GLint *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::ivec4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::ivec4 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::ivec4) == 4 * sizeof(GLint), "glm size check");
-    glUniform4iv(program->getUniformLocation(name), count, (GLint *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform4iv(entry.location, count, (GLint *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::uvec2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::uvec2 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::uvec2) == 2 * sizeof(GLuint), "glm size check");
-    glUniform2uiv(program->getUniformLocation(name), count, (GLuint *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform2uiv(entry.location, count, (GLuint *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::uvec3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::uvec3 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::uvec3) == 3 * sizeof(GLuint), "glm size check");
-    glUniform3uiv(program->getUniformLocation(name), count, (GLuint *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform3uiv(entry.location, count, (GLuint *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::uvec4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::uvec4 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::uvec4) == 4 * sizeof(GLuint), "glm size check");
-    glUniform4uiv(program->getUniformLocation(name), count, (GLuint *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniform4uiv(entry.location, count, (GLuint *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::bvec2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::bvec2 *values) const
 {
     if (!isCurrent())
         return;
@@ -190,10 +362,13 @@ void Program::UsedProgram::setUniform(const std::string &name, int count, const
 
     checkValidGLOW();
     static_assert(sizeof(glm::ivec2) == 2 * sizeof(GLint), "glm size check");
-    glUniform2iv(program->getUniformLocation(name), count, (GLint *)tmp.data());
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, tmp.data(), count * sizeof(tmp[0]), count))
+        return;
+    glUniform2iv(entry.location, count, (GLint *)tmp.data());
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::bvec3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::bvec3 *values) const
 {
     if (!isCurrent())
         return;
@@ -204,10 +379,13 @@ void Program::UsedProgram::setUniform(const std::string &name, int count, const
 
     checkValidGLOW();
     static_assert(sizeof(glm::ivec3) == 3 * sizeof(GLint), "glm size check");
-    glUniform3iv(program->getUniformLocation(name), count, (GLint *)tmp.data());
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, tmp.data(), count * sizeof(tmp[0]), count))
+        return;
+    glUniform3iv(entry.location, count, (GLint *)tmp.data());
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::bvec4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::bvec4 *values) const
 {
     if (!isCurrent())
         return;
@@ -218,97 +396,127 @@ void Program::UsedProgram::setUniform(const std::string &name, int count, const
 
     checkValidGLOW();
     static_assert(sizeof(glm::ivec4) == 4 * sizeof(GLint), "glm size check");
-    glUniform4iv(program->getUniformLocation(name), count, (GLint *)tmp.data());
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, tmp.data(), count * sizeof(tmp[0]), count))
+        return;
+    glUniform4iv(entry.location, count, (GLint *)tmp.data());
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat2x2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat2x2 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat2x2) == 2 * 2 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix2fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix2fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat3x3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat3x3 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat3x3) == 3 * 3 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix3fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix3fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat4x4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat4x4 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat4x4) == 4 * 4 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix4fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix4fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat2x3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat2x3 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat2x3) == 2 * 3 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix2x3fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix2x3fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat2x4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat2x4 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat2x4) == 2 * 4 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix2x4fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix2x4fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat3x2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat3x2 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat3x2) == 3 * 2 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix3x2fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix3x2fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat3x4 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat3x4 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat3x4) == 3 * 4 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix3x4fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix3x4fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat4x2 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat4x2 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat4x2) == 4 * 2 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix4x2fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix4x2fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, int count, const glm::mat4x3 *values) const
+void Program::UsedProgram::setUniform(const UniformName &name, int count, const glm::mat4x3 *values) const
 {
     if (!isCurrent())
         return;
 
     checkValidGLOW();
     static_assert(sizeof(glm::mat4x3) == 4 * 3 * sizeof(GLfloat), "glm size check");
-    glUniformMatrix4x3fv(program->getUniformLocation(name), count, GL_FALSE, (GLfloat *)values);
+    auto &entry = program->resolveUniform(name);
+    if (!program->updateUniformCache(entry, values, count * sizeof(values[0]), count))
+        return;
+    glUniformMatrix4x3fv(entry.location, count, GL_FALSE, (GLfloat *)values);
 }
 
 void Program::UsedProgram::setUniforms(const SharedUniformState &state)
@@ -319,7 +527,7 @@ void Program::UsedProgram::setUniforms(const SharedUniformState &state)
     state->restore();
 }
 
-void Program::UsedProgram::setUniform(const std::string &name, GLenum uniformType, GLint size, void const *data)
+void Program::UsedProgram::setUniform(const UniformName &name, GLenum uniformType, GLint size, void const *data)
 {
     switch (uniformType)
     {
@@ -533,6 +741,7 @@ void Program::setUniformBuffer(const std::string &bufferName, const SharedUnifor
 
     auto isNew = !mUniformBuffers.count(bufferName);
     mUniformBuffers[bufferName] = buffer;
+    mUniformBufferRanges.erase(bufferName);
 
     if (idx == GL_INVALID_INDEX)
         return; // not active
@@ -540,12 +749,30 @@ void Program::setUniformBuffer(const std::string &bufferName, const SharedUnifor
     glUniformBlockBinding(mObjectName, idx, loc);
 
     if (getCurrentProgram() && getCurrentProgram()->program == this)
-        glBindBufferBase(GL_UNIFORM_BUFFER, loc, buffer ? buffer->getObjectName() : 0);
+        state::bindBufferBase(GL_UNIFORM_BUFFER, loc, buffer ? buffer->getObjectName() : 0);
 
     if (isNew)
         verifyUniformBuffer(bufferName, buffer);
 }
 
+void Program::setUniformBuffer(const std::string &bufferName, const SharedBuffer &buffer, GLintptr offset, GLsizeiptr size)
+{
+    checkValidGLOW();
+    auto loc = mUniformBufferMapping.getOrAddLocation(bufferName);
+    auto idx = glGetUniformBlockIndex(mObjectName, bufferName.c_str());
+
+    mUniformBuffers.erase(bufferName);
+    mUniformBufferRanges[bufferName] = {buffer, offset, size};
+
+    if (idx == GL_INVALID_INDEX)
+        return; // not active
+
+    glUniformBlockBinding(mObjectName, idx, loc);
+
+    if (getCurrentProgram() && getCurrentProgram()->program == this)
+        state::bindBufferRange(GL_UNIFORM_BUFFER, loc, buffer ? buffer->getObjectName() : 0, offset, size);
+}
+
 void Program::setShaderStorageBuffer(const std::string &bufferName, const SharedShaderStorageBuffer &buffer)
 {
     checkValidGLOW();
@@ -560,7 +787,7 @@ void Program::setShaderStorageBuffer(const std::string &bufferName, const Shared
     glShaderStorageBlockBinding(mObjectName, idx, loc);
 
     if (getCurrentProgram() && getCurrentProgram()->program == this)
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, loc, buffer ? buffer->getObjectName() : 0);
+        state::bindBufferBase(GL_SHADER_STORAGE_BUFFER, loc, buffer ? buffer->getObjectName() : 0);
 }
 
 void Program::setAtomicCounterBuffer(size_t bindingPoint, const SharedAtomicCounterBuffer &buffer)
@@ -569,7 +796,7 @@ void Program::setAtomicCounterBuffer(size_t bindingPoint, const SharedAtomicCoun
     mAtomicCounterBuffers[bindingPoint] = buffer;
 
     if (getCurrentProgram() && getCurrentProgram()->program == this)
-        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, bindingPoint, buffer ? buffer->getObjectName() : 0);
+        state::bindBufferBase(GL_ATOMIC_COUNTER_BUFFER, bindingPoint, buffer ? buffer->getObjectName() : 0);
 }
 
 bool Program::verifyUniformBuffer(const std::string &bufferName, const SharedUniformBuffer &buffer)
@@ -1,6 +1,8 @@
 #include "Program.hh"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <chrono>
 
@@ -10,8 +12,8 @@
 #include "AtomicCounterBuffer.hh"
 #include "Texture.hh"
 
-#include "glow/limits.hh"
 #include "glow/glow.hh"
+#include "glow/state.hh"
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/shader_endings.hh"
 #include "glow/common/str_utils.hh"
@@ -69,20 +71,26 @@ void Program::restoreExtendedState()
     for (auto const &kvp : mUniformBuffers)
     {
         auto loc = mUniformBufferMapping.queryLocation(kvp.first);
-        glBindBufferBase(GL_UNIFORM_BUFFER, loc, kvp.second ? kvp.second->getObjectName() : 0);
+        state::bindBufferBase(GL_UNIFORM_BUFFER, loc, kvp.second ? kvp.second->getObjectName() : 0);
+    }
+    for (auto const &kvp : mUniformBufferRanges)
+    {
+        auto loc = mUniformBufferMapping.queryLocation(kvp.first);
+        auto const &r = kvp.second;
+        state::bindBufferRange(GL_UNIFORM_BUFFER, loc, r.buffer ? r.buffer->getObjectName() : 0, r.offset, r.size);
     }
 
     // bind shader storage buffer
     for (auto const &kvp : mShaderStorageBuffers)
     {
         auto loc = mShaderStorageBufferMapping.queryLocation(kvp.first);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, loc, kvp.second ? kvp.second->getObjectName() : 0);
+        state::bindBufferBase(GL_SHADER_STORAGE_BUFFER, loc, kvp.second ? kvp.second->getObjectName() : 0);
     }
 
     // bind atomic counters
     for (auto const &kvp : mAtomicCounterBuffers)
     {
-        glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, kvp.first, kvp.second ? kvp.second->getObjectName() : 0);
+        state::bindBufferBase(GL_ATOMIC_COUNTER_BUFFER, kvp.first, kvp.second ? kvp.second->getObjectName() : 0);
     }
 
     // restore texture bindings
@@ -92,12 +100,11 @@ void Program::restoreExtendedState()
         if (!tex)
             continue;
 
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(tex->getTarget(), tex->getObjectName());
+        state::bindTexture(unit, tex->getTarget(), tex->getObjectName());
     }
 
     // safety net: activate different unit
-    glActiveTexture(GL_TEXTURE0 + limits::maxCombinedTextureImageUnits - 1);
+    state::activeTexture(state::scratchTextureUnit());
 }
 
 Program::UsedProgram *Program::getCurrentProgram()
@@ -110,16 +117,84 @@ void Program::setShaderReloading(bool enabled)
     sCheckShaderReloading = enabled;
 }
 
-GLint Program::getUniformLocation(const std::string &name) const
+int Program::findUniform(const UniformName &name) const
 {
-    for (auto const &kvp : mUniformCache)
-        if (kvp.first == name)
-            return kvp.second;
+    // handle of this program: no lookup
+    if (name.mHandle.mProgram == this)
+        return name.mHandle.mIndex;
 
-    checkValidGLOW();
-    GLint loc = glGetUniformLocation(mObjectName, name.c_str());
-    mUniformCache.push_back(std::make_pair(name, loc));
-    return loc;
+    // handle of a different program: lookup by name
+    if (name.mHandle.isValid())
+    {
+        auto const &otherName = name.mHandle.mProgram->mUniformEntries[name.mHandle.mIndex].name;
+        return findUniform(otherName);
+    }
+
+    // probe
+    auto mask = mUniformSlots.size() - 1;
+    if (!mUniformSlots.empty())
+        for (auto slot = name.mHash & mask;; slot = (slot + 1) & mask)
+        {
+            auto idx = mUniformSlots[slot];
+            if (idx < 0)
+                break; // not found
+
+            auto const &e = mUniformEntries[idx];
+            if (e.hash == name.mHash && e.name.size() == name.mLength && memcmp(e.name.data(), name.mName, name.mLength) == 0)
+                return idx;
+        }
+
+    // intern new uniform
+    auto idx = (int)mUniformEntries.size();
+    mUniformEntries.push_back({std::string(name.mName, name.mLength), name.mHash, UnresolvedLocation, -1, {}, 0});
+    if (mUniformEntries.back().name.find('[') != std::string::npos)
+        mUniformsMayAlias = true;
+
+    // grow table (load factor <= 0.5)
+    if (mUniformEntries.size() * 2 > mUniformSlots.size())
+    {
+        mUniformSlots.assign(std::max<size_t>(16, mUniformSlots.size() * 2), -1);
+        mask = mUniformSlots.size() - 1;
+        for (auto i = 0; i <= idx; ++i)
+        {
+            auto slot = mUniformEntries[i].hash & mask;
+            while (mUniformSlots[slot] >= 0)
+                slot = (slot + 1) & mask;
+            mUniformSlots[slot] = i;
+        }
+    }
+    else
+    {
+        auto slot = name.mHash & mask;
+        while (mUniformSlots[slot] >= 0)
+            slot = (slot + 1) & mask;
+        mUniformSlots[slot] = idx;
+    }
+
+    return idx;
+}
+
+Program::UniformEntry &Program::resolveUniform(const UniformName &name) const
+{
+    auto &e = mUniformEntries[findUniform(name)];
+    if (e.location == UnresolvedLocation)
+    {
+        checkValidGLOW();
+        e.location = glGetUniformLocation(mObjectName, e.name.c_str());
+    }
+    return e;
+}
+
+GLint Program::getUniformLocation(const UniformName &name) const
+{
+    return resolveUniform(name).location;
+}
+
+UniformHandle Program::uniform(const UniformName &name) const
+{
+    auto idx = findUniform(name);
+    resolveUniform(UniformHandle(this, idx));
+    return {this, idx};
 }
 
 GLuint Program::getUniformBlockIndex(const std::string &name) const
@@ -368,16 +443,23 @@ void Program::link(bool saveUniformState)
     // rebind uniform buffers
     for (auto const &kvp : mUniformBuffers)
         setUniformBuffer(kvp.first, kvp.second);
+    for (auto const &kvp : mUniformBufferRanges)
+        setUniformBuffer(kvp.first, kvp.second.buffer, kvp.second.offset, kvp.second.size);
 
     for (auto const &kvp : mShaderStorageBuffers)
         setShaderStorageBuffer(kvp.first, kvp.second);
 
-    // clear cache
-    mUniformCache.clear();
+    // re-resolve uniform locations lazily (handles stay valid)
+    // linking resets all uniforms, cached values are re-filled by restoring the snapshot
+    for (auto &e : mUniformEntries)
+    {
+        e.location = UnresolvedLocation;
+        e.value.clear();
+    }
 
-	// restore uniforms
-	if (uniforms)
-		uniforms->restore();
+    // restore uniforms
+    if (uniforms)
+        uniforms->restore();
 }
 
 void Program::configureTransformFeedback(const std::vector<std::string> &varyings, GLenum bufferMode)
@@ -511,8 +593,8 @@ SharedProgram Program::createFromFiles(const std::vector<std::string> &filenames
 Program::UsedProgram::UsedProgram(Program *program) : program(program)
 {
     checkValidGLOW();
-    glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
-    glUseProgram(program->mObjectName);
+    previousProgram = state::bound(state::Binding::Program);
+    state::bind(state::Binding::Program, program->mObjectName);
 
     previousProgramPtr = sCurrentProgram;
     sCurrentProgram = this;
@@ -579,7 +661,7 @@ Program::UsedProgram::~UsedProgram()
     if (previousProgram != -1) // only if valid
     {
         checkValidGLOW();
-        glUseProgram(previousProgram);
+        state::bind(state::Binding::Program, previousProgram);
         sCurrentProgram = previousProgramPtr;
 
         // re-restore prev state
@@ -9,9 +9,11 @@
 #include "glow/gl.hh"
 
 #include "glow/util/LocationMapping.hh"
+#include "glow/util/UniformHandle.hh"
 
 #include <vector>
 #include <map>
+#include <iosfwd>
 #include <string>
 
 // only vec/mat types
@@ -49,9 +51,25 @@ private:
     /// Last time of reload checking
     int64_t mLastReloadCheck = 0;
 
-    /// Uniform lookup cache
-    /// Invalidates after link
-    mutable std::vector<std::pair<std::string, GLint>> mUniformCache;
+    /// Interned uniform (see uniform(...))
+    struct UniformEntry
+    {
+        std::string name;
+        uint32_t hash;
+        GLint location;          ///< UnresolvedLocation after link
+        int textureUnit;         ///< -1 if not a texture
+        std::vector<char> value; ///< last value sent to GL (empty if unknown)
+        int valueCount;          ///< array elements in value, i.e. value covers [location, location + valueCount)
+    };
+    static const GLint UnresolvedLocation = -2;
+
+    /// Interned uniforms (index = UniformHandle index)
+    mutable std::vector<UniformEntry> mUniformEntries;
+    /// Open-addressing hash table into mUniformEntries (-1 = empty, size is power of two)
+    mutable std::vector<int> mUniformSlots;
+    /// true iff an array element ("arr[i]") was interned, i.e. different entries may share GL storage
+    /// (their cached values are then invalidated by location range)
+    mutable bool mUniformsMayAlias = false;
 
     /// Texture unit mapping
     LocationMapping mTextureUnitMapping;
@@ -73,6 +91,14 @@ private:
     LocationMapping mUniformBufferMapping;
     /// Bound uniform buffer
     std::map<std::string, SharedUniformBuffer> mUniformBuffers;
+    /// Bound uniform buffer range (e.g. StreamBuffer allocations)
+    struct UniformBufferRange
+    {
+        SharedBuffer buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+    std::map<std::string, UniformBufferRange> mUniformBufferRanges;
 
     /// Mapping for shaderStorage buffers
     LocationMapping mShaderStorageBufferMapping;
@@ -105,6 +131,14 @@ private:
     /// Reset frag location check
     /// Necessary because frags cannot be queried ...
     void resetFragmentLocationCheck() { mCheckedForFragmentLocationLayout = false; }
+
+    /// Returns the entry index of a uniform (interns it if new)
+    int findUniform(UniformName const& name) const;
+    /// Returns the (resolved) entry of a uniform
+    UniformEntry& resolveUniform(UniformName const& name) const;
+    /// Compares 'data' (of 'count' array elements) with the last value of the uniform and saves it
+    /// Returns false if the value is unchanged (i.e. the glUniform call can be skipped)
+    bool updateUniformCache(UniformEntry& entry, void const* data, size_t size, int count) const;
 public: // getter
     GLuint getObjectName() const { return mObjectName; }
     std::vector<SharedShader> const& getShader() const { return mShader; }
@@ -117,6 +151,21 @@ public: // getter
     /// Modifies shader reloading state
     static void setShaderReloading(bool enabled);
 
+    /// Statistics of the uniform value cache (of the current thread)
+    /// Unchanged uniforms and texture units are not re-sent to GL
+    struct UniformStatistics
+    {
+        uint64_t issued = 0;  ///< glUniform calls
+        uint64_t skipped = 0; ///< redundant calls that were skipped
+    };
+    static UniformStatistics getUniformStatistics();
+    static void resetUniformStatistics();
+
+    /// Measures setUniform(float) per call for all kinds of UniformName (std::string, char*, literal, handle)
+    /// and for unchanged values (skipped by the cache), prints ns per call
+    /// Requires a current GL context (a small test program is created), statistics are not affected
+    static void dumpUniformOverhead(std::ostream& oss, size_t calls = 1 << 20);
+
 public:
     /// RAII-object that defines a "use"-scope for a Program
     /// All functions that operate on the currently bound program are accessed here
@@ -130,7 +179,7 @@ public:
     public: // gl functions with use
         /// Binds a texture to a uniform
         /// Automatically chooses a free texture unit starting from 0
-        void setTexture(std::string const& name, SharedTexture const& tex);
+        void setTexture(UniformName const& name, SharedTexture const& tex);
         /// Binds a texture to an image sampler
         /// Requires an explicit binding location in shader (e.g. binding=N layout)
         /// Requires tex->isStorageImmutable()
@@ -141,6 +190,9 @@ public:
         /// Setting by uniform _location_ is explicitly NOT supported because drawing may relink and thus reshuffle
         /// locations. However, locations are internally cached, so the performance hit is not high.
         ///
+        /// 'name' is a UniformName, i.e. a string (literals are hashed at compile time) or
+        /// a UniformHandle from Program::uniform(...) (no lookup at all)
+        ///
         /// Supported variants:
         ///   setUniform(string name, T value)
         ///   setUniform(string name, int count, T* values)
@@ -164,55 +216,55 @@ public:
         /// TODO: make this configurable
 
         /// Generic interface
-        void setUniform(std::string const& name, int count, bool const* values) const;
-        void setUniform(std::string const& name, int count, int32_t const* values) const;
-        void setUniform(std::string const& name, int count, uint32_t const* values) const;
-        void setUniform(std::string const& name, int count, float const* values) const;
-
-        void setUniform(std::string const& name, int count, glm::vec2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::vec3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::vec4 const* values) const;
-        void setUniform(std::string const& name, int count, glm::ivec2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::ivec3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::ivec4 const* values) const;
-        void setUniform(std::string const& name, int count, glm::uvec2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::uvec3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::uvec4 const* values) const;
-        void setUniform(std::string const& name, int count, glm::bvec2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::bvec3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::bvec4 const* values) const;
-
-        void setUniform(std::string const& name, int count, glm::mat2x2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat2x3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat2x4 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat3x2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat3x3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat3x4 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat4x2 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat4x3 const* values) const;
-        void setUniform(std::string const& name, int count, glm::mat4x4 const* values) const;
+        void setUniform(UniformName const& name, int count, bool const* values) const;
+        void setUniform(UniformName const& name, int count, int32_t const* values) const;
+        void setUniform(UniformName const& name, int count, uint32_t const* values) const;
+        void setUniform(UniformName const& name, int count, float const* values) const;
+
+        void setUniform(UniformName const& name, int count, glm::vec2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::vec3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::vec4 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::ivec2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::ivec3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::ivec4 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::uvec2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::uvec3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::uvec4 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::bvec2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::bvec3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::bvec4 const* values) const;
+
+        void setUniform(UniformName const& name, int count, glm::mat2x2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat2x3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat2x4 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat3x2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat3x3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat3x4 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat4x2 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat4x3 const* values) const;
+        void setUniform(UniformName const& name, int count, glm::mat4x4 const* values) const;
 
 /// Convenience interfaces
 #define GLOW_PROGRAM_UNIFORM_API_NO_VEC(TYPE)                                                   \
-    void setUniform(std::string const& name, TYPE value) const { setUniform(name, 1, &value); } \
+    void setUniform(UniformName const& name, TYPE value) const { setUniform(name, 1, &value); } \
     template <std::size_t N>                                                                    \
-    void setUniform(std::string const& name, const TYPE(&data)[N])                              \
+    void setUniform(UniformName const& name, const TYPE(&data)[N])                              \
     {                                                                                           \
         setUniform(name, N, data);                                                              \
     }                                                                                           \
     template <std::size_t N>                                                                    \
-    void setUniform(std::string const& name, std::array<TYPE, N> const& data)                   \
+    void setUniform(UniformName const& name, std::array<TYPE, N> const& data)                   \
     {                                                                                           \
         setUniform(name, N, data.data());                                                       \
     }                                                                                           \
-    void setUniform(std::string const& name, std::initializer_list<TYPE> const& data)           \
+    void setUniform(UniformName const& name, std::initializer_list<TYPE> const& data)           \
     {                                                                                           \
         setUniform(name, data.size(), data.begin());                                            \
     }                                                                                           \
     friend class GLOW_MACRO_JOIN(___prog_uniform_api_no_vec_, __COUNTER__) // enfore ;
 #define GLOW_PROGRAM_UNIFORM_API(TYPE)                                              \
     GLOW_PROGRAM_UNIFORM_API_NO_VEC(TYPE);                                          \
-    void setUniform(std::string const& name, std::vector<TYPE> const& values) const \
+    void setUniform(UniformName const& name, std::vector<TYPE> const& values) const \
     {                                                                               \
         setUniform(name, values.size(), values.data());                             \
     }                                                                               \
@@ -250,7 +302,7 @@ public:
         GLOW_PROGRAM_UNIFORM_API(glm::mat4x4);
 
         /// Special case: vector<bool>
-        void setUniform(std::string const& name, std::vector<bool> const& values) const
+        void setUniform(UniformName const& name, std::vector<bool> const& values) const
         {
             auto cnt = values.size();
             std::vector<int32_t> tmp(cnt);
@@ -263,7 +315,7 @@ public:
         void setUniforms(SharedUniformState const& state);
         /// Sets generic uniform data
         /// CAUTION: bool is assumed as glUniformi (i.e. integer)
-        void setUniform(std::string const& name, GLenum uniformType, GLint size, void const* data);
+        void setUniform(UniformName const& name, GLenum uniformType, GLint size, void const* data);
         /// ========================================== UNIFORMS - END ==========================================
 
 
@@ -279,7 +331,7 @@ public:
 
     private:
         /// Special case: bool uniforms
-        void setUniformBool(std::string const& name, int count, int32_t const* values) const;
+        void setUniformBool(UniformName const& name, int count, int32_t const* values) const;
 
         /// Check for shader reloading
         void checkShaderReload();
@@ -302,8 +354,15 @@ public:
 public: // gl functions without use
     /// Returns the in-shader location of the given uniform name
     /// Is -1 if not found or optimized out (!)
-    /// Uses an internal cache to speedup the call
-    GLint getUniformLocation(std::string const& name) const;
+    /// Uses an internal hash table to speedup the call
+    GLint getUniformLocation(UniformName const& name) const;
+
+    /// Returns a pre-resolved handle for the given uniform name
+    /// Handles are re-resolved automatically on relink
+    /// Usage:
+    ///    auto hColor = prog->uniform("uColor");
+    ///    prog->use().setUniform(hColor, glm::vec3(1, 0, 0));
+    UniformHandle uniform(UniformName const& name) const;
 
     /// Returns the index of a uniform block
     GLuint getUniformBlockIndex(std::string const& name) const;
@@ -328,7 +387,7 @@ public: // gl functions without use
     ///  * mat[234]x[234]
 
     template <typename DataT>
-    DataT getUniform(std::string const& name) const
+    DataT getUniform(UniformName const& name) const
     {
         DataT value;
         auto loc = getUniformLocation(name);
@@ -377,6 +436,10 @@ public:
     /// Binds a uniform buffer to a given block name
     /// DOES NOT REQUIRE PROGRAM USE
     void setUniformBuffer(std::string const& bufferName, SharedUniformBuffer const& buffer);
+    /// Binds a range of a buffer (e.g. a StreamBuffer allocation) to a given block name
+    /// offset must be a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    /// DOES NOT REQUIRE PROGRAM USE
+    void setUniformBuffer(std::string const& bufferName, SharedBuffer const& buffer, GLintptr offset, GLsizeiptr size);
     /// Binds a shader storage buffer to a given block name
     /// DOES NOT REQUIRE PROGRAM USE
     void setShaderStorageBuffer(std::string const& bufferName, SharedShaderStorageBuffer const& buffer);
@@ -1,6 +1,7 @@
 #include "ShaderStorageBuffer.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include <glow/common/runtime_assert.hh>
 #include <glow/common/thread_local.hh>
@@ -84,8 +85,8 @@ void ShaderStorageBuffer::BoundShaderStorageBuffer::reserve(size_t sizeInBytes,
 ShaderStorageBuffer::BoundShaderStorageBuffer::BoundShaderStorageBuffer(ShaderStorageBuffer *buffer) : buffer(buffer)
 {
     checkValidGLOW();
-    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &previousBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->getObjectName());
+    previousBuffer = state::bound(state::Binding::ShaderStorageBuffer);
+    state::bind(state::Binding::ShaderStorageBuffer, buffer->getObjectName());
 
     previousBufferPtr = sCurrentBuffer;
     sCurrentBuffer = this;
@@ -102,7 +103,7 @@ ShaderStorageBuffer::BoundShaderStorageBuffer::~BoundShaderStorageBuffer()
 {
     if (previousBuffer != -1) // if valid
     {
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, previousBuffer);
+        state::bind(state::Binding::ShaderStorageBuffer, previousBuffer);
         sCurrentBuffer = previousBufferPtr;
     }
 }
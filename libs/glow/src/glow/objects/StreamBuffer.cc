@@ -0,0 +1,127 @@
+#include "StreamBuffer.hh"
+
+#include <algorithm>
+
+#include "glow/glow.hh"
+#include "glow/limits.hh"
+#include "glow/state.hh"
+
+#include "glow/common/log.hh"
+
+using namespace glow;
+
+StreamBuffer::StreamBuffer(GLsizeiptr regionSize) : Buffer(GL_ARRAY_BUFFER), mRegionSize(regionSize)
+{
+    checkValidGLOW();
+
+    if (!isSupported())
+    {
+        error() << "StreamBuffer requires OpenGL 4.4 or ARB_buffer_storage (" << OGLVersion.major << "."
+                << OGLVersion.minor << " context). Check StreamBuffer::isSupported() first.";
+        return;
+    }
+
+#if GLOW_OPENGL_VERSION >= 44
+    // regions start at valid UBO offsets
+    auto align = GLsizeiptr(std::max(1, limits::uniformBufferOffsetAlignment));
+    mRegionSize = (mRegionSize + align - 1) / align * align;
+
+    auto flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    auto prevBuffer = state::bound(state::Binding::ArrayBuffer);
+    state::bind(state::Binding::ArrayBuffer, getObjectName());
+    glBufferStorage(GL_ARRAY_BUFFER, mRegionSize * RegionCount, nullptr, flags);
+    mMappedData = static_cast<char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, mRegionSize * RegionCount, flags));
+    state::bind(state::Binding::ArrayBuffer, prevBuffer);
+
+    if (!mMappedData)
+        error() << "Unable to map StreamBuffer storage (" << mRegionSize * RegionCount << " bytes)";
+#endif
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    checkValidGLOW();
+
+    // (storage is unmapped when the buffer is deleted)
+    for (auto &fence : mFences)
+        if (fence)
+            glDeleteSync(fence);
+}
+
+bool StreamBuffer::isSupported()
+{
+#if GLOW_OPENGL_VERSION >= 44
+    // (not loaded if the context is older and lacks ARB_buffer_storage)
+    return glBufferStorage != nullptr;
+#else
+    return false;
+#endif
+}
+
+SharedStreamBuffer StreamBuffer::create(GLsizeiptr regionSize)
+{
+    return std::make_shared<StreamBuffer>(regionSize);
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    if (!mMappedData)
+        return {};
+
+    auto regionStart = mRegion * mRegionSize;
+    auto offset = (regionStart + mRegionOffset + alignment - 1) / alignment * alignment;
+    if (offset + size > regionStart + mRegionSize)
+    {
+        error() << "StreamBuffer region exhausted (requested " << size << " bytes, " << getRemainingSize()
+                << " of " << mRegionSize << " left). Create the buffer with a bigger region size.";
+        return {};
+    }
+
+    mRegionOffset = offset + size - regionStart;
+
+    Allocation a;
+    a.data = mMappedData + offset;
+    a.offset = offset;
+    a.size = size;
+    return a;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocateUniform(GLsizeiptr size)
+{
+    return allocate(size, std::max(1, limits::uniformBufferOffsetAlignment));
+}
+
+void StreamBuffer::nextFrame()
+{
+    checkValidGLOW();
+
+    if (!mMappedData)
+        return;
+
+    // fence all commands that read the current region
+    if (mFences[mRegion])
+        glDeleteSync(mFences[mRegion]);
+    mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    mRegion = (mRegion + 1) % RegionCount;
+    mRegionOffset = 0;
+
+    // wait until the GPU is done with the next region
+    auto &fence = mFences[mRegion];
+    if (!fence)
+        return;
+
+    auto res = glClientWaitSync(fence, 0, 0);
+    if (res == GL_TIMEOUT_EXPIRED)
+    {
+        ++mStallCount;
+        do
+            res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000 * 1000 * 1000); // 1s
+        while (res == GL_TIMEOUT_EXPIRED);
+    }
+    if (res == GL_WAIT_FAILED)
+        error() << "Waiting for StreamBuffer fence failed";
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Buffer.hh"
+
+#include "glow/common/non_copyable.hh"
+#include "glow/common/shared.hh"
+
+#include <cstring>
+#include <vector>
+
+namespace glow
+{
+GLOW_SHARED(class, StreamBuffer);
+
+/**
+ * A persistently mapped ring buffer for per-frame data (dynamic vertices, instances, uniform blocks)
+ *
+ * Storage is allocated once (glBufferStorage) and stays mapped (coherent), i.e. no driver allocations
+ * and no map/unmap per upload. The buffer is split into RegionCount regions, each frame writes into
+ * its own region. Before a region is reused, a fence guarantees that the GPU is done reading it.
+ *
+ * Usage:
+ *   auto stream = StreamBuffer::create(1024 * 1024); // bytes per frame
+ *
+ *   // vertex/instance data: alias as ArrayBuffer (offset 0) and draw with base vertex/instance
+ *   auto ab = ArrayBuffer::createAliased(stream, MyInstance::attributes());
+ *   auto vao = VertexArray::create({quadAB, ab});
+ *   ...
+ *   auto a = stream->upload(instances); // aligned to sizeof(MyInstance)
+ *   vao->bind().draw(instances.size(), a.offset / sizeof(MyInstance));
+ *
+ *   // uniform data
+ *   auto u = stream->uploadUniform(myBlock);
+ *   program->setUniformBuffer("uMyBlock", stream, u.offset, u.size);
+ *
+ *   // after all draw calls of the frame
+ *   stream->nextFrame();
+ *
+ * Allocations are only valid until the next nextFrame()
+ * Requires OpenGL 4.4 or ARB_buffer_storage, check isSupported() and fall back to Buffer::setData otherwise
+ * (on unsupported contexts, all allocations are invalid)
+ */
+class StreamBuffer final : public Buffer
+{
+    GLOW_NON_COPYABLE(StreamBuffer);
+
+public:
+    /// number of regions (frames that may be in flight)
+    static const int RegionCount = 3;
+
+    /// sub-allocation of the current region
+    struct Allocation
+    {
+        void* data = nullptr;  ///< mapped memory (write-only!)
+        GLintptr offset = -1;  ///< offset in the buffer (for VAO base offsets and UBO ranges)
+        GLsizeiptr size = 0;   ///< size in bytes
+
+        bool isValid() const { return data != nullptr; }
+        template <typename DataT>
+        DataT* as() const
+        {
+            return static_cast<DataT*>(data);
+        }
+    };
+
+private:
+    /// size of each region in bytes
+    GLsizeiptr mRegionSize;
+
+    /// persistently mapped storage
+    char* mMappedData = nullptr;
+
+    /// fences of all regions (nullptr if not in use by the GPU)
+    GLsync mFences[RegionCount] = {};
+
+    /// current region
+    int mRegion = 0;
+    /// first free byte in current region
+    GLsizeiptr mRegionOffset = 0;
+
+    /// number of nextFrame() calls that had to wait for the GPU
+    int mStallCount = 0;
+
+public: // getter
+    GLsizeiptr getRegionSize() const { return mRegionSize; }
+    /// remaining bytes in the current region (ignoring alignment)
+    GLsizeiptr getRemainingSize() const { return mRegionSize - mRegionOffset; }
+    int getStallCount() const { return mStallCount; }
+
+public:
+    /// Reserves a chunk of 'size' bytes in the current region
+    /// The offset is a multiple of 'alignment' (which need not be a power of two)
+    /// Returns an invalid allocation (and reports an error) if the region is exhausted
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 1);
+    /// Same as allocate(...) but aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...)
+    Allocation allocateUniform(GLsizeiptr size);
+
+    /// Allocates and copies a vector of POD (offset is a multiple of sizeof(DataT))
+    template <typename DataT>
+    Allocation upload(std::vector<DataT> const& data)
+    {
+        auto a = allocate(data.size() * sizeof(DataT), sizeof(DataT));
+        if (a.isValid())
+            std::memcpy(a.data, data.data(), a.size);
+        return a;
+    }
+    /// Allocates and copies a POD uniform block (e.g. std140 structs)
+    template <typename DataT>
+    Allocation uploadUniform(DataT const& data)
+    {
+        auto a = allocateUniform(sizeof(DataT));
+        if (a.isValid())
+            std::memcpy(a.data, &data, sizeof(DataT));
+        return a;
+    }
+
+    /// Finishes the current region (call after all draw calls using its allocations)
+    /// Waits until the GPU is done with the next region (only stalls if the GPU is RegionCount frames behind)
+    void nextFrame();
+
+public:
+    StreamBuffer(GLsizeiptr regionSize);
+    ~StreamBuffer();
+
+public: // static construction
+    /// true iff the current context supports persistently mapped buffers (OpenGL 4.4 or ARB_buffer_storage)
+    static bool isSupported();
+
+    /// Creates a stream buffer with 'regionSize' bytes per frame
+    static SharedStreamBuffer create(GLsizeiptr regionSize);
+};
+}
@@ -1,6 +1,7 @@
 #include "Texture.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 
 #include <limits>
 #include <cassert>
@@ -16,15 +17,16 @@ Texture::Texture(GLenum target, GLenum bindingTarget, GLenum internalFormat)
     glGenTextures(1, &mObjectName);
     assert(mObjectName != std::numeric_limits<decltype(mObjectName)>::max() && "No OpenGL Context?");
 
-    GLint oldTex;
-    glGetIntegerv(mBindingTarget, &oldTex);
-    glBindTexture(mTarget, mObjectName); // pin this texture to the correct type
-    glBindTexture(mTarget, oldTex);      // restore prev
+    auto unit = state::scratchTextureUnit();
+    auto oldTex = state::boundTexture(unit, mTarget);
+    state::bindTexture(unit, mTarget, mObjectName); // pin this texture to the correct type
+    state::bindTexture(unit, mTarget, oldTex);      // restore prev
 }
 
 Texture::~Texture()
 {
     checkValidGLOW();
 
+    state::forgetTexture(mObjectName);
     glDeleteTextures(1, &mObjectName);
 }
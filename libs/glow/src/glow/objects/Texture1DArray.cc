@@ -8,6 +8,7 @@
 
 #include "glow/glow.hh"
 #include "glow/limits.hh"
+#include "glow/state.hh"
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/ogl_typeinfo.hh"
 #include "glow/common/scoped_gl.hh"
@@ -491,9 +492,10 @@ void Texture1DArray::BoundTexture1DArray::writeToFile(const std::string &filenam
 Texture1DArray::BoundTexture1DArray::BoundTexture1DArray (Texture1DArray *texture) : texture(texture)
 {
     checkValidGLOW();
-    glGetIntegerv(texture->mBindingTarget, &previousTexture);
-    glActiveTexture(GL_TEXTURE0 + limits::maxCombinedTextureImageUnits - 1);
-    glBindTexture(texture->mTarget, texture->mObjectName);
+    auto unit = state::scratchTextureUnit();
+    previousTexture = state::boundTexture(unit, texture->mTarget);
+    state::bindTexture(unit, texture->mTarget, texture->mObjectName);
+    state::activeTexture(unit); // (bind may be skipped)
 
     previousTexturePtr = sCurrentTexture;
     sCurrentTexture = this;
@@ -511,8 +513,7 @@ Texture1DArray::BoundTexture1DArray::~BoundTexture1DArray ()
     if (previousTexture != -1) // if valid
     {
         checkValidGLOW();
-        glActiveTexture(GL_TEXTURE0 + limits::maxCombinedTextureImageUnits - 1);
-        glBindTexture(texture->mTarget, previousTexture);
+        state::bindTexture(state::scratchTextureUnit(), texture->mTarget, previousTexture);
         sCurrentTexture = previousTexturePtr;
     }
 }
@@ -8,6 +8,7 @@
 
 #include "glow/glow.hh"
 #include "glow/limits.hh"
+#include "glow/state.hh"
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/ogl_typeinfo.hh"
 #include "glow/common/scoped_gl.hh"
@@ -504,9 +505,10 @@ void Texture2D::BoundTexture2D::writeToFile(const std::string &filename)
 Texture2D::BoundTexture2D::BoundTexture2D (Texture2D *texture) : texture(texture)
 {
     checkValidGLOW();
-    glGetIntegerv(texture->mBindingTarget, &previousTexture);
-    glActiveTexture(GL_TEXTURE0 + limits::maxCombinedTextureImageUnits - 1);
-    glBindTexture(texture->mTarget, texture->mObjectName);
+    auto unit = state::scratchTextureUnit();
+    previousTexture = state::boundTexture(unit, texture->mTarget);
+    state::bindTexture(unit, texture->mTarget, texture->mObjectName);
+    state::activeTexture(unit); // (bind may be skipped)
 
     previousTexturePtr = sCurrentTexture;
     sCurrentTexture = this;
@@ -524,8 +526,7 @@ Texture2D::BoundTexture2D::~BoundTexture2D ()
     if (previousTexture != -1) // if valid
     {
         checkValidGLOW();
-        glActiveTexture(GL_TEXTURE0 + limits::maxCombinedTextureImageUnits - 1);
-        glBindTexture(texture->mTarget, previousTexture);
+        state::bindTexture(state::scratchTextureUnit(), texture->mTarget, previousTexture);
         sCurrentTexture = previousTexturePtr;
     }
 }
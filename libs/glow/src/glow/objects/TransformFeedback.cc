@@ -1,6 +1,7 @@
 #include "TransformFeedback.hh"
 
 #include "glow/glow.hh"
+#include "glow/state.hh"
 #include "glow/common/log.hh"
 
 #include <glow/common/runtime_assert.hh>
@@ -35,6 +36,7 @@ TransformFeedback::~TransformFeedback()
 {
     checkValidGLOW();
 
+    state::forgetTransformFeedback(mObjectName);
     glDeleteTransformFeedbacks(1, &mObjectName);
 }
 
@@ -87,8 +89,8 @@ void TransformFeedback::BoundTransformFeedback::end()
 TransformFeedback::BoundTransformFeedback::BoundTransformFeedback(TransformFeedback *feedback) : feedback(feedback)
 {
     checkValidGLOW();
-    glGetIntegerv(GL_TRANSFORM_FEEDBACK_BINDING, &previousFeedback);
-    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedback->getObjectName());
+    previousFeedback = state::bound(state::Binding::TransformFeedback);
+    state::bind(state::Binding::TransformFeedback, feedback->getObjectName());
 
     previousFeedbackPtr = sCurrentFeedback;
     sCurrentFeedback = this;
@@ -112,7 +114,7 @@ TransformFeedback::BoundTransformFeedback::~BoundTransformFeedback()
 {
     if (previousFeedback != -1) // if valid
     {
-        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, previousFeedback);
+        state::bind(state::Binding::TransformFeedback, previousFeedback);
         sCurrentFeedback = previousFeedbackPtr;
     }
 }
@@ -1,6 +1,7 @@
 #include "UniformBuffer.hh"
 
 #include <glow/glow.hh>
+#include <glow/state.hh>
 
 #include <glow/common/runtime_assert.hh>
 #include <glow/common/thread_local.hh>
@@ -47,8 +48,8 @@ void UniformBuffer::BoundUniformBuffer::setData(size_t size, const void *data, G
 UniformBuffer::BoundUniformBuffer::BoundUniformBuffer(UniformBuffer *buffer) : buffer(buffer)
 {
     checkValidGLOW();
-    glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &previousBuffer);
-    glBindBuffer(GL_UNIFORM_BUFFER, buffer->getObjectName());
+    previousBuffer = state::bound(state::Binding::UniformBuffer);
+    state::bind(state::Binding::UniformBuffer, buffer->getObjectName());
 
     previousBufferPtr = sCurrentBuffer;
     sCurrentBuffer = this;
@@ -65,7 +66,7 @@ UniformBuffer::BoundUniformBuffer::~BoundUniformBuffer()
 {
     if (previousBuffer != -1) // if valid
     {
-        glBindBuffer(GL_UNIFORM_BUFFER, previousBuffer);
+        state::bind(state::Binding::UniformBuffer, previousBuffer);
         sCurrentBuffer = previousBufferPtr;
     }
 }
@@ -14,6 +14,7 @@
 #include "glow/common/runtime_assert.hh"
 #include "glow/common/thread_local.hh"
 #include "glow/glow.hh"
+#include "glow/state.hh"
 #include "glow/util/LocationMapping.hh"
 #include "glow/util/UniformState.hh"
 
@@ -40,6 +41,7 @@ VertexArray::VertexArray(GLenum primitiveMode) : mPrimitiveMode(primitiveMode)
 VertexArray::~VertexArray()
 {
     checkValidGLOW();
+    state::forgetVertexArray(mObjectName);
     glDeleteVertexArrays(1, &mObjectName);
 }
 
@@ -74,7 +76,7 @@ SharedVertexArray VertexArray::create(const std::vector<SharedArrayBuffer> &abs,
     return vao;
 }
 
-void VertexArray::BoundVertexArray::draw(GLsizei instanceCount)
+void VertexArray::BoundVertexArray::draw(GLsizei instanceCount, GLuint baseInstance)
 {
     if (!isCurrent())
         return;
@@ -86,8 +88,7 @@ void VertexArray::BoundVertexArray::draw(GLsizei instanceCount)
     if (vao->mElementArrayBuffer)
     {
         // draw indexed
-        glDrawElementsInstanced(vao->mPrimitiveMode, vao->mElementArrayBuffer->getIndexCount(),
-                                vao->mElementArrayBuffer->getIndexType(), nullptr, instanceCount);
+        drawElements(vao->mElementArrayBuffer->getIndexCount(), nullptr, instanceCount, baseInstance);
     }
     else
     {
@@ -101,11 +102,11 @@ void VertexArray::BoundVertexArray::draw(GLsizei instanceCount)
             }
 
         // draw unindexed
-        glDrawArraysInstanced(vao->mPrimitiveMode, 0, vCount, instanceCount);
+        drawArrays(0, vCount, instanceCount, baseInstance);
     }
 }
 
-void VertexArray::BoundVertexArray::drawRange(GLsizei start, GLsizei end, GLsizei instanceCount)
+void VertexArray::BoundVertexArray::drawRange(GLsizei start, GLsizei end, GLsizei instanceCount, GLuint baseInstance)
 {
     if (!isCurrent())
         return;
@@ -135,16 +136,58 @@ void VertexArray::BoundVertexArray::drawRange(GLsizei start, GLsizei end, GLsize
             return;
         }
 
-        glDrawElementsInstanced(vao->mPrimitiveMode, end - start, vao->mElementArrayBuffer->getIndexType(),
-                                (void *)(start * indexSize), instanceCount);
+        drawElements(end - start, (void *)(start * indexSize), instanceCount, baseInstance);
     }
     else
     {
         // draw unindexed
-        glDrawArraysInstanced(vao->mPrimitiveMode, start, end - start, instanceCount);
+        drawArrays(start, end - start, instanceCount, baseInstance);
     }
 }
 
+bool VertexArray::isBaseInstanceSupported()
+{
+#if GLOW_OPENGL_VERSION >= 42
+    // (not loaded if the context is older and lacks ARB_base_instance)
+    return glDrawArraysInstancedBaseInstance != nullptr && glDrawElementsInstancedBaseInstance != nullptr;
+#else
+    return false;
+#endif
+}
+
+void VertexArray::BoundVertexArray::drawArrays(GLint first, GLsizei count, GLsizei instanceCount, GLuint baseInstance)
+{
+    if (baseInstance == 0)
+    {
+        glDrawArraysInstanced(vao->mPrimitiveMode, first, count, instanceCount);
+        return;
+    }
+
+#if GLOW_OPENGL_VERSION >= 42
+    GLOW_RUNTIME_ASSERT(isBaseInstanceSupported(), "Drawing with a base instance requires OpenGL 4.2 or ARB_base_instance", return );
+    glDrawArraysInstancedBaseInstance(vao->mPrimitiveMode, first, count, instanceCount, baseInstance);
+#else
+    error() << "Drawing with a base instance is only supported in OpenGL 4.2+";
+#endif
+}
+
+void VertexArray::BoundVertexArray::drawElements(GLsizei count, const void *indices, GLsizei instanceCount, GLuint baseInstance)
+{
+    auto type = vao->mElementArrayBuffer->getIndexType();
+    if (baseInstance == 0)
+    {
+        glDrawElementsInstanced(vao->mPrimitiveMode, count, type, indices, instanceCount);
+        return;
+    }
+
+#if GLOW_OPENGL_VERSION >= 42
+    GLOW_RUNTIME_ASSERT(isBaseInstanceSupported(), "Drawing with a base instance requires OpenGL 4.2 or ARB_base_instance", return );
+    glDrawElementsInstancedBaseInstance(vao->mPrimitiveMode, count, type, indices, instanceCount, baseInstance);
+#else
+    error() << "Drawing with a base instance is only supported in OpenGL 4.2+";
+#endif
+}
+
 void VertexArray::BoundVertexArray::drawTransformFeedback(const SharedTransformFeedback &feedback)
 {
     if (!isCurrent())
@@ -166,7 +209,7 @@ void VertexArray::BoundVertexArray::attach(const SharedElementArrayBuffer &eab)
 
     checkValidGLOW();
     vao->mElementArrayBuffer = eab;
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eab ? eab->getObjectName() : 0);
+    state::bind(state::Binding::ElementArrayBuffer, eab ? eab->getObjectName() : 0);
 }
 
 void VertexArray::attachAttribute(const VertexArrayAttribute &va)
@@ -357,9 +400,9 @@ VertexArray::BoundVertexArray::BoundVertexArray(VertexArray *vao) : vao(vao)
     GLOW_RUNTIME_ASSERT(ElementArrayBuffer::getCurrentBuffer() == nullptr,
                         "Cannot bind a VAO while an EAB is bound! (this has unintended side-effects in OpenGL)", return );
 
-    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVAO);
-    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &previousEAB);
-    glBindVertexArray(vao->mObjectName);
+    // (the EAB binding is part of the VAO and restored with it)
+    previousVAO = state::bound(state::Binding::VertexArray);
+    state::bind(state::Binding::VertexArray, vao->mObjectName);
 
     previousVaoPtr = sCurrentVAO;
     sCurrentVAO = this;
@@ -372,7 +415,7 @@ bool VertexArray::BoundVertexArray::isCurrent() const
 }
 
 VertexArray::BoundVertexArray::BoundVertexArray(VertexArray::BoundVertexArray &&rhs)
-  : vao(rhs.vao), previousVAO(rhs.previousVAO), previousEAB(rhs.previousEAB), previousVaoPtr(rhs.previousVaoPtr)
+  : vao(rhs.vao), previousVAO(rhs.previousVAO), previousVaoPtr(rhs.previousVaoPtr)
 {
     // invalidate rhs
     rhs.previousVAO = -1;
@@ -383,8 +426,7 @@ VertexArray::BoundVertexArray::~BoundVertexArray()
     if (previousVAO != -1) // if valid
     {
         checkValidGLOW();
-        glBindVertexArray(previousVAO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, previousEAB);
+        state::bind(state::Binding::VertexArray, previousVAO);
         sCurrentVAO = previousVaoPtr;
     }
 }
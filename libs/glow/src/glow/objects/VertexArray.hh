@@ -65,6 +65,8 @@ public:
 public:
     /// Gets the currently bound VAO (nullptr if none)
     static BoundVertexArray* getCurrentVAO();
+    /// true iff draw(..., baseInstance > 0) is supported by the current context (OpenGL 4.2 or ARB_base_instance)
+    static bool isBaseInstanceSupported();
 
 public:
     /// RAII-object that defines a "bind"-scope for a VertexArray
@@ -83,9 +85,10 @@ public:
         /// Uses the first divisor-0 array buffer to determine number of primitives
         /// Negotiates location mappings IF current program != nullptr
         /// If instanceCount is negative, getInstanceCount() is used.
-        void draw(GLsizei instanceCount = -1);
+        /// baseInstance offsets all instanced (divisor > 0) attributes (e.g. StreamBuffer allocations)
+        void draw(GLsizei instanceCount = -1, GLuint baseInstance = 0);
         /// Same as draw(...) but only renders a subrange of indices or vertices
-        void drawRange(GLsizei start, GLsizei end, GLsizei instanceCount = -1);
+        void drawRange(GLsizei start, GLsizei end, GLsizei instanceCount = -1, GLuint baseInstance = 0);
         /// Same as draw(...) but takes the number of vertices from a recorded transform feedback object
         /// NOTE: does not work with index buffers or instancing
         void drawTransformFeedback(SharedTransformFeedback const& feedback);
@@ -115,11 +118,14 @@ public:
 
     private:
         GLint previousVAO;                ///< previously used vao
-        GLint previousEAB;                ///< previously used eab
         BoundVertexArray* previousVaoPtr; ///< previously used vao
         BoundVertexArray(VertexArray* vao);
         friend class VertexArray;
 
+        /// glDraw*Instanced, uses the BaseInstance variants if necessary
+        void drawArrays(GLint first, GLsizei count, GLsizei instanceCount, GLuint baseInstance);
+        void drawElements(GLsizei count, void const* indices, GLsizei instanceCount, GLuint baseInstance);
+
         /// returns true iff it's safe to use this bound class
         /// otherwise, runtime error
         bool isCurrent() const;
@@ -0,0 +1,522 @@
+#include "state.hh"
+
+#include <cassert>
+#include <initializer_list>
+#include <vector>
+
+#include "glow.hh"
+#include "limits.hh"
+
+#include "common/log.hh"
+#include "common/thread_local.hh"
+
+using namespace glow;
+
+namespace
+{
+/// not yet known (queried on first read)
+const GLuint Unknown = ~0u;
+
+/// texture targets (index into texture shadow)
+const GLenum sTextureTargets[] = {
+    GL_TEXTURE_1D,                   //
+    GL_TEXTURE_1D_ARRAY,             //
+    GL_TEXTURE_2D,                   //
+    GL_TEXTURE_2D_ARRAY,             //
+    GL_TEXTURE_2D_MULTISAMPLE,       //
+    GL_TEXTURE_2D_MULTISAMPLE_ARRAY, //
+    GL_TEXTURE_3D,                   //
+    GL_TEXTURE_CUBE_MAP,             //
+    GL_TEXTURE_CUBE_MAP_ARRAY,       //
+    GL_TEXTURE_RECTANGLE,            //
+    GL_TEXTURE_BUFFER,               //
+};
+const GLenum sTextureBindings[] = {
+    GL_TEXTURE_BINDING_1D,                   //
+    GL_TEXTURE_BINDING_1D_ARRAY,             //
+    GL_TEXTURE_BINDING_2D,                   //
+    GL_TEXTURE_BINDING_2D_ARRAY,             //
+    GL_TEXTURE_BINDING_2D_MULTISAMPLE,       //
+    GL_TEXTURE_BINDING_2D_MULTISAMPLE_ARRAY, //
+    GL_TEXTURE_BINDING_3D,                   //
+    GL_TEXTURE_BINDING_CUBE_MAP,             //
+    GL_TEXTURE_BINDING_CUBE_MAP_ARRAY,       //
+    GL_TEXTURE_BINDING_RECTANGLE,            //
+    GL_TEXTURE_BINDING_BUFFER,               //
+};
+const int sTextureTargetCount = sizeof(sTextureTargets) / sizeof(sTextureTargets[0]);
+
+/// indexed buffer targets
+const GLenum sIndexedTargets[] = {GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_ATOMIC_COUNTER_BUFFER};
+const state::Binding sIndexedGeneric[] = {state::Binding::UniformBuffer, state::Binding::ShaderStorageBuffer,
+                                          state::Binding::AtomicCounterBuffer};
+const int sIndexedTargetCount = sizeof(sIndexedTargets) / sizeof(sIndexedTargets[0]);
+
+struct State
+{
+    GLuint bindings[(int)state::Binding::Count];
+    int activeUnit = -1; // -1: unknown
+    std::vector<GLuint> textures; // unit * sTextureTargetCount + target
+    std::vector<GLuint> indexed[sIndexedTargetCount];
+
+    bool validate = false;
+    state::Statistics stats;
+
+    State() { invalidate(); }
+
+    void invalidate()
+    {
+        for (auto &b : bindings)
+            b = Unknown;
+        activeUnit = -1;
+        textures.assign(textures.size(), Unknown);
+        for (auto &v : indexed)
+            v.assign(v.size(), Unknown);
+    }
+};
+
+int indexedTargetIndex(GLenum target)
+{
+    auto t = 0;
+    while (t < sIndexedTargetCount && sIndexedTargets[t] != target)
+        ++t;
+    assert(t < sIndexedTargetCount && "unsupported indexed target");
+    return t;
+}
+
+/// shadow of the current thread (allocated on first use)
+GLOW_THREADLOCAL State *sState = nullptr;
+
+State &getState()
+{
+    if (!sState)
+        sState = new State;
+    return *sState;
+}
+
+GLenum queryName(state::Binding b)
+{
+    switch (b)
+    {
+    case state::Binding::Program:
+        return GL_CURRENT_PROGRAM;
+    case state::Binding::VertexArray:
+        return GL_VERTEX_ARRAY_BINDING;
+    case state::Binding::ArrayBuffer:
+        return GL_ARRAY_BUFFER_BINDING;
+    case state::Binding::ElementArrayBuffer:
+        return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+    case state::Binding::UniformBuffer:
+        return GL_UNIFORM_BUFFER_BINDING;
+    case state::Binding::ShaderStorageBuffer:
+        return GL_SHADER_STORAGE_BUFFER_BINDING;
+    case state::Binding::AtomicCounterBuffer:
+        return GL_ATOMIC_COUNTER_BUFFER_BINDING;
+    case state::Binding::TransformFeedback:
+        return GL_TRANSFORM_FEEDBACK_BINDING;
+    case state::Binding::DrawFramebuffer:
+        return GL_DRAW_FRAMEBUFFER_BINDING;
+    case state::Binding::ReadFramebuffer:
+        return GL_READ_FRAMEBUFFER_BINDING;
+    default:
+        assert(0 && "unknown binding");
+        return GL_INVALID_ENUM;
+    }
+}
+
+#ifdef GLOW_DEBUG
+const char *bindingToString(state::Binding b)
+{
+    switch (b)
+    {
+    case state::Binding::Program:
+        return "Program";
+    case state::Binding::VertexArray:
+        return "VertexArray";
+    case state::Binding::ArrayBuffer:
+        return "ArrayBuffer";
+    case state::Binding::ElementArrayBuffer:
+        return "ElementArrayBuffer";
+    case state::Binding::UniformBuffer:
+        return "UniformBuffer";
+    case state::Binding::ShaderStorageBuffer:
+        return "ShaderStorageBuffer";
+    case state::Binding::AtomicCounterBuffer:
+        return "AtomicCounterBuffer";
+    case state::Binding::TransformFeedback:
+        return "TransformFeedback";
+    case state::Binding::DrawFramebuffer:
+        return "DrawFramebuffer";
+    case state::Binding::ReadFramebuffer:
+        return "ReadFramebuffer";
+    default:
+        return "<unknown>";
+    }
+}
+#endif
+
+void issueBind(state::Binding b, GLuint name)
+{
+    switch (b)
+    {
+    case state::Binding::Program:
+        glUseProgram(name);
+        break;
+    case state::Binding::VertexArray:
+        glBindVertexArray(name);
+        break;
+    case state::Binding::ArrayBuffer:
+        glBindBuffer(GL_ARRAY_BUFFER, name);
+        break;
+    case state::Binding::ElementArrayBuffer:
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, name);
+        break;
+    case state::Binding::UniformBuffer:
+        glBindBuffer(GL_UNIFORM_BUFFER, name);
+        break;
+    case state::Binding::ShaderStorageBuffer:
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, name);
+        break;
+    case state::Binding::AtomicCounterBuffer:
+        glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, name);
+        break;
+    case state::Binding::TransformFeedback:
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, name);
+        break;
+    case state::Binding::DrawFramebuffer:
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, name);
+        break;
+    case state::Binding::ReadFramebuffer:
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, name);
+        break;
+    default:
+        assert(0 && "unknown binding");
+        break;
+    }
+}
+
+int textureTargetIndex(GLenum target)
+{
+    for (auto i = 0; i < sTextureTargetCount; ++i)
+        if (sTextureTargets[i] == target)
+            return i;
+
+    assert(0 && "unknown texture target");
+    return 0;
+}
+
+GLuint query(State &s, GLenum pname)
+{
+    ++s.stats.queries;
+    GLint val = 0;
+    glGetIntegerv(pname, &val);
+    return (GLuint)val;
+}
+
+/// returns the shadow entry for a texture binding (grows lazily)
+GLuint &textureEntry(State &s, int unit, GLenum target)
+{
+    assert(unit >= 0 && unit < limits::maxCombinedTextureImageUnits && "invalid texture unit");
+    auto minSize = (size_t)(unit + 1) * sTextureTargetCount;
+    if (s.textures.size() < minSize)
+        s.textures.resize(minSize, Unknown);
+    return s.textures[unit * sTextureTargetCount + textureTargetIndex(target)];
+}
+
+/// returns the real GL value (validation) and reports mismatches
+GLuint validated(State &s, GLenum pname, GLuint shadow, const char *what)
+{
+    auto real = query(s, pname);
+    if (real != shadow)
+        error() << "GL state shadow mismatch for " << what << ": shadow is " << shadow << " but GL has " << real
+                << " (missing state::invalidate() after external GL code?)";
+    return real;
+}
+}
+
+GLuint state::bound(Binding b)
+{
+    checkValidGLOW();
+    auto &s = getState();
+    auto &v = s.bindings[(int)b];
+
+    if (v == Unknown)
+        v = query(s, queryName(b));
+#ifdef GLOW_DEBUG
+    else if (s.validate)
+        v = validated(s, queryName(b), v, bindingToString(b));
+#endif
+
+    return v;
+}
+
+void state::bind(Binding b, GLuint name)
+{
+    checkValidGLOW();
+    auto &s = getState();
+    auto &v = s.bindings[(int)b];
+
+#ifdef GLOW_DEBUG
+    if (s.validate && v == name)
+        v = validated(s, queryName(b), v, bindingToString(b));
+#endif
+
+    if (v == name)
+    {
+        ++s.stats.skipped;
+        return;
+    }
+
+    v = name;
+    issueBind(b, name);
+    ++s.stats.issued;
+
+    // element array buffer binding is part of the VAO
+    if (b == Binding::VertexArray)
+        s.bindings[(int)Binding::ElementArrayBuffer] = Unknown;
+}
+
+void state::bindFramebuffer(GLuint name)
+{
+    checkValidGLOW();
+    auto &s = getState();
+    auto &draw = s.bindings[(int)Binding::DrawFramebuffer];
+    auto &read = s.bindings[(int)Binding::ReadFramebuffer];
+
+#ifdef GLOW_DEBUG
+    if (s.validate && draw == name && read == name)
+    {
+        draw = validated(s, GL_DRAW_FRAMEBUFFER_BINDING, draw, "DrawFramebuffer");
+        read = validated(s, GL_READ_FRAMEBUFFER_BINDING, read, "ReadFramebuffer");
+    }
+#endif
+
+    if (draw == name && read == name)
+    {
+        ++s.stats.skipped;
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, name);
+    ++s.stats.issued;
+    draw = name;
+    read = name;
+}
+
+int state::activeTextureUnit()
+{
+    checkValidGLOW();
+    auto &s = getState();
+
+    if (s.activeUnit < 0)
+        s.activeUnit = (int)(query(s, GL_ACTIVE_TEXTURE) - GL_TEXTURE0);
+#ifdef GLOW_DEBUG
+    else if (s.validate)
+        s.activeUnit = (int)(validated(s, GL_ACTIVE_TEXTURE, GL_TEXTURE0 + s.activeUnit, "ActiveTexture") - GL_TEXTURE0);
+#endif
+
+    return s.activeUnit;
+}
+
+void state::activeTexture(int unit)
+{
+    checkValidGLOW();
+    auto &s = getState();
+
+#ifdef GLOW_DEBUG
+    if (s.validate && s.activeUnit == unit)
+        s.activeUnit = (int)(validated(s, GL_ACTIVE_TEXTURE, GL_TEXTURE0 + s.activeUnit, "ActiveTexture") - GL_TEXTURE0);
+#endif
+
+    if (s.activeUnit == unit)
+    {
+        ++s.stats.skipped;
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    ++s.stats.issued;
+    s.activeUnit = unit;
+}
+
+GLuint state::boundTexture(int unit, GLenum target)
+{
+    checkValidGLOW();
+    auto &s = getState();
+    auto &v = textureEntry(s, unit, target);
+
+    auto needsQuery = v == Unknown;
+#ifdef GLOW_DEBUG
+    needsQuery |= s.validate;
+#endif
+
+    if (needsQuery)
+    {
+        activeTexture(unit);
+        auto pname = sTextureBindings[textureTargetIndex(target)];
+        v = v == Unknown ? query(s, pname) : validated(s, pname, v, "Texture");
+    }
+
+    return v;
+}
+
+void state::bindTexture(int unit, GLenum target, GLuint name)
+{
+    checkValidGLOW();
+    auto &s = getState();
+    auto &v = textureEntry(s, unit, target);
+
+#ifdef GLOW_DEBUG
+    if (s.validate && v == name)
+    {
+        activeTexture(unit);
+        v = validated(s, sTextureBindings[textureTargetIndex(target)], v, "Texture");
+    }
+#endif
+
+    if (v == name)
+    {
+        ++s.stats.skipped;
+        return;
+    }
+
+    activeTexture(unit);
+    glBindTexture(target, name);
+    ++s.stats.issued;
+    v = name;
+}
+
+int state::scratchTextureUnit()
+{
+    return limits::maxCombinedTextureImageUnits - 1;
+}
+
+void state::bindBufferBase(GLenum target, GLuint index, GLuint name)
+{
+    checkValidGLOW();
+    auto &s = getState();
+
+    auto t = indexedTargetIndex(target);
+    auto &indexed = s.indexed[t];
+    if (indexed.size() <= index)
+        indexed.resize(index + 1, Unknown);
+
+    // (indexed bindings are not validated, glGetIntegeri_v is rarely the culprit)
+    if (indexed[index] == name && s.bindings[(int)sIndexedGeneric[t]] == name)
+    {
+        ++s.stats.skipped;
+        return;
+    }
+
+    glBindBufferBase(target, index, name);
+    ++s.stats.issued;
+    indexed[index] = name;
+    s.bindings[(int)sIndexedGeneric[t]] = name;
+}
+
+void state::bindBufferRange(GLenum target, GLuint index, GLuint name, GLintptr offset, GLsizeiptr size)
+{
+    checkValidGLOW();
+    auto &s = getState();
+
+    auto t = indexedTargetIndex(target);
+    auto &indexed = s.indexed[t];
+    if (indexed.size() <= index)
+        indexed.resize(index + 1, Unknown);
+
+    // ranges are never skipped (they typically change with every call)
+    glBindBufferRange(target, index, name, offset, size);
+    ++s.stats.issued;
+    indexed[index] = Unknown; // (shadow only tracks whole-buffer bindings)
+    s.bindings[(int)sIndexedGeneric[t]] = name;
+}
+
+void state::forgetBuffer(GLuint name)
+{
+    if (!sState)
+        return;
+
+    // GL reverts bindings of deleted objects to 0
+    auto &s = *sState;
+    for (auto b : {Binding::ArrayBuffer, Binding::ElementArrayBuffer, Binding::UniformBuffer,
+                   Binding::ShaderStorageBuffer, Binding::AtomicCounterBuffer})
+        if (s.bindings[(int)b] == name)
+            s.bindings[(int)b] = 0;
+    for (auto &v : s.indexed)
+        for (auto &i : v)
+            if (i == name)
+                i = 0;
+}
+
+void state::forgetTexture(GLuint name)
+{
+    if (!sState)
+        return;
+
+    for (auto &t : sState->textures)
+        if (t == name)
+            t = 0;
+}
+
+void state::forgetVertexArray(GLuint name)
+{
+    if (!sState)
+        return;
+
+    auto &s = *sState;
+    if (s.bindings[(int)Binding::VertexArray] == name)
+    {
+        s.bindings[(int)Binding::VertexArray] = 0;
+        s.bindings[(int)Binding::ElementArrayBuffer] = Unknown;
+    }
+}
+
+void state::forgetFramebuffer(GLuint name)
+{
+    if (!sState)
+        return;
+
+    for (auto b : {Binding::DrawFramebuffer, Binding::ReadFramebuffer})
+        if (sState->bindings[(int)b] == name)
+            sState->bindings[(int)b] = 0;
+}
+
+void state::forgetTransformFeedback(GLuint name)
+{
+    if (!sState)
+        return;
+
+    if (sState->bindings[(int)Binding::TransformFeedback] == name)
+        sState->bindings[(int)Binding::TransformFeedback] = 0;
+}
+
+void state::invalidate()
+{
+    if (sState)
+        sState->invalidate();
+}
+
+void state::setValidation(bool enabled)
+{
+#ifndef GLOW_DEBUG
+    if (enabled)
+        warning() << "GL state validation is only available in debug builds";
+#endif
+    getState().validate = enabled;
+}
+
+bool state::isValidationEnabled()
+{
+    return sState && sState->validate;
+}
+
+state::Statistics state::getStatistics()
+{
+    return sState ? sState->stats : Statistics();
+}
+
+void state::resetStatistics()
+{
+    if (sState)
+        sState->stats = Statistics();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gl.hh"
+
+namespace glow
+{
+/**
+ * @brief Client-side shadow of the GL binding state
+ *
+ * All glow bind scopes go through this namespace:
+ *   - previous bindings are read from the shadow instead of glGet (no driver round-trip)
+ *   - redundant binds are skipped
+ *
+ * The shadow is per thread (i.e. per context, see checkValidGLOW).
+ * Unknown entries are queried lazily (once) from GL.
+ *
+ * CAUTION: code that changes bindings behind glow's back (raw GL, other libraries)
+ *          must call state::invalidate() afterwards
+ */
+namespace state
+{
+/// shadowed (non-indexed) binding points
+enum class Binding
+{
+    Program,
+    VertexArray,
+    ArrayBuffer,
+    ElementArrayBuffer, ///< (part of the VAO state, unknown after VAO changes)
+    UniformBuffer,
+    ShaderStorageBuffer,
+    AtomicCounterBuffer,
+    TransformFeedback,
+    DrawFramebuffer,
+    ReadFramebuffer,
+
+    Count
+};
+
+/// returns the object currently bound to 'b'
+GLuint bound(Binding b);
+/// binds 'name' to 'b' (skipped if already bound)
+void bind(Binding b, GLuint name);
+/// binds 'name' to GL_FRAMEBUFFER (draw and read)
+void bindFramebuffer(GLuint name);
+
+/// returns the active texture unit (0-based, i.e. without GL_TEXTURE0)
+int activeTextureUnit();
+/// activates a texture unit (0-based, skipped if already active)
+void activeTexture(int unit);
+/// returns the texture bound to 'target' on 'unit'
+GLuint boundTexture(int unit, GLenum target);
+/// binds 'name' to 'target' on 'unit' (activates the unit only if necessary)
+void bindTexture(int unit, GLenum target, GLuint name);
+/// texture unit used by texture bind scopes (last unit, not used by Program::setTexture)
+int scratchTextureUnit();
+
+/// glBindBufferBase for GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, and GL_ATOMIC_COUNTER_BUFFER
+/// (also sets the generic binding)
+void bindBufferBase(GLenum target, GLuint index, GLuint name);
+/// glBindBufferRange for the same targets (never skipped, the indexed binding becomes unknown)
+void bindBufferRange(GLenum target, GLuint index, GLuint name, GLintptr offset, GLsizeiptr size);
+
+/// must be called when deleting objects (GL unbinds them and reuses their names)
+void forgetBuffer(GLuint name);
+void forgetTexture(GLuint name);
+void forgetVertexArray(GLuint name);
+void forgetFramebuffer(GLuint name);
+void forgetTransformFeedback(GLuint name);
+
+/// marks the complete shadow as unknown
+/// (call this after external code changed GL bindings)
+void invalidate();
+
+/// if enabled, every read or skipped bind is cross-checked against glGet
+/// mismatches are reported and the real GL state is adopted
+/// CAUTION: only available in debug builds (GLOW_DEBUG), no-op otherwise
+void setValidation(bool enabled);
+bool isValidationEnabled();
+
+/// statistics of the current thread
+struct Statistics
+{
+    uint64_t issued = 0;  ///< binds that reached GL
+    uint64_t skipped = 0; ///< redundant binds that were skipped
+    uint64_t queries = 0; ///< glGet queries (unknown state, validation)
+};
+Statistics getStatistics();
+void resetStatistics();
+}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace glow
+{
+class Program;
+
+/// FNV-1a hash of uniform names (constexpr, folded for string literals)
+constexpr uint32_t hashUniformName(char const* s, std::size_t length, uint32_t hash = 2166136261u)
+{
+    return length == 0 ? hash : hashUniformName(s + 1, length - 1, (hash ^ (uint8_t)*s) * 16777619u);
+}
+
+/// length of a uniform name in a char array of size 'size' (up to the first NUL, constexpr)
+constexpr std::size_t uniformNameLength(char const* s, std::size_t size)
+{
+    return size == 0 || *s == '\0' ? 0 : 1 + uniformNameLength(s + 1, size - 1);
+}
+
+/**
+ * @brief Pre-resolved uniform of a given program
+ *
+ * Usage:
+ *   auto hMetallic = program->uniform("uMetallic"); // once
+ *   ...
+ *   shader.setUniform(hMetallic, 0.5f); // no lookup
+ *
+ * Handles stay valid across relinks (location is re-resolved automatically)
+ */
+class UniformHandle
+{
+    Program const* mProgram = nullptr;
+    int mIndex = -1;
+
+    UniformHandle(Program const* program, int index) : mProgram(program), mIndex(index) {}
+    friend class Program;
+
+public:
+    UniformHandle() = default;
+
+    /// false for default-constructed handles
+    bool isValid() const { return mProgram != nullptr; }
+};
+
+/**
+ * @brief Name argument of all uniform functions
+ *
+ * Implicitly constructible from
+ *   - string literals (hash is computed at compile time)
+ *   - char arrays (e.g. snprintf buffers, read up to the first NUL)
+ *   - std::string and char pointers (hash is computed at runtime)
+ *   - UniformHandle (no lookup at all)
+ *
+ * CAUTION: only references the string, never store a UniformName
+ */
+class UniformName
+{
+    char const* mName = nullptr;
+    std::size_t mLength = 0;
+    uint32_t mHash = 0;
+    UniformHandle mHandle;
+
+    friend class Program;
+
+public:
+    template <std::size_t N>
+    constexpr UniformName(char const (&name)[N])
+      : mName(name), mLength(uniformNameLength(name, N)), mHash(hashUniformName(name, uniformNameLength(name, N)))
+    {
+    }
+    /// (template to not win against the literal version)
+    template <typename CharPtrT,
+              typename = typename std::enable_if<!std::is_array<CharPtrT>::value && std::is_convertible<CharPtrT, char const*>::value>::type>
+    UniformName(CharPtrT const& name)
+      : mName(name), mLength(std::char_traits<char>::length(name)), mHash(hashUniformName(mName, mLength))
+    {
+    }
+    UniformName(std::string const& name) : mName(name.c_str()), mLength(name.size()), mHash(hashUniformName(mName, mLength))
+    {
+    }
+    UniformName(UniformHandle const& handle) : mHandle(handle) {}
+
+    /// nullptr for handles
+    char const* getName() const { return mName; }
+    std::size_t getLength() const { return mLength; }
+    uint32_t getHash() const { return mHash; }
+};
+}